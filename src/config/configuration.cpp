@@ -7,8 +7,8 @@
 
 #include "configuration.h"
 
-Configuration::Configuration(int port, int db_connect_nums, int thread_nums, int async)
-    : PORT(port), DB_CONNECT_NUMS(db_connect_nums), THREAD_NUMS(thread_nums), ASYNC_MODE(async) {}
+Configuration::Configuration(int port, int db_connect_nums, int thread_nums, int async, int reactor_nums, int event_backend, int precompress, int timer_type, int db_thread_nums, int db_async, int user_store, int log_level)
+    : PORT(port), DB_CONNECT_NUMS(db_connect_nums), THREAD_NUMS(thread_nums), ASYNC_MODE(async), REACTOR_NUMS(reactor_nums), IO_BACKEND(event_backend), PRECOMPRESS(precompress), TIMER_MODE(timer_type), DB_THREAD_NUMS(db_thread_nums), DB_ASYNC(db_async), USER_STORE(user_store), LOG_LEVEL(log_level) {}
 
 void Configuration::ParseArgs(int argc, char* argv[]) {
     for (int i = 1; i < argc; ++i) {
@@ -18,9 +18,17 @@ void Configuration::ParseArgs(int argc, char* argv[]) {
                 std::cout << "Usage: " << argv[0] << " [options]\n"
                           << "Options:\n"
                           << "  -p[:]<port>                Set the port number (default: 8080)\n"
-                          << "  -l[:]<async_log_mode>      Set the log write mode (0: sync, 1: async)\n"
+                          << "  -l[:]<async_log_mode>      Set the log write mode (0: sync, 1: async, drop when full, 2: async, block when full)\n"
                           << "  -c[:]<db_connect_nums>     Set the number of database connections (default: 8)\n"
                           << "  -t[:]<thread_nums>         Set the number of threads (default: 8)\n"
+                          << "  -r[:]<reactor_nums>        Set the number of sub reactors, 0 for single reactor (default: 0)\n"
+                          << "  -e[:]<event_backend>       Set the event backend (0: epoll, 1: io_uring) (default: 0)\n"
+                          << "  -z[:]<precompress>         Precompress static files at startup (0: off, 1: on) (default: 1)\n"
+                          << "  -w[:]<timer_type>          Set the connection timer (0: heap, 1: timing wheel) (default: 1)\n"
+                          << "  -d[:]<db_thread_nums>      Set the number of threads for database requests (default: 4)\n"
+                          << "  -a[:]<db_async>            Set the database mode (0: executor threads, 1: nonblocking) (default: 1)\n"
+                          << "  -s[:]<user_store>          Set the user store (0: mysql, 1: local mmap) (default: 0)\n"
+                          << "  -v[:]<log_level>           Set the log level (0: debug, 1: info, 2: warn, 3: error) (default: 0)\n"
                           << "  -h                         Show help\n";
                 exit(0);
             }
@@ -46,8 +54,8 @@ void Configuration::ParseArgs(int argc, char* argv[]) {
                     PORT = std::atoi(value);
                     break;
                 case 'l':
-                    if (value == nullptr || (std::atoi(value) != 0 && std::atoi(value) != 1)) {
-                        std::cerr << "[ERROR]: Option -l requires a valid async log mode (0 or 1).\n";
+                    if (value == nullptr || std::atoi(value) < 0 || std::atoi(value) > 2) {
+                        std::cerr << "[ERROR]: Option -l requires a valid async log mode (0, 1 or 2).\n";
                         exit(1);
                     }
                     ASYNC_MODE = std::atoi(value);
@@ -66,6 +74,62 @@ void Configuration::ParseArgs(int argc, char* argv[]) {
                     }
                     THREAD_NUMS = std::atoi(value);
                     break;
+                case 'r':
+                    if (value == nullptr || !std::isdigit(value[0])) {
+                        std::cerr << "[ERROR]: Option -r requires a valid number of reactors.\n";
+                        exit(1);
+                    }
+                    REACTOR_NUMS = std::atoi(value);
+                    break;
+                case 'e':
+                    if (value == nullptr || (std::atoi(value) != 0 && std::atoi(value) != 1)) {
+                        std::cerr << "[ERROR]: Option -e requires a valid event backend (0 or 1).\n";
+                        exit(1);
+                    }
+                    IO_BACKEND = std::atoi(value);
+                    break;
+                case 'z':
+                    if (value == nullptr || (std::atoi(value) != 0 && std::atoi(value) != 1)) {
+                        std::cerr << "[ERROR]: Option -z requires a valid precompress mode (0 or 1).\n";
+                        exit(1);
+                    }
+                    PRECOMPRESS = std::atoi(value);
+                    break;
+                case 'w':
+                    if (value == nullptr || (std::atoi(value) != 0 && std::atoi(value) != 1)) {
+                        std::cerr << "[ERROR]: Option -w requires a valid timer type (0 or 1).\n";
+                        exit(1);
+                    }
+                    TIMER_MODE = std::atoi(value);
+                    break;
+                case 'd':
+                    if (value == nullptr || !std::isdigit(value[0]) || std::atoi(value) <= 0) {
+                        std::cerr << "[ERROR]: Option -d requires a valid number of database threads.\n";
+                        exit(1);
+                    }
+                    DB_THREAD_NUMS = std::atoi(value);
+                    break;
+                case 'a':
+                    if (value == nullptr || (std::atoi(value) != 0 && std::atoi(value) != 1)) {
+                        std::cerr << "[ERROR]: Option -a requires a valid database mode (0 or 1).\n";
+                        exit(1);
+                    }
+                    DB_ASYNC = std::atoi(value);
+                    break;
+                case 's':
+                    if (value == nullptr || (std::atoi(value) != 0 && std::atoi(value) != 1)) {
+                        std::cerr << "[ERROR]: Option -s requires a valid user store (0 or 1).\n";
+                        exit(1);
+                    }
+                    USER_STORE = std::atoi(value);
+                    break;
+                case 'v':
+                    if (value == nullptr || !std::isdigit(value[0]) || std::atoi(value) > 3) {
+                        std::cerr << "[ERROR]: Option -v requires a valid log level (0, 1, 2 or 3).\n";
+                        exit(1);
+                    }
+                    LOG_LEVEL = std::atoi(value);
+                    break;
                 default:
                     std::cerr << "[ERROR]: Unknown option: -" << option << ". Use -h for help.\n";
                     exit(1);
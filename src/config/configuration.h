@@ -14,7 +14,7 @@
 
 class Configuration {
 public:
-    Configuration(int port = 8080, int db_connect_nums = 8, int thread_nums = 8, int async = 1);
+    Configuration(int port = 8080, int db_connect_nums = 8, int thread_nums = 8, int async = 1, int reactor_nums = 0, int event_backend = 0, int precompress = 1, int timer_type = 1, int db_thread_nums = 4, int db_async = 1, int user_store = 0, int log_level = 0);
     ~Configuration() = default;
 
     void ParseArgs(int argc, char* argv[]);
@@ -22,7 +22,15 @@ public:
     int PORT;                       // -p: 端口号
     int DB_CONNECT_NUMS;            // -c: 数据库连接池数量
     int THREAD_NUMS;                // -t: 线程池内线程数量
-    int ASYNC_MODE;                // -l: 日志写入模式，0:同步，1:异步
+    int ASYNC_MODE;                 // -l: 日志写入模式，0:同步，1:异步(队列满时丢弃)，2:异步(队列满时等待)
+    int REACTOR_NUMS;               // -r: 从Reactor数量，0:单Reactor+线程池模式
+    int IO_BACKEND;                 // -e: 事件后端，0:epoll，1:io_uring
+    int PRECOMPRESS;                // -z: 启动时预压缩静态资源，0:关闭，1:开启
+    int TIMER_MODE;                 // -w: 连接超时定时器，0:小顶堆，1:时间轮
+    int DB_THREAD_NUMS;             // -d: 数据库线程数量(执行器线程或异步事件循环线程)
+    int DB_ASYNC;                   // -a: 数据库访问模式，0:同步执行器，1:非阻塞异步
+    int USER_STORE;                 // -s: 用户存储，0:MySQL，1:本地内存映射存储
+    int LOG_LEVEL;                  // -v: 日志级别，0:DEBUG，1:INFO，2:WARN，3:ERROR
 };
 
 #endif
\ No newline at end of file
@@ -7,7 +7,7 @@
 
 #include "epoll.h"
 
-Epoll::Epoll(int max_event_nums): epoll_fd_(epoll_create1(0)), events_(max_event_nums) {
+Epoll::Epoll(int max_event_nums): epoll_fd_(epoll_create1(0)), events_(max_event_nums), syscall_cnt_(0) {
     if (epoll_fd_ < 0) {
         LOG_ERROR("Epoll: Failed to create epoll instance, Error: %d.", errno);
         throw std::runtime_error("Epoll: Failed to create epoll instance.");    
@@ -24,7 +24,7 @@ Epoll::~Epoll() {
     close(epoll_fd_);
 }
 
-bool Epoll::AddFd(int fd, uint32_t event) {
+bool Epoll::AddFd(int fd, uint32_t event, uint64_t data) {
     if (fd < 0) {
         // 文件描述符无效，直接返回 false
         LOG_ERROR("Epoll: Invalid fd: %d.", fd);
@@ -33,9 +33,10 @@ bool Epoll::AddFd(int fd, uint32_t event) {
 
     struct epoll_event ev = {0};
     ev.events = event;
-    ev.data.fd = fd;
+    ev.data.u64 = data;
 
     // 使用 epoll_ctl 添加文件描述符
+    syscall_cnt_.fetch_add(1, std::memory_order_relaxed);
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) == -1) {
         if (errno == EEXIST) {
             // 如果文件描述符已经存在，尝试使用 EPOLL_CTL_MOD 修改事件
@@ -53,16 +54,17 @@ bool Epoll::AddFd(int fd, uint32_t event) {
 }
 
 
-bool Epoll::ModifyFd(int fd, uint32_t events) {
+bool Epoll::ModifyFd(int fd, uint32_t events, uint64_t data) {
     if (fd < 0) {
         LOG_ERROR("Epoll: Invalid fd for modification: %d.", fd);
         return false;
     }
 
     struct epoll_event ev = {0};
-    ev.data.fd = fd;
+    ev.data.u64 = data;
     ev.events = events;
 
+    syscall_cnt_.fetch_add(1, std::memory_order_relaxed);
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) == -1) {
         LOG_ERROR("Epoll: Failed to modify fd: %d, Error: %d.", fd, errno);
         return false;
@@ -79,6 +81,7 @@ bool Epoll::DeleteFd(int fd) {
     struct epoll_event ev = {0};  // 初始化事件
     ev.data.fd = fd;
 
+    syscall_cnt_.fetch_add(1, std::memory_order_relaxed);
     if (epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev) == -1) {
         LOG_ERROR("Epoll: Failed to delete fd: %d, Error: %d.", fd, errno);
         return false;
@@ -95,6 +98,7 @@ int Epoll::EpollWait(int timeoutMs) {
     // if (nfds == -1) {
     //     LOG_ERROR("Epoll: epoll_wait failed, Error: %d.", errno);
     // }
+    syscall_cnt_.fetch_add(1, std::memory_order_relaxed);
     int nfds = epoll_wait(epoll_fd_, events_.data(), static_cast<int>(events_.size()), timeoutMs);
     if (nfds == -1) {
         LOG_WARN("Epoll: epoll_wait with nothing, errno: %d.", errno);
@@ -109,9 +113,24 @@ int Epoll::GetEventFd(size_t idx) const {
     return events_[idx].data.fd;
 }
 
+uint64_t Epoll::GetEventData(size_t idx) const {
+    if (idx >= events_.size()) {
+        LOG_ERROR("Epoll: Attempt to get invalid data: %zu.", idx);
+    }
+    return events_[idx].data.u64;
+}
+
 uint32_t Epoll::GetEvents(size_t idx) const {
     if (idx < 0 || idx >= events_.size()) {
         LOG_ERROR("Epoll: Attempt to get in valid fd: %zu 's event.")
     }
     return events_[idx].events;
-}
\ No newline at end of file
+}
+
+uint64_t Epoll::GetSyscallCount() const {
+    return syscall_cnt_.load(std::memory_order_relaxed);
+}
+
+const char* Epoll::GetName() const {
+    return "epoll";
+}
@@ -9,29 +9,38 @@
 #define EPOLL_H
 
 #include "../log/log.h"
+#include "event_backend.h"
 
 #include <vector>
 #include <sys/epoll.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <atomic>
 
 // 将epoll实例封装为一个类
-class Epoll {
+class Epoll : public EventBackend {
 public:
     explicit Epoll(int max_event_nums = 1024);
-    ~Epoll();
+    ~Epoll() override;
 
-    bool AddFd(int fd, uint32_t event);                 // 添加事件描述符
-    bool ModifyFd(int fd, uint32_t event);              // 修改事件描述符
-    bool DeleteFd(int fd);                              // 删除事件描述符
-    int EpollWait(int timeoutMs = -1);                  // 等待事件事件
-    int GetEventFd(size_t idx) const;                   // 获取事件描述符
-    uint32_t GetEvents(size_t idx) const;               // 获取监听事件
+    using EventBackend::AddFd;
+    using EventBackend::ModifyFd;
+
+    bool AddFd(int fd, uint32_t event, uint64_t data) override;     // 添加事件描述符
+    bool ModifyFd(int fd, uint32_t event, uint64_t data) override;  // 修改事件描述符
+    bool DeleteFd(int fd) override;                     // 删除事件描述符
+    int EpollWait(int timeoutMs = -1) override;         // 等待事件事件
+    int GetEventFd(size_t idx) const override;          // 获取事件描述符
+    uint64_t GetEventData(size_t idx) const override;   // 获取事件绑定的用户数据
+    uint32_t GetEvents(size_t idx) const override;      // 获取监听事件
+    uint64_t GetSyscallCount() const override;          // 累计系统调用次数
+    const char* GetName() const override;               // 后端名称
 
 private:
     int epoll_fd_;                                      // epoll实例描述符
     std::vector<struct epoll_event> events_;            // 监听事件数组
+    std::atomic<uint64_t> syscall_cnt_;                 // epoll_ctl与epoll_wait调用次数
 };
 
 #endif
\ No newline at end of file
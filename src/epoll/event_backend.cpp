@@ -0,0 +1,20 @@
+/**
+ * @file event_backend.cpp
+ * @author chenyinjie
+ * @date 2024-10-22
+ * @copyright Apache 2.0
+ */
+
+#include "event_backend.h"
+#include "epoll.h"
+#include "uring.h"
+
+std::unique_ptr<EventBackend> CreateEventBackend(EVENT_BACKEND type, int max_event_nums) {
+    switch (type) {
+        case EVENT_BACKEND::IO_URING:
+            return std::make_unique<IOUring>(max_event_nums);
+        case EVENT_BACKEND::EPOLL:
+        default:
+            return std::make_unique<Epoll>(max_event_nums);
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * @file event_backend.h
+ * @author chenyinjie
+ * @date 2024-10-22
+ * @copyright Apache 2.0
+ */
+
+#ifndef EVENT_BACKEND_H
+#define EVENT_BACKEND_H
+
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+#include <sys/epoll.h>
+
+/**
+ * @brief
+ * 事件后端类型
+ * EPOLL: epoll_ctl/epoll_wait
+ * IO_URING: io_uring poll请求，注册与修改批量提交，与等待合并为一次io_uring_enter
+ */
+enum class EVENT_BACKEND {
+    EPOLL = 0,
+    IO_URING = 1
+};
+
+/**
+ * @brief
+ * I/O事件后端公共接口
+ * 统一使用epoll语义的事件标志(EPOLLIN/EPOLLOUT/EPOLLRDHUP/EPOLLET/EPOLLONESHOT)，
+ * 服务器与从Reactor只依赖该接口，可在epoll与io_uring之间切换。
+ * 每个注册可绑定64位用户数据(对应epoll_event.data)，不指定时为fd本身，此时可用GetEventFd取回。
+ */
+class EventBackend {
+public:
+    virtual ~EventBackend() = default;
+
+    virtual bool AddFd(int fd, uint32_t event, uint64_t data) = 0;      // 添加事件描述符并绑定用户数据
+    virtual bool ModifyFd(int fd, uint32_t event, uint64_t data) = 0;   // 修改事件描述符并绑定用户数据
+    virtual bool DeleteFd(int fd) = 0;                              // 删除事件描述符
+    virtual int EpollWait(int timeoutMs = -1) = 0;                  // 等待事件
+    virtual int GetEventFd(size_t idx) const = 0;                   // 获取事件描述符(用户数据为fd时)
+    virtual uint64_t GetEventData(size_t idx) const = 0;            // 获取事件绑定的用户数据
+    virtual uint32_t GetEvents(size_t idx) const = 0;               // 获取监听事件
+    virtual uint64_t GetSyscallCount() const = 0;                   // 累计系统调用次数
+    virtual const char* GetName() const = 0;                        // 后端名称
+
+    bool AddFd(int fd, uint32_t event) { return AddFd(fd, event, static_cast<uint64_t>(fd)); }
+    bool ModifyFd(int fd, uint32_t event) { return ModifyFd(fd, event, static_cast<uint64_t>(fd)); }
+};
+
+// 创建指定类型的事件后端，失败时抛出异常
+std::unique_ptr<EventBackend> CreateEventBackend(EVENT_BACKEND type, int max_event_nums = 1024);
+
+#endif
@@ -0,0 +1,306 @@
+/**
+ * @file uring.cpp
+ * @author chenyinjie
+ * @date 2024-10-22
+ * @copyright Apache 2.0
+ */
+
+#include "uring.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <chrono>
+
+IOUring::IOUring(int max_event_nums, unsigned entries)
+    : ring_fd_(-1), sq_entries_(0),
+      sq_head_(nullptr), sq_tail_(nullptr), sq_mask_(nullptr), sq_array_(nullptr), sqes_(nullptr),
+      cq_head_(nullptr), cq_tail_(nullptr), cq_mask_(nullptr), cqes_(nullptr),
+      sq_ptr_(MAP_FAILED), cq_ptr_(MAP_FAILED), sq_map_size_(0), cq_map_size_(0), sqes_map_size_(0),
+      pending_(0), is_waiting_(false), events_(max_event_nums), syscall_cnt_(0) {
+    if (events_.size() == 0) {
+        LOG_ERROR("IOUring: Invalid event vector size.");
+        throw std::runtime_error("IOUring: Invalid event vector size.");
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (ring_fd_ < 0) {
+        LOG_ERROR("IOUring: Failed to create io_uring instance, Error: %d.", errno);
+        throw std::runtime_error("IOUring: Failed to create io_uring instance.");
+    }
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        close(ring_fd_);
+        LOG_ERROR("IOUring: Kernel does not support IORING_FEAT_EXT_ARG.");
+        throw std::runtime_error("IOUring: Kernel does not support IORING_FEAT_EXT_ARG.");
+    }
+
+    sq_entries_ = params.sq_entries;
+    sq_map_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_map_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool is_single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (is_single_mmap) {
+        sq_map_size_ = cq_map_size_ = std::max(sq_map_size_, cq_map_size_);
+    }
+
+    sq_ptr_ = mmap(nullptr, sq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    cq_ptr_ = is_single_mmap ? sq_ptr_ :
+              mmap(nullptr, cq_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_CQ_RING);
+    sqes_map_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes_ptr = mmap(nullptr, sqes_map_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sq_ptr_ == MAP_FAILED || cq_ptr_ == MAP_FAILED || sqes_ptr == MAP_FAILED) {
+        LOG_ERROR("IOUring: Failed to map rings, Error: %d.", errno);
+        if (sqes_ptr != MAP_FAILED) munmap(sqes_ptr, sqes_map_size_);
+        if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_map_size_);
+        if (sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_map_size_);
+        close(ring_fd_);
+        throw std::runtime_error("IOUring: Failed to map rings.");
+    }
+
+    char* sq = static_cast<char*>(sq_ptr_);
+    sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqes_ = static_cast<struct io_uring_sqe*>(sqes_ptr);
+
+    char* cq = static_cast<char*>(cq_ptr_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    LOG_INFO("IOUring: init io_uring success, sq entries: %u, cq entries: %u.", params.sq_entries, params.cq_entries);
+}
+
+IOUring::~IOUring() {
+    if (sqes_) munmap(sqes_, sqes_map_size_);
+    if (cq_ptr_ != MAP_FAILED && cq_ptr_ != sq_ptr_) munmap(cq_ptr_, cq_map_size_);
+    if (sq_ptr_ != MAP_FAILED) munmap(sq_ptr_, sq_map_size_);
+    if (ring_fd_ >= 0) close(ring_fd_);
+}
+
+bool IOUring::AddFd(int fd, uint32_t event, uint64_t data) {
+    if (fd < 0) {
+        LOG_ERROR("IOUring: Invalid fd: %d.", fd);
+        return false;
+    }
+    std::lock_guard<std::mutex> locker(ring_mtx_);
+    if (static_cast<size_t>(fd) >= fds_.size()) {
+        fds_.resize(fd + 1);
+    }
+    FdState& state = fds_[fd];
+    // 与Epoll::AddFd一致，重复添加时按修改处理
+    CancelPoll(fd);
+    state.events = event;
+    state.data = data;
+    state.is_registered = true;
+    ArmPoll(fd);
+    FlushIfWaiting();
+    return true;
+}
+
+bool IOUring::ModifyFd(int fd, uint32_t event, uint64_t data) {
+    std::lock_guard<std::mutex> locker(ring_mtx_);
+    if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].is_registered) {
+        LOG_ERROR("IOUring: Failed to modify unregistered fd: %d.", fd);
+        return false;
+    }
+    CancelPoll(fd);
+    fds_[fd].events = event;
+    fds_[fd].data = data;
+    ArmPoll(fd);
+    FlushIfWaiting();
+    return true;
+}
+
+bool IOUring::DeleteFd(int fd) {
+    std::lock_guard<std::mutex> locker(ring_mtx_);
+    if (fd < 0 || static_cast<size_t>(fd) >= fds_.size() || !fds_[fd].is_registered) {
+        LOG_ERROR("IOUring: Failed to delete unregistered fd: %d.", fd);
+        return false;
+    }
+    CancelPoll(fd);
+    fds_[fd].is_registered = false;
+    fds_[fd].gen++;
+    FlushIfWaiting();
+    return true;
+}
+
+int IOUring::EpollWait(int timeoutMs) {
+    // 内部请求(POLL_REMOVE)与被取消的poll也会产生完成事件，没有有效事件时在剩余时间内继续等待
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeoutMs, 0));
+    while (true) {
+        unsigned to_submit = 0;
+        bool is_wait = false;
+        {
+            std::lock_guard<std::mutex> locker(ring_mtx_);
+            for (int fd : rearm_fds_) {
+                if (fds_[fd].is_registered && !fds_[fd].is_armed) ArmPoll(fd);
+            }
+            rearm_fds_.clear();
+            to_submit = pending_;
+            pending_ = 0;
+            bool is_cq_ready = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE) != *cq_head_;
+            is_wait = !is_cq_ready && timeoutMs != 0;
+            is_waiting_ = is_wait;
+        }
+
+        // 积压的注册请求与等待合并为一次系统调用；完成队列已有事件时不进入内核等待
+        int wait_ms = timeoutMs;
+        if (timeoutMs > 0) {
+            auto remain = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+            wait_ms = static_cast<int>(std::max<long long>(remain, 1));
+        }
+        bool is_interrupted = false;
+        if (to_submit > 0 || is_wait) {
+            int ret = Enter(to_submit, is_wait ? 1 : 0, is_wait ? IORING_ENTER_GETEVENTS : 0, wait_ms);
+            if (ret < 0) {
+                is_interrupted = (errno == EINTR);
+                if (errno != ETIME && errno != EINTR) {
+                    LOG_WARN("IOUring: io_uring_enter failed, errno: %d.", errno);
+                }
+            }
+        }
+
+        int cnt = ReapEvents();
+        if (cnt > 0 || timeoutMs == 0 || is_interrupted) return cnt;
+        if (timeoutMs > 0 && std::chrono::steady_clock::now() >= deadline) return 0;
+    }
+}
+
+int IOUring::ReapEvents() {
+    std::lock_guard<std::mutex> locker(ring_mtx_);
+    is_waiting_ = false;
+    int cnt = 0;
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    while (head != tail && static_cast<size_t>(cnt) < events_.size()) {
+        const struct io_uring_cqe* cqe = &cqes_[head & *cq_mask_];
+        uint64_t user_data = cqe->user_data;
+        if (user_data != INTERNAL_USER_DATA) {
+            int fd = static_cast<int>(user_data & 0xffffffffULL);
+            uint32_t gen = static_cast<uint32_t>(user_data >> 32);
+            if (static_cast<size_t>(fd) < fds_.size() && fds_[fd].is_registered && fds_[fd].gen == gen) {
+                FdState& state = fds_[fd];
+                if (!(cqe->flags & IORING_CQE_F_MORE)) {
+                    state.is_armed = false;
+                    // 非EPOLLONESHOT注册在poll请求结束后需要重新提交(水平触发或multishot被内核终止)
+                    if (!(state.events & EPOLLONESHOT)) rearm_fds_.push_back(fd);
+                }
+                if (cqe->res != -ECANCELED) {
+                    events_[cnt].data.u64 = state.data;
+                    events_[cnt].events = cqe->res < 0 ? EPOLLERR : static_cast<uint32_t>(cqe->res);
+                    cnt++;
+                }
+            }
+        }
+        head++;
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return cnt;
+}
+
+int IOUring::GetEventFd(size_t idx) const {
+    if (idx >= events_.size()) {
+        LOG_ERROR("IOUring: Attempt to get invalid fd: %zu.", idx);
+    }
+    return events_[idx].data.fd;
+}
+
+uint64_t IOUring::GetEventData(size_t idx) const {
+    if (idx >= events_.size()) {
+        LOG_ERROR("IOUring: Attempt to get invalid data: %zu.", idx);
+    }
+    return events_[idx].data.u64;
+}
+
+uint32_t IOUring::GetEvents(size_t idx) const {
+    if (idx >= events_.size()) {
+        LOG_ERROR("IOUring: Attempt to get invalid event: %zu.", idx);
+    }
+    return events_[idx].events;
+}
+
+uint64_t IOUring::GetSyscallCount() const {
+    return syscall_cnt_.load(std::memory_order_relaxed);
+}
+
+const char* IOUring::GetName() const {
+    return "io_uring";
+}
+
+struct io_uring_sqe* IOUring::GetSqe() {
+    unsigned tail = *sq_tail_;
+    if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+        // 提交队列已满，先将积压的请求提交给内核
+        Enter(pending_, 0, 0, 0);
+        pending_ = 0;
+        if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= sq_entries_) {
+            return nullptr;
+        }
+    }
+    unsigned idx = tail & *sq_mask_;
+    struct io_uring_sqe* sqe = &sqes_[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array_[idx] = idx;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    pending_++;
+    return sqe;
+}
+
+void IOUring::ArmPoll(int fd) {
+    FdState& state = fds_[fd];
+    struct io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        LOG_ERROR("IOUring: Submission queue is full, failed to arm fd: %d.", fd);
+        return;
+    }
+    state.gen++;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = state.events & ~(EPOLLET | EPOLLONESHOT | EPOLLEXCLUSIVE | EPOLLWAKEUP);
+    if ((state.events & EPOLLET) && !(state.events & EPOLLONESHOT)) {
+        sqe->len = IORING_POLL_ADD_MULTI;
+    }
+    sqe->user_data = (static_cast<uint64_t>(state.gen) << 32) | static_cast<uint32_t>(fd);
+    state.is_armed = true;
+}
+
+void IOUring::CancelPoll(int fd) {
+    FdState& state = fds_[fd];
+    if (!state.is_armed) return;
+    struct io_uring_sqe* sqe = GetSqe();
+    if (sqe == nullptr) {
+        LOG_ERROR("IOUring: Submission queue is full, failed to cancel fd: %d.", fd);
+        return;
+    }
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (static_cast<uint64_t>(state.gen) << 32) | static_cast<uint32_t>(fd);
+    sqe->user_data = INTERNAL_USER_DATA;
+    state.is_armed = false;
+}
+
+int IOUring::Enter(unsigned to_submit, unsigned min_complete, unsigned flags, int timeoutMs) {
+    syscall_cnt_.fetch_add(1, std::memory_order_relaxed);
+    if ((flags & IORING_ENTER_GETEVENTS) && timeoutMs > 0) {
+        struct __kernel_timespec ts;
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = static_cast<long long>(timeoutMs % 1000) * 1000000;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = reinterpret_cast<uint64_t>(&ts);
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                                        flags | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+    }
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete, flags, nullptr, 0));
+}
+
+void IOUring::FlushIfWaiting() {
+    // 调用方持有ring_mtx_；等待线程已经阻塞在内核中，不能依赖其下一次等待提交
+    if (is_waiting_ && pending_ > 0) {
+        Enter(pending_, 0, 0, 0);
+        pending_ = 0;
+    }
+}
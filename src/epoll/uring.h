@@ -0,0 +1,102 @@
+/**
+ * @file uring.h
+ * @author chenyinjie
+ * @date 2024-10-22
+ * @copyright Apache 2.0
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include "../log/log.h"
+#include "event_backend.h"
+
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+/**
+ * @brief
+ * 基于io_uring poll请求的事件后端
+ * - 只提供就绪通知(IORING_OP_POLL_ADD)，不提交读写请求，数据仍由调用方通过read/write收发。
+ * - 直接使用io_uring_setup/io_uring_enter系统调用，不依赖liburing。
+ * - AddFd/ModifyFd/DeleteFd只向提交队列写入SQE，在下一次EpollWait时与等待合并为一次io_uring_enter提交，
+ *   省去每次重新注册的epoll_ctl调用；若此时有线程阻塞在等待中，则立即提交，保证线程池模式下的重新注册不被延迟。
+ * - EPOLLET映射为多次触发(multishot)poll，EPOLLONESHOT映射为单次poll，水平触发使用单次poll并在下次等待前自动重新注册。
+ * - user_data由文件描述符与注册代数组成，修改或删除后旧poll请求产生的完成事件会被丢弃。
+ */
+
+class IOUring : public EventBackend {
+public:
+    explicit IOUring(int max_event_nums = 1024, unsigned entries = 4096);
+    ~IOUring() override;
+
+    IOUring(const IOUring&) = delete;
+    IOUring& operator=(const IOUring&) = delete;
+
+    using EventBackend::AddFd;
+    using EventBackend::ModifyFd;
+
+    bool AddFd(int fd, uint32_t event, uint64_t data) override;     // 添加事件描述符
+    bool ModifyFd(int fd, uint32_t event, uint64_t data) override;  // 修改事件描述符
+    bool DeleteFd(int fd) override;                     // 删除事件描述符
+    int EpollWait(int timeoutMs = -1) override;         // 提交积压的SQE并等待事件
+    int GetEventFd(size_t idx) const override;          // 获取事件描述符
+    uint64_t GetEventData(size_t idx) const override;   // 获取事件绑定的用户数据
+    uint32_t GetEvents(size_t idx) const override;      // 获取监听事件
+    uint64_t GetSyscallCount() const override;          // 累计io_uring_enter调用次数
+    const char* GetName() const override;               // 后端名称
+
+private:
+    // 每个文件描述符的注册状态
+    struct FdState {
+        uint32_t events = 0;                            // 注册的epoll事件标志
+        uint64_t data = 0;                              // 绑定的用户数据
+        uint32_t gen = 0;                               // 注册代数，每次重新注册或删除时递增
+        bool is_registered = false;                     // 是否处于注册状态
+        bool is_armed = false;                          // 内核中是否存在有效的poll请求
+    };
+
+    static constexpr uint64_t INTERNAL_USER_DATA = ~0ULL;    // 内部请求(POLL_REMOVE)的user_data
+
+    struct io_uring_sqe* GetSqe();                      // 获取空闲SQE，队列满时先提交
+    void ArmPoll(int fd);                               // 为fd提交poll请求
+    void CancelPoll(int fd);                            // 取消fd当前的poll请求
+    int Enter(unsigned to_submit, unsigned min_complete, unsigned flags, int timeoutMs);
+    void FlushIfWaiting();                              // 等待线程阻塞时立即提交积压的SQE
+    int ReapEvents();                                   // 将完成事件转换为epoll事件
+
+    int ring_fd_;                                       // io_uring实例描述符
+    unsigned sq_entries_;                               // 提交队列大小
+    unsigned* sq_head_;
+    unsigned* sq_tail_;
+    unsigned* sq_mask_;
+    unsigned* sq_array_;
+    struct io_uring_sqe* sqes_;
+    unsigned* cq_head_;
+    unsigned* cq_tail_;
+    unsigned* cq_mask_;
+    struct io_uring_cqe* cqes_;
+
+    void* sq_ptr_;                                      // SQ环映射地址
+    void* cq_ptr_;                                      // CQ环映射地址
+    size_t sq_map_size_;
+    size_t cq_map_size_;
+    size_t sqes_map_size_;
+
+    std::mutex ring_mtx_;                               // 保护提交队列与fd状态
+    unsigned pending_;                                  // 已写入但尚未提交的SQE数量
+    bool is_waiting_;                                   // 是否有线程阻塞在io_uring_enter中
+    std::vector<FdState> fds_;                          // 以fd为下标的注册状态
+    std::vector<int> rearm_fds_;                        // 下次等待前需要重新注册的fd
+
+    std::vector<struct epoll_event> events_;            // 就绪事件数组
+    std::atomic<uint64_t> syscall_cnt_;                 // io_uring_enter调用次数
+};
+
+#endif
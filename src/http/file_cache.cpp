@@ -0,0 +1,343 @@
+/**
+ * @file file_cache.cpp
+ * @author chenyinjie
+ * @date 2024-10-28
+ * @copyright Apache 2.0
+ */
+
+#include "file_cache.h"
+#include "http_response.h"
+
+FileEntry::~FileEntry() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+FileCache::FileCache()
+    : is_enabled_(false), max_entries_(0), max_bytes_(0),
+      hit_cnt_(0), miss_cnt_(0), inotify_fd_(-1), wakeup_fd_(-1) {}
+
+FileCache::~FileCache() {
+    Close();
+}
+
+FileCache& FileCache::GetFileCacheInstance() {
+    static FileCache instance;
+    return instance;
+}
+
+/**
+ * @brief
+ * 从文件系统加载缓存项：stat、打开可读的普通文件、生成首部字段
+ */
+std::shared_ptr<const FileEntry> FileCache::Load(const std::string& path) {
+    auto entry = std::make_shared<FileEntry>();
+    entry->load_time = std::chrono::steady_clock::now();
+    if (stat(path.c_str(), &entry->st) < 0) {
+        return entry;
+    }
+    entry->is_exist = true;
+    entry->mime = HTTPResponse::GetMimeType(path);
+    entry->header = "Content-Type: " + entry->mime + "\r\n"
+                  + "Content-Length: " + std::to_string(entry->st.st_size) + "\r\n";
+
+    char etag[64];
+    uint64_t mtime_ns = static_cast<uint64_t>(entry->st.st_mtim.tv_sec) * 1000000000ULL + entry->st.st_mtim.tv_nsec;
+    snprintf(etag, sizeof(etag), "\"%lx-%lx-%lx\"", static_cast<unsigned long>(entry->st.st_ino),
+             static_cast<unsigned long>(entry->st.st_size), static_cast<unsigned long>(mtime_ns));
+    entry->etag = etag;
+    entry->last_modified = HTTPResponse::FormatHttpDate(entry->st.st_mtime);
+    entry->validator = "ETag: " + entry->etag + "\r\n"
+                     + "Last-Modified: " + entry->last_modified + "\r\n";
+
+    if (!S_ISREG(entry->st.st_mode) || !(entry->st.st_mode & S_IROTH) || entry->st.st_size == 0) {
+        return entry;
+    }
+    entry->fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (entry->fd < 0) {
+        LOG_ERROR("FileCache: Failed to open file %s, Error: %d.", path.c_str(), errno);
+    }
+    return entry;
+}
+
+bool FileCache::Init(const std::string& root, size_t max_entries, size_t max_bytes, size_t shard_nums) {
+    Close();
+    if (shard_nums == 0 || max_entries < shard_nums) {
+        LOG_ERROR("FileCache: Invalid cache size, entries: %zu, shards: %zu.", max_entries, shard_nums);
+        return false;
+    }
+
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && max_entries > limit.rlim_cur / 4) {
+        max_entries = std::max<size_t>(limit.rlim_cur / 4, shard_nums);
+        LOG_WARN("FileCache: max entries limited to %zu by RLIMIT_NOFILE %zu.", max_entries, static_cast<size_t>(limit.rlim_cur));
+    }
+
+    shards_.clear();
+    for (size_t i = 0; i < shard_nums; ++i) {
+        shards_.emplace_back(std::make_unique<Shard>());
+    }
+    max_entries_ = max_entries / shard_nums;
+    max_bytes_ = max_bytes / shard_nums;
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify_fd_ < 0 || wakeup_fd_ < 0) {
+        LOG_ERROR("FileCache: Failed to create inotify instance, Error: %d.", errno);
+        Close();
+        return false;
+    }
+    // 监听目录不带结尾的'/'，事件路径dir + "/" + name与规范化后的缓存键一致
+    std::string dir = NormalizePath(root);
+    if (dir.size() > 1 && dir.back() == '/') dir.pop_back();
+    AddWatch(dir);
+    watch_thread_ = std::thread(&FileCache::WatchWorker, this);
+
+    is_enabled_ = true;
+    LOG_INFO("FileCache: init success, root: %s, max entries: %zu, max bytes: %zu, shards: %zu.",
+             root.c_str(), max_entries, max_bytes, shard_nums);
+    return true;
+}
+
+void FileCache::Close() {
+    is_enabled_ = false;
+    if (watch_thread_.joinable()) {
+        uint64_t one = 1;
+        if (write(wakeup_fd_, &one, sizeof(one)) < 0) {
+            LOG_WARN("FileCache: Failed to wake up watch thread, Error: %d.", errno);
+        }
+        watch_thread_.join();
+    }
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if (wakeup_fd_ >= 0) {
+        close(wakeup_fd_);
+        wakeup_fd_ = -1;
+    }
+    {
+        std::lock_guard<std::mutex> locker(watch_mtx_);
+        wd_dirs_.clear();
+    }
+    Clear();
+}
+
+/**
+ * @brief
+ * 获取缓存项，未命中时在分片锁外加载文件，避免阻塞同一分片的其他请求
+ * 同一文件的不同写法(如"/a/../b"、"//b")对应同一缓存项，文件变化时一并失效
+ */
+std::shared_ptr<const FileEntry> FileCache::Get(const std::string& raw_path) {
+    if (!is_enabled_) {
+        return Load(raw_path);
+    }
+    std::string path = NormalizePath(raw_path);
+
+    Shard& shard = GetShard(path);
+    uint64_t gen = 0;
+    {
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        auto iter = shard.index.find(path);
+        if (iter != shard.index.end()) {
+            auto& entry = iter->second->second;
+            bool is_expired = !entry->is_exist &&
+                std::chrono::steady_clock::now() - entry->load_time > std::chrono::milliseconds(NEGATIVE_TTL_MS);
+            if (!is_expired) {
+                shard.lru.splice(shard.lru.begin(), shard.lru, iter->second);
+                hit_cnt_.fetch_add(1, std::memory_order_relaxed);
+                return entry;
+            }
+            EraseLocked(shard, iter->second);
+        }
+        gen = shard.gen;
+    }
+
+    miss_cnt_.fetch_add(1, std::memory_order_relaxed);
+    std::shared_ptr<const FileEntry> entry = Load(path);
+    size_t bytes = EntryBytes(*entry);
+    if (bytes > max_bytes_) {
+        // 超过分片容量的大文件不缓存
+        return entry;
+    }
+
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    if (shard.gen != gen) {
+        // 加载期间发生了失效，加载结果可能已过期，不放入缓存
+        return entry;
+    }
+    auto iter = shard.index.find(path);
+    if (iter != shard.index.end()) {
+        // 其他线程已加载
+        return iter->second->second;
+    }
+    shard.lru.emplace_front(path, entry);
+    shard.index[path] = shard.lru.begin();
+    shard.bytes += bytes;
+    while (shard.lru.size() > max_entries_ || shard.bytes > max_bytes_) {
+        EraseLocked(shard, std::prev(shard.lru.end()));
+    }
+    return entry;
+}
+
+std::string FileCache::NormalizePath(const std::string& path) {
+    return std::filesystem::path(path).lexically_normal().string();
+}
+
+void FileCache::Invalidate(const std::string& path) {
+    if (shards_.empty()) return;
+    Shard& shard = GetShard(path);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    shard.gen++;
+    auto iter = shard.index.find(path);
+    if (iter != shard.index.end()) {
+        EraseLocked(shard, iter->second);
+    }
+}
+
+void FileCache::InvalidatePrefix(const std::string& prefix) {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> locker(shard->mtx);
+        shard->gen++;
+        for (auto iter = shard->lru.begin(); iter != shard->lru.end();) {
+            auto cur = iter++;
+            if (cur->first.compare(0, prefix.size(), prefix) == 0) {
+                EraseLocked(*shard, cur);
+            }
+        }
+    }
+}
+
+void FileCache::InvalidateNegative() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> locker(shard->mtx);
+        shard->gen++;
+        for (auto iter = shard->lru.begin(); iter != shard->lru.end();) {
+            auto cur = iter++;
+            if (!cur->second->is_exist) {
+                EraseLocked(*shard, cur);
+            }
+        }
+    }
+}
+
+void FileCache::Clear() {
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> locker(shard->mtx);
+        shard->gen++;
+        shard->lru.clear();
+        shard->index.clear();
+        shard->bytes = 0;
+    }
+}
+
+bool FileCache::IsEnabled() const {
+    return is_enabled_;
+}
+
+size_t FileCache::GetHitCount() const {
+    return hit_cnt_.load(std::memory_order_relaxed);
+}
+
+size_t FileCache::GetMissCount() const {
+    return miss_cnt_.load(std::memory_order_relaxed);
+}
+
+FileCache::Shard& FileCache::GetShard(const std::string& path) {
+    return *shards_[std::hash<std::string>{}(path) % shards_.size()];
+}
+
+size_t FileCache::EntryBytes(const FileEntry& entry) {
+    return entry.fd >= 0 ? static_cast<size_t>(entry.st.st_size) : 0;
+}
+
+void FileCache::EraseLocked(Shard& shard, decltype(Shard::lru)::iterator iter) {
+    shard.bytes -= EntryBytes(*iter->second);
+    shard.index.erase(iter->first);
+    shard.lru.erase(iter);
+}
+
+void FileCache::AddWatch(const std::string& dir) {
+    const uint32_t mask = IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+                        | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+    std::error_code ec;
+    std::vector<std::string> dirs = {dir};
+    for (auto iter = std::filesystem::recursive_directory_iterator(dir, ec);
+         !ec && iter != std::filesystem::recursive_directory_iterator(); iter.increment(ec)) {
+        if (iter->is_directory(ec)) {
+            dirs.push_back(iter->path().string());
+        }
+    }
+
+    std::lock_guard<std::mutex> locker(watch_mtx_);
+    for (const std::string& d : dirs) {
+        int wd = inotify_add_watch(inotify_fd_, d.c_str(), mask);
+        if (wd < 0) {
+            LOG_WARN("FileCache: Failed to watch directory %s, Error: %d.", d.c_str(), errno);
+            continue;
+        }
+        wd_dirs_[wd] = d;
+    }
+}
+
+void FileCache::WatchWorker() {
+    alignas(struct inotify_event) char buf[4096];
+    struct pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wakeup_fd_, POLLIN, 0}};
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            LOG_ERROR("FileCache: poll failed, Error: %d.", errno);
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        ssize_t len;
+        while ((len = read(inotify_fd_, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                HandleEvent(event);
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+    }
+}
+
+void FileCache::HandleEvent(const struct inotify_event* event) {
+    if (event->mask & IN_Q_OVERFLOW) {
+        // 事件队列溢出，无法确定哪些文件发生了变化
+        LOG_WARN("FileCache: inotify queue overflow, clear cache.");
+        Clear();
+        return;
+    }
+
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> locker(watch_mtx_);
+        auto iter = wd_dirs_.find(event->wd);
+        if (iter == wd_dirs_.end()) return;
+        dir = iter->second;
+        if (event->mask & IN_IGNORED) {
+            wd_dirs_.erase(iter);
+            return;
+        }
+    }
+    if (event->len == 0) {
+        // 被监听目录自身被删除或移动
+        InvalidatePrefix(dir + "/");
+        return;
+    }
+
+    std::string path = dir + "/" + event->name;
+    if (event->mask & IN_ISDIR) {
+        InvalidatePrefix(path + "/");
+        if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+            AddWatch(path);
+            InvalidateNegative();
+        }
+    } else {
+        Invalidate(path);
+    }
+    LOG_DEBUG("FileCache: invalidate %s.", path.c_str());
+}
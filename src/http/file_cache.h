@@ -0,0 +1,127 @@
+/**
+ * @file file_cache.h
+ * @author chenyinjie
+ * @date 2024-10-28
+ * @copyright Apache 2.0
+ */
+
+#ifndef FILE_CACHE_H
+#define FILE_CACHE_H
+
+#include "../log/log.h"
+
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief
+ * 静态资源缓存项
+ * 持有文件的stat信息、只读文件描述符、MIME类型、校验器(ETag与Last-Modified)与预先生成的首部字段。
+ * 校验器在加载时计算一次，文件变化后缓存项失效，重新加载得到新的校验器。
+ * 以shared_ptr共享，响应发送期间持有引用，缓存失效或淘汰后由最后一个持有者关闭描述符。
+ * sendfile使用显式偏移，不改变文件读写位置，多个连接可同时共享同一描述符。
+ */
+struct FileEntry {
+    FileEntry() = default;
+    ~FileEntry();
+    FileEntry(const FileEntry&) = delete;
+    FileEntry& operator=(const FileEntry&) = delete;
+
+    bool is_exist = false;                                      // 文件是否存在(false为否定缓存项)
+    struct stat st = {};                                        // 文件信息
+    int fd = -1;                                                // 只读文件描述符，空文件或不可读时为-1
+    std::string mime;                                           // MIME类型
+    std::string etag;                                           // 强校验器，由inode、大小与纳秒级修改时间生成
+    std::string last_modified;                                  // 修改时间(HTTP日期)
+    std::string header;                                         // 预生成的首部: Content-Type与Content-Length
+    std::string validator;                                      // 预生成的首部: ETag与Last-Modified
+    std::chrono::steady_clock::time_point load_time;            // 加载时间
+};
+
+/**
+ * @brief
+ * 单例模式设计的静态资源缓存
+ * - 以规范化(去除"."、".."与重复的'/')后的文件路径为键，与inotify失效时拼接的路径一致，按哈希分片，每个分片独立加锁并按LRU淘汰，分别限制缓存项数与文件字节数。
+ * - 每个缓存项占用一个描述符，缓存项总数不超过进程描述符上限的1/4，为连接保留余量。
+ * - 不存在的路径同样缓存(否定缓存)，大量请求不存在的路径时不再反复访问文件系统。
+ * - 后台线程通过inotify监听资源目录(含子目录)，文件修改、删除、新建时使对应缓存项失效。
+ * - Init之前Get直接从文件系统加载，不进行缓存。
+ * - 更新资源时应写入临时文件后rename替换，旧描述符仍指向旧文件；原地截断写入会使正在发送的响应提前结束。
+ */
+
+class FileCache {
+public:
+    FileCache(const FileCache&) = delete;
+    FileCache& operator=(const FileCache&) = delete;
+
+    static FileCache& GetFileCacheInstance();                   // 获取缓存单例
+    static std::shared_ptr<const FileEntry> Load(const std::string& path);  // 直接从文件系统加载
+    static std::string NormalizePath(const std::string& path);  // 词法规范化路径，不访问文件系统
+
+    bool Init(const std::string& root, size_t max_entries = 4096, size_t max_bytes = 256 << 20, size_t shard_nums = 16);
+    void Close();                                               // 停止监听并清空缓存
+
+    std::shared_ptr<const FileEntry> Get(const std::string& path);
+    void Invalidate(const std::string& path);                   // 使指定路径失效
+    void InvalidatePrefix(const std::string& prefix);           // 使指定前缀(目录)下所有路径失效
+    void InvalidateNegative();                                  // 使全部否定缓存项失效
+    void Clear();                                               // 清空缓存
+
+    bool IsEnabled() const;
+    size_t GetHitCount() const;
+    size_t GetMissCount() const;
+
+    static const int NEGATIVE_TTL_MS = 5000;                    // 否定缓存项最长有效期
+
+private:
+    FileCache();
+    ~FileCache();
+
+    struct Shard {
+        std::mutex mtx;
+        std::list<std::pair<std::string, std::shared_ptr<const FileEntry>>> lru;   // 表头为最近使用
+        std::unordered_map<std::string, decltype(lru)::iterator> index;
+        size_t bytes = 0;                                       // 已缓存文件字节数
+        uint64_t gen = 0;                                       // 失效计数，加载期间发生失效时不插入旧数据
+    };
+
+    Shard& GetShard(const std::string& path);
+    static size_t EntryBytes(const FileEntry& entry);
+    void EraseLocked(Shard& shard, decltype(Shard::lru)::iterator iter);
+
+    void WatchWorker();                                         // inotify监听线程
+    void AddWatch(const std::string& dir);                      // 递归监听目录
+    void HandleEvent(const struct inotify_event* event);
+
+    std::atomic<bool> is_enabled_;                              // 缓存是否启用
+    size_t max_entries_;                                        // 每个分片的最大缓存项数
+    size_t max_bytes_;                                          // 每个分片的最大文件字节数
+    std::vector<std::unique_ptr<Shard>> shards_;                // 缓存分片
+
+    std::atomic<size_t> hit_cnt_;                               // 命中次数
+    std::atomic<size_t> miss_cnt_;                              // 未命中次数
+
+    int inotify_fd_;                                            // inotify实例描述符
+    int wakeup_fd_;                                             // 用于唤醒监听线程的eventfd
+    std::mutex watch_mtx_;                                      // 保护wd_dirs_
+    std::unordered_map<int, std::string> wd_dirs_;              // 监听描述符到目录路径
+    std::thread watch_thread_;                                  // 监听线程
+};
+
+#endif
@@ -12,9 +12,12 @@ using namespace std;
 bool HTTPConnect::is_ET;
 std::filesystem::path HTTPConnect::src_dir;
 std::atomic<int> HTTPConnect::user_cnt;
+UserStore* HTTPConnect::user_store = nullptr;
+SessionStore* HTTPConnect::session_store = nullptr;
 
 
-HTTPConnect::HTTPConnect(): socket_fd_(-1), addr_{0}, is_close_(true) {}
+HTTPConnect::HTTPConnect(): socket_fd_(-1), addr_{0}, is_close_(true), is_keep_alive_(false), is_new_session_(false),
+                            part_idx_(0), head_pos_(0), file_offset_(0), file_remain_(0), body_remain_(0) {}
 
 HTTPConnect::~HTTPConnect() {
     Close();
@@ -30,6 +33,12 @@ void HTTPConnect::Init(int socket_fd, const sockaddr_in& server_addr) {
     addr_ = server_addr;
     write_buffer_.Clear();
     read_buffer_.Clear();
+    pending_.clear();
+    body_remain_ = 0;
+    is_keep_alive_ = false;
+    is_new_session_ = false;
+    SeekPart(0);
+    request_.Init();
     is_close_ = false;
 
     LOG_INFO("Client[%d](%s:%d) in, user_cnt:%d", socket_fd_, GetIP(), GetPort(), static_cast<int>(user_cnt));
@@ -44,36 +53,74 @@ ssize_t HTTPConnect::Read(int* save_errno) {
     return len;
 }
 
+/**
+ * @brief
+ * 按队列顺序发送各响应：先发送写缓冲区中的状态行与首部，再依次发送各实体段(段首部直接发送，文件数据以sendfile发送，不经过用户态)
+ * - 队首响应没有文件实体时，与后续响应在写缓冲区中相邻的数据合并为一次send。
+ * - 后面还有数据时使用MSG_MORE，流水线上的多个响应尽量合并为较少的TCP报文段。
+ * - 持续写入直到全部发送或套接字缓冲区已满；部分写入时记录缓冲区读位置、当前段与文件偏移，下次可写时从中断处继续。
+ */
 ssize_t HTTPConnect::Write(int* save_errno) {
     ssize_t len = -1;
     do {
-        len = writev(socket_fd_, iov_, iov_count_);
-        if (len <= 0) {
-            *save_errno = errno;
+        if (pending_.empty()) {
             break;
         }
-
-        if (iov_[0].iov_len + iov_[1].iov_len == 0) {
-            break;
-        } else if (static_cast<size_t>(len) > iov_[0].iov_len) {
-            iov_[1].iov_base = static_cast<uint8_t*> (iov_[1].iov_base) + len - iov_[0].iov_len;
-            iov_[1].iov_len -= (len - iov_[0].iov_len);
-            if (iov_[0].iov_len) {
-                write_buffer_.ReadAll();
-                iov_[0].iov_len = 0;
+        PendingResponse& resp = pending_.front();
+        if (resp.head_len > 0) {
+            size_t to_send = resp.head_len;
+            for (auto iter = pending_.begin(); iter->parts.empty() && std::next(iter) != pending_.end(); ++iter) {
+                to_send += std::next(iter)->head_len;
             }
+            int flags = MSG_NOSIGNAL | (ToWriteBytes() > to_send ? MSG_MORE : 0);
+            len = send(socket_fd_, write_buffer_.ReadPtr(), to_send, flags);
+            if (len <= 0) {
+                *save_errno = errno;
+                break;
+            }
+            ConsumeHead(len);
         } else {
-            iov_[0].iov_base = static_cast<uint8_t*>(iov_[0].iov_base) + len; 
-            iov_[0].iov_len -= len; 
-            write_buffer_.ReadLen(len);
+            const FilePart& part = resp.parts[part_idx_];
+            if (head_pos_ < part.head.size()) {
+                size_t head_len = part.head.size() - head_pos_;
+                int flags = MSG_NOSIGNAL | (ToWriteBytes() > head_len ? MSG_MORE : 0);
+                len = send(socket_fd_, part.head.data() + head_pos_, head_len, flags);
+                if (len <= 0) {
+                    *save_errno = errno;
+                    break;
+                }
+                head_pos_ += len;
+            } else {
+                len = sendfile(socket_fd_, resp.file->fd, &file_offset_, file_remain_);
+                if (len < 0) {
+                    *save_errno = errno;
+                    break;
+                }
+                if (len == 0) {
+                    // 文件在发送期间被截断，无法按Content-Length发送完整实体
+                    LOG_ERROR("HTTP Connect: Client[%d] file truncated during sendfile.", socket_fd_);
+                    *save_errno = EIO;
+                    len = -1;
+                    break;
+                }
+                file_remain_ -= len;
+            }
+            body_remain_ -= len;
+            if (head_pos_ == part.head.size() && file_remain_ == 0) {
+                SeekPart(part_idx_ + 1);
+            }
         }
-    } while (is_ET || ToWriteBytes() > 10240);
+        PopFinished();
+    } while (ToWriteBytes() > 0);
 
     return len;
 }
 
 void HTTPConnect::Close() {
     response_.UnmapFilePtr();
+    pending_.clear();
+    body_remain_ = 0;
+    SeekPart(0);
     if (!is_close_) {
         is_close_ = true;
         user_cnt.fetch_sub(1);
@@ -92,7 +139,8 @@ int HTTPConnect::GetPort() const {
 }
 
 const char* HTTPConnect::GetIP() const {
-    static char IP[INET_ADDRSTRLEN];
+    // 多Reactor模式下多个线程会同时调用, 使用线程局部缓冲区
+    static thread_local char IP[INET_ADDRSTRLEN];
     inet_ntop(AF_INET, &addr_.sin_addr, IP, sizeof(IP));
     return IP;
 }
@@ -109,36 +157,184 @@ Buffer& HTTPConnect::GetReadBuffer() {
     return read_buffer_;
 }
 
-bool HTTPConnect::Process() {
-    request_.Init();
-    if (read_buffer_.ReadableLen() <= 0) {
-        return false;
-    } else if (request_.Parse(read_buffer_)) {
-        LOG_INFO("HTTP Connect: Parse request: %s", request_.GetPath().c_str());
-        response_.Init(src_dir, request_.GetPath(), request_.IsKeepAlive(), 200);
-    } else {
-        response_.Init(src_dir, request_.GetPath(), false, 400);
+TimerNode* HTTPConnect::GetTimerNode() {
+    return &timer_node_;
+}
+
+void HTTPConnect::SeekPart(size_t idx) {
+    part_idx_ = idx;
+    head_pos_ = 0;
+    file_offset_ = 0;
+    file_remain_ = 0;
+    if (!pending_.empty() && idx < pending_.front().parts.size()) {
+        file_offset_ = pending_.front().parts[idx].offset;
+        file_remain_ = pending_.front().parts[idx].len;
+    }
+}
+
+void HTTPConnect::ConsumeHead(size_t len) {
+    write_buffer_.ReadLen(len);
+    for (auto iter = pending_.begin(); len > 0 && iter != pending_.end(); ++iter) {
+        size_t n = std::min(len, iter->head_len);
+        iter->head_len -= n;
+        len -= n;
+    }
+}
+
+void HTTPConnect::PopFinished() {
+    while (!pending_.empty() && pending_.front().head_len == 0 && part_idx_ >= pending_.front().parts.size()) {
+        pending_.pop_front();
+        SeekPart(0);
     }
+}
 
+void HTTPConnect::QueueResponse() {
+    size_t begin = write_buffer_.ReadableLen();
     response_.GenerateResponse(write_buffer_);
-    iov_[0].iov_base = write_buffer_.ReadPtr();
-    iov_[0].iov_len = write_buffer_.ReadableLen();
-    iov_count_ = 1;
-    
-    if (response_.GetFileLen() > 0 && response_.GetFilePtr()) {
-        iov_[1].iov_base = response_.GetFilePtr();
-        iov_[1].iov_len = response_.GetFileLen();
-        iov_count_ = 2;
+
+    PendingResponse resp{write_buffer_.ReadableLen() - begin, response_.GetFile(), response_.GetFileParts()};
+    for (const FilePart& part : resp.parts) {
+        body_remain_ += part.head.size() + part.len;
+    }
+    if (resp.parts.empty()) {
+        resp.file.reset();
+    }
+    pending_.push_back(std::move(resp));
+    if (pending_.size() == 1) {
+        SeekPart(0);
+    }
+    response_.UnmapFilePtr();
+}
+
+/**
+ * @brief
+ * 解析读缓冲区中所有完整的请求(HTTP/1.1流水线)，按顺序生成响应并加入发送队列
+ * 遇到不完整的请求、非长连接请求或错误请求时停止；单次最多处理MAX_PIPELINE个，其余在本批响应发送完毕后继续处理
+ * @return 是否有待发送的响应
+ */
+bool HTTPConnect::Process() {
+    // 已排队的响应将关闭连接(如数据库请求的响应)，其后的请求不再处理
+    if (!is_keep_alive_ && !pending_.empty()) {
+        return true;
+    }
+    size_t cnt = 0;
+    while (cnt < MAX_PIPELINE) {
+        // 数据库请求交由数据库执行器处理，完成前保持其解析结果，后续请求等待其响应排队后再处理
+        if (request_.IsDBRequest()) {
+            break;
+        }
+        // 上一个请求已经响应完毕，开始解析新请求；未完成的请求保留解析状态，在新数据到达后继续解析
+        if (request_.IsFinish()) {
+            request_.Init();
+        }
+        if (read_buffer_.ReadableLen() <= 0) {
+            break;
+        } else if (!request_.Parse(read_buffer_)) {
+            response_.Init(src_dir, request_.GetPath(), false, 400);
+        } else if (!ResumeSession() && request_.IsDBRequest()) {
+            break;
+        } else if (request_.IsFinish()) {
+            LOG_INFO("HTTP Connect: Parse request: %s", request_.GetPath().c_str());
+            response_.Init(src_dir, request_.GetPath(), request_.IsKeepAlive(), 200);
+            if (request_.GetMethod() == "GET") {
+                response_.SetRange(request_.GetHeader("range"), request_.GetHeader("if-range"));
+                response_.SetCondition(request_.GetHeader("if-none-match"), request_.GetHeader("if-modified-since"));
+                response_.SetAcceptEncoding(request_.GetHeader("accept-encoding"));
+            }
+        } else {
+            break;
+        }
+
+        is_keep_alive_ = response_.IsKeepAlive();
+        QueueResponse();
+        ++cnt;
+        if (!is_keep_alive_) {
+            // 连接将在响应发送后关闭，其后的请求不再处理
+            break;
+        }
+    }
+
+    LOG_DEBUG("HTTP Connect: %zu responses queued, %zu to write", cnt, ToWriteBytes());
+    return !pending_.empty();
+}
+
+bool HTTPConnect::IsDBPending() const {
+    return request_.IsDBRequest();
+}
+
+void HTTPConnect::ProcessDB() {
+    VerifyDB();
+    FinishDB();
+}
+
+void HTTPConnect::VerifyDB() {
+    bool is_login = request_.IsLoginRequest();
+    bool is_verified = request_.VerifyUser(user_store);
+    is_new_session_ = is_login && is_verified;
+}
+
+bool HTTPConnect::GetDBUser(std::string* name, std::string* hashed_pwd, bool* is_login) const {
+    return request_.GetVerifyUser(name, hashed_pwd, is_login);
+}
+
+// 只修改请求路径，可在数据库事件循环中调用；生成响应涉及文件访问，由FinishDB在I/O线程中完成
+void HTTPConnect::SetDBResult(bool is_verified) {
+    is_new_session_ = request_.IsLoginRequest() && is_verified;
+    request_.SetVerifyResult(is_verified);
+}
+
+void HTTPConnect::FinishDB(bool is_verified) {
+    SetDBResult(is_verified);
+    FinishDB();
+}
+
+void HTTPConnect::FinishDB() {
+    QueueDBResponse(is_new_session_);
+}
+
+/**
+ * @brief
+ * 访问登录页或提交登录时，若携带的会话有效(提交的用户名为空或与会话一致)，直接转到欢迎页，不访问用户存储
+ * @return 是否已由会话完成验证
+ */
+bool HTTPConnect::ResumeSession() {
+    if (session_store == nullptr || !request_.IsFinish() || request_.GetPath() != "/login.html") {
+        return false;
+    }
+    std::string sid = request_.GetCookie(SessionStore::COOKIE_NAME);
+    std::string name;
+    if (sid.empty() || !session_store->Check(sid, &name)) {
+        return false;
+    }
+    // GET请求没有表单，仅在提交了用户名时核对会话所属用户
+    if (request_.HasPost("username")) {
+        std::string user = request_.GetPost("username");
+        if (!user.empty() && user != name) {
+            return false;
+        }
     }
-    
-    LOG_DEBUG("HTTP Connect: filesize: %d, %d to %d", response_.GetFileLen() , iov_count_, ToWriteBytes());
+    LOG_DEBUG("HTTP Connect: Resume session of user: %s", name.c_str());
+    request_.SetVerifyResult(true);
     return true;
 }
 
+void HTTPConnect::QueueDBResponse(bool is_new_session) {
+    LOG_INFO("HTTP Connect: Verify user, response: %s", request_.GetPath().c_str());
+    response_.Init(src_dir, request_.GetPath(), request_.IsKeepAlive(), 200);
+    if (is_new_session && session_store != nullptr) {
+        std::string sid = session_store->Create(request_.GetPost("username"));
+        if (!sid.empty()) {
+            response_.SetCookie(session_store->GetCookie(sid));
+        }
+    }
+    is_keep_alive_ = response_.IsKeepAlive();
+    QueueResponse();
+}
+
 size_t HTTPConnect::ToWriteBytes() const {
-    return iov_[0].iov_len + iov_[1].iov_len;
+    return write_buffer_.ReadableLen() + body_remain_;
 }
 
 bool HTTPConnect::IsKeepAlive() const {
-    return request_.IsKeepAlive();
+    return is_keep_alive_;
 }
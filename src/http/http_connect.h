@@ -11,16 +11,32 @@
 #include "../log/log.h"
 #include "../buffer/buffer.h"
 #include "../pool/db_connect_pool_RAII.h"
+#include "../timer/timer_queue.h"
+#include "../store/session_store.h"
 #include "http_request.h"
 #include "http_response.h"
 
 #include <sys/types.h>
-#include <sys/uio.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
 #include <arpa/inet.h>
 #include <stdlib.h>
 #include <error.h>
 #include <netinet/in.h>
 #include <atomic>
+#include <deque>
+
+/**
+ * @brief
+ * 等待发送的响应
+ * 状态行与首部(错误响应还包括实体)按顺序写入连接的写缓冲区，head_len记录其中属于该响应的字节数；
+ * 文件实体各段在首部之后由sendfile发送。
+ */
+struct PendingResponse {
+    size_t head_len;                                                // 写缓冲区中尚未发送的本响应字节数
+    std::shared_ptr<const FileEntry> file;                          // 实体文件，发送完成前持有引用
+    std::vector<FilePart> parts;                                    // 由文件发送的实体各段
+};
 
 class HTTPConnect {
 public:
@@ -40,8 +56,16 @@ public:
 
     Buffer& GetWriteBuffer();
     Buffer& GetReadBuffer();
+    TimerNode* GetTimerNode();
 
-    bool Process();
+    bool Process();                                                 // 解析并响应已到达的请求，遇到数据库请求时停止
+    bool IsDBPending() const;                                       // 是否有等待执行的数据库请求
+    void ProcessDB();                                               // 执行数据库请求并生成其响应，之后可继续Process
+    void VerifyDB();                                                // 执行数据库请求并记录结果，不生成响应
+    bool GetDBUser(std::string* name, std::string* hashed_pwd, bool* is_login) const;   // 待验证的用户，为空时无需访问数据库
+    void SetDBResult(bool is_verified);                             // 记录异步验证结果，不生成响应
+    void FinishDB(bool is_verified);                                // 由异步验证结果生成响应，之后可继续Process
+    void FinishDB();                                                // 由已记录的验证结果生成响应，之后可继续Process
 
     size_t ToWriteBytes() const;
     bool IsKeepAlive() const;
@@ -49,13 +73,31 @@ public:
     static bool is_ET;                                              // 事件触发通知模式
     static std::filesystem::path src_dir;                           // 资源路径
     static std::atomic<int> user_cnt;                               // 当前连接用户数
+    static UserStore* user_store;                                   // 同步执行登录、注册的用户存储
+    static SessionStore* session_store;                             // 登录会话表，为空时不签发会话
+    static const size_t MAX_PIPELINE = 32;                          // 一次处理的最多流水线请求数
 
 private:
+    void SeekPart(size_t idx);                                      // 切换到队首响应的第idx个实体段
+    void QueueResponse();                                           // 生成响应并加入发送队列
+    bool ResumeSession();                                           // 登录请求携带有效会话时直接转到欢迎页
+    void QueueDBResponse(bool is_new_session);                      // 数据库请求完成后生成其响应，登录成功时签发会话
+    void ConsumeHead(size_t len);                                   // 写缓冲区发送len字节后更新队列
+    void PopFinished();                                             // 移除已发送完毕的队首响应
+
     int socket_fd_;                                                 // 连接套接字文件描述符
     struct sockaddr_in addr_;                                       // 地址结构体
     bool is_close_;                                                 // 连接关闭标记
-    int iov_count_;                                                 // `iov`结构体数组中有效缓冲区数量
-    struct iovec iov_[2];                                           // I/O缓冲数组
+    bool is_keep_alive_;                                            // 最后一个响应是否保持连接
+    bool is_new_session_;                                           // 已记录的验证结果是否为登录成功，生成响应时签发会话
+    std::deque<PendingResponse> pending_;                           // 按请求顺序等待发送的响应
+    size_t part_idx_;                                               // 队首响应正在发送的实体段
+    size_t head_pos_;                                               // 当前段head已发送字节数
+    off_t file_offset_;                                             // 当前段下一次发送的文件偏移
+    size_t file_remain_;                                            // 当前段剩余未发送的文件字节数
+    size_t body_remain_;                                            // 队列中所有响应剩余未发送的实体字节数
+
+    TimerNode timer_node_;                                          // 连接超时定时器节点
 
     Buffer read_buffer_;                                            // 读取客户端传输数据缓冲区
     Buffer write_buffer_;                                           // 服务器数据发送缓冲区
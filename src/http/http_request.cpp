@@ -15,8 +15,11 @@
 
 
 #include "http_request.h"
+#include "http_scan.h"
 
 #include <openssl/sha.h>
+#include <algorithm>
+#include <cctype>
 
 static const size_t SIZE = 256;
 
@@ -34,50 +37,76 @@ HTTPRequest::HTTPRequest() {
 
 void HTTPRequest::Init() {
     state_ = REQUEST_LINE;
-    method_ = path_ = version_ = body_ = "";
+    scan_pos_ = 0;
+    content_len_ = 0;
+    is_keep_alive_ = false;
+    verify_tag_ = -1;
+    method_.clear();
+    path_.clear();
+    version_.clear();
+    body_.clear();
     headers_.clear();
     posts_.clear();
 }
 
+/**
+ * @brief 
+ * 增量解析
+ * 直接在缓冲区可读数据上以string_view逐行解析，每解析完一行即从缓冲区中取走该行。
+ * 行不完整时记录已扫描长度并返回true，下次读取后从该位置继续查找行尾，不重复扫描；
+ * 请求体等待Content-Length指定的数据全部到达后一次取走。
+ * @return 报文格式错误时返回false，解析完成与否由IsFinish判断
+ */
 bool HTTPRequest::Parse(Buffer& buffer) {
-    if (buffer.ReadableLen() <= 0) {
-        LOG_ERROR("HTTP Request: Buffer Readable Length Error.");
-        return false;
-    };
-
-    const char CRLF[] = "\r\n";
-    while (buffer.ReadableLen() > 0 && state_ != FINISH) {
-        const char* end_of_line = std::search(buffer.ReadPtr(), buffer.WritePtr(), CRLF, CRLF + 2);
-        std::string line(static_cast<const char*>(buffer.ReadPtr()), end_of_line);
-        switch (state_) {
-            case REQUEST_LINE:
-                if (!ParseRequestLine(line)) {
-                    return false;
-                }
-                ParsePath();
-                break;
-
-            case HEADER:
-                ParseHeader(line);
-                if (buffer.ReadableLen() <= 2) {
-                    state_ = FINISH;
-                }
-                break;
+    if (state_ == INVALID) return false;
+
+    while (state_ != FINISH) {
+        std::string_view data(buffer.ReadPtr(), buffer.ReadableLen());
+        if (state_ == BODY) {
+            if (data.size() < content_len_) break;
+            ParseBody(data.substr(0, content_len_));
+            buffer.ReadLen(content_len_);
+            break;
+        }
 
-            case BODY:
-                ParseBody(line);
-                break;
+        // 上次已扫描的部分不含'\n'，从该位置继续查找；'\r'可能在上次读取的末尾，在找到'\n'后再校验
+        const char* data_end = data.data() + data.size();
+        const char* lf_ptr = HTTPScan::FindLineEnd(data.data() + scan_pos_, data_end);
+        if (lf_ptr == data_end) {
+            scan_pos_ = data.size();
+            if (scan_pos_ > MAX_LINE_LEN) {
+                LOG_ERROR("HTTP Request: Line too long.");
+                state_ = INVALID;
+                return false;
+            }
+            break;
+        }
+        scan_pos_ = 0;
+        size_t lf = lf_ptr - data.data();
+        if (lf == 0 || data[lf - 1] != '\r' || lf > MAX_LINE_LEN) {
+            LOG_ERROR("HTTP Request: Malformed line ending.");
+            state_ = INVALID;
+            return false;
+        }
 
-            default:
-                break;
+        std::string_view line = data.substr(0, lf - 1);
+        bool ok = (state_ == REQUEST_LINE) ? ParseRequestLine(line) : ParseHeader(line);
+        buffer.ReadLen(lf + 1);
+        if (!ok) {
+            state_ = INVALID;
+            return false;
         }
-        if (end_of_line == buffer.WritePtr()) break;
-        buffer.ReadUntil(end_of_line + 2);
     }
-    LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+    if (state_ == FINISH) {
+        LOG_DEBUG("[%s], [%s], [%s]", method_.c_str(), path_.c_str(), version_.c_str());
+    }
     return true;
 }
 
+bool HTTPRequest::IsFinish() const {
+    return state_ == FINISH;
+}
+
 std::string HTTPRequest::GetPath() const {
     return path_;
 }
@@ -110,42 +139,199 @@ std::string HTTPRequest::GetPost(const char* key) const {
     return "";
 }
 
+bool HTTPRequest::HasPost(const std::string& key) const {
+    return posts_.count(key) > 0;
+}
+
+std::string HTTPRequest::GetHeader(const std::string& key) const {
+    std::string lower(key);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    auto iter = headers_.find(lower);
+    return iter == headers_.end() ? "" : iter->second;
+}
+
+// Cookie: name1=value1; name2=value2
+std::string HTTPRequest::GetCookie(const std::string& name) const {
+    auto iter = headers_.find("cookie");
+    if (iter == headers_.end()) return "";
+    std::string_view cookie = iter->second;
+    while (!cookie.empty()) {
+        size_t end = cookie.find(';');
+        std::string_view pair = cookie.substr(0, end);
+        while (!pair.empty() && pair.front() == ' ') pair.remove_prefix(1);
+        size_t eq = pair.find('=');
+        if (eq != std::string_view::npos && pair.substr(0, eq) == name) {
+            std::string_view value = pair.substr(eq + 1);
+            while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
+            return std::string(value);
+        }
+        if (end == std::string_view::npos) break;
+        cookie.remove_prefix(end + 1);
+    }
+    return "";
+}
+
 bool HTTPRequest::IsKeepAlive() const {
-    return headers_.count("Connection") && headers_.find("Connection")->second == "keep-alive" && version_ == "1.1";
+    return state_ != INVALID && is_keep_alive_;
 }
 
-bool HTTPRequest::ParseRequestLine(const std::string& line) {
-    // parse request line
-    std::regex pattern("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
-    std::smatch parse_result;
+bool HTTPRequest::IsDBRequest() const {
+    return state_ == FINISH && verify_tag_ != -1;
+}
 
-    if (std::regex_match(line, parse_result, pattern)) {
-        method_ = parse_result[1];
-        path_ = parse_result[2];
-        version_ = parse_result[3];
-        state_ = HEADER;
-        return true;
+bool HTTPRequest::IsLoginRequest() const {
+    return verify_tag_ == 1;
+}
+
+// 用户存储只接收密码哈希，用户名或密码为空时直接失败
+bool HTTPRequest::VerifyUser(UserStore* store) {
+    std::string name, hashed_pwd;
+    bool is_login = false;
+    if (!GetVerifyUser(&name, &hashed_pwd, &is_login) || store == nullptr) {
+        SetVerifyResult(false);
+        return false;
     }
+    LOG_INFO("UserVerify: name: %s", name.c_str());
+    bool is_verified = is_login ? store->Login(name, hashed_pwd) : store->Register(name, hashed_pwd);
+    SetVerifyResult(is_verified);
+    return is_verified;
+}
 
-    LOG_ERROR("Request Line Parse Error");
-    return false;
+void HTTPRequest::SetVerifyResult(bool is_verified) {
+    verify_tag_ = -1;
+    path_ = is_verified ? "/welcome.html" : "/error.html";
 }
 
-void HTTPRequest::ParseHeader(const std::string& line) {
-    std::regex pattern("^([^:]*): ?(.*)$");
-    std::smatch parse_result;
-    if (std::regex_match(line, parse_result, pattern)) {
-        headers_[parse_result[1]] = parse_result[2];
-    } else {
-        state_ = BODY;
+// 异步验证只需要用户名与密码哈希，由批量合并器生成SQL
+bool HTTPRequest::GetVerifyUser(std::string* name, std::string* hashed_pwd, bool* is_login) const {
+    auto user = posts_.find("username");
+    auto pwd = posts_.find("password");
+    if (verify_tag_ == -1 || user == posts_.end() || pwd == posts_.end() || user->second.empty() || pwd->second.empty()) {
+        return false;
     }
+    *name = user->second;
+    *hashed_pwd = HashPassword(pwd->second);
+    *is_login = (verify_tag_ == 1);
+    return true;
+}
+
+// RFC 9110 token字符
+static bool IsTokenChar(unsigned char ch) {
+    static const std::string_view SEPARATORS = "\"(),/:;<=>?@[\\]{}";
+    return ch > 0x20 && ch < 0x7f && SEPARATORS.find(static_cast<char>(ch)) == std::string_view::npos;
 }
 
-void HTTPRequest::ParseBody(const std::string& line) {
-    body_ = line;
+static bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    if (lhs.size() != rhs.size()) return false;
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(lhs[i])) != std::tolower(static_cast<unsigned char>(rhs[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief 
+ * 解析请求行: METHOD SP request-target SP HTTP/x.y
+ */
+bool HTTPRequest::ParseRequestLine(std::string_view line) {
+    size_t i = 0, n = line.size();
+    while (i < n && IsTokenChar(line[i])) ++i;
+    if (i == 0 || i >= n || line[i] != ' ') {
+        LOG_ERROR("Request Line Parse Error");
+        return false;
+    }
+    std::string_view method = line.substr(0, i);
+
+    size_t target_begin = ++i;
+    while (i < n && static_cast<unsigned char>(line[i]) > 0x20 && line[i] != 0x7f) ++i;
+    if (i == target_begin || i >= n || line[i] != ' ') {
+        LOG_ERROR("Request Line Parse Error");
+        return false;
+    }
+    std::string_view target = line.substr(target_begin, i - target_begin);
+
+    std::string_view version = line.substr(i + 1);
+    if (version.size() != 8 || version.substr(0, 5) != "HTTP/" || !isdigit(version[5])
+        || version[6] != '.' || !isdigit(version[7])) {
+        LOG_ERROR("Request Line Parse Error");
+        return false;
+    }
+
+    method_.assign(method);
+    path_.assign(target);
+    version_.assign(version.substr(5));
+    // HTTP/1.1默认保持连接，HTTP/1.0需显式声明
+    is_keep_alive_ = (version_ == "1.1");
+    ParsePath();
+    state_ = HEADER;
+    return true;
+}
+
+/**
+ * @brief 
+ * 解析首部行: field-name ":" OWS field-value OWS，空行表示首部结束
+ */
+bool HTTPRequest::ParseHeader(std::string_view line) {
+    if (line.empty()) {
+        state_ = content_len_ > 0 ? BODY : FINISH;
+        return true;
+    }
+
+    size_t n = line.size();
+    size_t i = HTTPScan::FindColon(line.data(), line.data() + n) - line.data();
+    std::string_view key = line.substr(0, i);
+    if (i == 0 || i >= n || !std::all_of(key.begin(), key.end(), [](char ch) { return IsTokenChar(ch); })) {
+        LOG_ERROR("HTTP Request: Header Parse Error");
+        return false;
+    }
+
+    size_t begin = i + 1, end = n;
+    while (begin < end && (line[begin] == ' ' || line[begin] == '\t')) ++begin;
+    while (end > begin && (line[end - 1] == ' ' || line[end - 1] == '\t')) --end;
+    std::string_view value = line.substr(begin, end - begin);
+    if (HTTPScan::FindInvalidValue(value.data(), value.data() + value.size()) != value.data() + value.size()) {
+        LOG_ERROR("HTTP Request: Header Parse Error");
+        return false;
+    }
+
+    // 常用首部在解析时直接提取，避免后续查表
+    if (EqualsIgnoreCase(key, "Connection")) {
+        if (EqualsIgnoreCase(value, "close")) {
+            is_keep_alive_ = false;
+        } else if (EqualsIgnoreCase(value, "keep-alive")) {
+            is_keep_alive_ = true;
+        }
+    } else if (EqualsIgnoreCase(key, "Content-Length")) {
+        size_t len = 0;
+        bool is_valid = !value.empty() && value.size() <= 10;
+        for (size_t k = 0; is_valid && k < value.size(); ++k) {
+            is_valid = isdigit(static_cast<unsigned char>(value[k]));
+            len = len * 10 + (value[k] - '0');
+        }
+        if (!is_valid) {
+            LOG_ERROR("HTTP Request: Invalid Content-Length.");
+            return false;
+        }
+        if (len > MAX_BODY_LEN) {
+            LOG_ERROR("HTTP Request: Body too large: %zu.", len);
+            return false;
+        }
+        content_len_ = len;
+    }
+
+    std::string lower(key);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char ch) { return std::tolower(ch); });
+    headers_[std::move(lower)].assign(value);
+    return true;
+}
+
+void HTTPRequest::ParseBody(std::string_view body) {
+    body_.assign(body);
     ParsePost();
     state_ = FINISH;
-    LOG_DEBUG("Parse HTTP Request Body, len size: %d", line.size());
+    LOG_DEBUG("Parse HTTP Request Body, len size: %d", body.size());
 }
 
 void HTTPRequest::ParsePath() {
@@ -162,278 +348,95 @@ void HTTPRequest::ParsePath() {
 }
 
 void HTTPRequest::ParsePost() {
-    if (method_ == "POST" && headers_["Content-Type"] == "application/x-www-form-urlencoded") {
+    if (method_ == "POST" && GetHeader("Content-Type") == "application/x-www-form-urlencoded") {
         ParseFromUrlEncoded();
         if (DEFAULT_HTML_TAG.count(path_)) {
             int tag = DEFAULT_HTML_TAG.find(path_)->second;
             LOG_DEBUG("HTTP Request Path Tag:%d", tag);
+            // 只记录待执行的验证，数据库访问由VerifyUser在数据库执行器中完成，不占用解析线程
             if (tag == 0 || tag == 1) {
-                bool is_login = (tag == 1);
-                if (UserVerify(posts_["username"], posts_["password"], is_login)) {
-                    path_ = "/welcome.html";
-                } else {
-                    path_ = "/error.html";
-                }
+                verify_tag_ = tag;
             }
         }
     }
 }
 
+/**
+ * @brief 
+ * 解析application/x-www-form-urlencoded请求体
+ * 以块为单位跳过普通字符，只在'%' '+' '&' '='处逐个处理，键与值分别解码后存入posts_。
+ */
 void HTTPRequest::ParseFromUrlEncoded() {
     if (body_.size() == 0) return;
 
     std::string key, val;
-    int num = 0;
-    int n = body_.size();
-    int left = 0, right = 0;
-    
-    for (; right < n; right++) {
-        char ch = body_[right];
+    std::string* out = &key;
+    const char* p = body_.data();
+    const char* end = body_.data() + body_.size();
+
+    while (p < end) {
+        const char* special = HTTPScan::FindFormSpecial(p, end);
+        out->append(p, special);
+        if (special == end) break;
+
         int low = -1, high = -1;
-        switch (ch) {
+        switch (*special) {
             case '=':
-                key = body_.substr(left, right - left);
-                left = right + 1;
+                if (out == &key) {
+                    out = &val;
+                } else {
+                    out->push_back('=');
+                }
+                p = special + 1;
                 break;
 
             case '+':
-                body_[right] = ' ';
+                out->push_back(' ');
+                p = special + 1;
                 break;
 
             case '%':
-                if (right + 2 >= n) {
+                if (end - special < 3) {
                     LOG_ERROR("HTTP Request: Percent decoding index out of range.");
-                    return; // 或者采取其他适当的错误处理措施   
+                    return;
                 }
-                high = ConvertHex(body_[right + 1]);
-                low = ConvertHex(body_[right + 2]);
+                high = ConvertHex(special[1]);
+                low = ConvertHex(special[2]);
                 if (high == -1 || low == -1) {
                     LOG_ERROR("HTTP Request: Invalid percent encoding.");
-                    return; // 或者采取其他适当的错误处理措施
+                    return;
                 }
-                num = high * 16 + low;
-                body_[right] = static_cast<char>(num);
-                right += 2;
+                out->push_back(static_cast<char>(high * 16 + low));
+                p = special + 3;
                 break;
 
-            case '&':
-                val = body_.substr(left, right - left);
-                left = right + 1;
+            default:    // '&'
                 posts_[key] = val;
                 LOG_DEBUG("ParseFromUrlEncoded: Key: %s", key.c_str());
-                break;
-
-            default:
+                key.clear();
+                val.clear();
+                out = &key;
+                p = special + 1;
                 break;
         }
     }
 
-    if (left <= right) {
-        val = body_.substr(left, right - left);
+    if (!key.empty() || !val.empty()) {
         posts_[key] = val;
         LOG_DEBUG("ParseFromUrlEncoded: Key: %s", key.c_str());
     }
 }
 
-/**
- * @brief 
- * 用户验证逻辑
- * - 登录逻辑
- * - 注册逻辑
- * 
- * @param name 
- * @param pwd 
- * @param is_login 
- * @return true 
- * @return false 
- */
-bool HTTPRequest::UserVerify(const std::string& name, const std::string& pwd, bool is_login) {
-    if (name == "" || pwd == "") return false;
-    LOG_INFO("UserVerify: name: %s", name.c_str());
-
-    MYSQL* sql;
-    SQLConnectPoolRAII(&sql, SQLConnectPool::GetSQLConnectPoolInstance());
-    if (sql == nullptr) {
-        LOG_ERROR("Get SQL connection failed.");
-        return false;
-    }
-
-    bool flag = false;
-    MYSQL_STMT* stmt = nullptr;
-    MYSQL_BIND bind[2];
-    MYSQL_BIND result_bind[1];
-    char hashed_pwd[65] = {0};    // 存储密码的哈希结果
-
-    // 对输入密码进行哈希处理
+std::string HTTPRequest::HashPassword(const std::string& pwd) {
+    static const char HEX[] = "0123456789abcdef";
     unsigned char hash[SHA256_DIGEST_LENGTH];
-    SHA256((unsigned char*)pwd.c_str(), pwd.length(), hash);
-    for(int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
-        sprintf(hashed_pwd + (i * 2), "%02x", hash[i]);
-    }
-
-    if (is_login) {
-        const char* query = "SELECT password FROM user WHERE username=? LIMIT 1";
-        stmt = mysql_stmt_init(sql);
-        if (!stmt) {
-            LOG_ERROR("mysql_stmt_init failed.");
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        if (mysql_stmt_prepare(stmt, query, strlen(query))) {
-            LOG_ERROR("mysql_stmt_prepare failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-        
-        // 绑定用户名参数
-        memset(bind, 0, sizeof(bind));
-        bind[0].buffer_type = MYSQL_TYPE_STRING;
-        bind[0].buffer = const_cast<char*>(name.c_str());
-        bind[0].buffer_length = name.length();
-
-        if (mysql_stmt_bind_param(stmt, bind)) {
-            LOG_ERROR("mysql_stmt_bind_param failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        if (mysql_stmt_execute(stmt)) {
-            LOG_ERROR("mysql_stmt_execute failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        // 绑定查询结果
-        memset(result_bind, 0, sizeof(result_bind));
-        char db_pwd[256] = {0};
-        unsigned long length = 0;
-        result_bind[0].buffer_type = MYSQL_TYPE_STRING;
-        result_bind[0].buffer = db_pwd;
-        result_bind[0].buffer_length = sizeof(db_pwd);
-        result_bind[0].length = &length;
-
-        if (mysql_stmt_bind_result(stmt, result_bind)) {
-            LOG_ERROR("mysql_stmt_bind_result failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        if (mysql_stmt_fetch(stmt) == 0) {
-            if (strcmp(hashed_pwd, db_pwd) == 0) {
-                flag = true;
-                LOG_INFO("User Login sucessful.");
-            } else {
-                LOG_WARN("User password incorrect.");
-            }
-        } else {
-            LOG_WARN("User not found.");
-        }
-        mysql_stmt_close(stmt);
-    } else {
-        // 注册用户
-        const char* check_query = "SELECT username FROM user WHERE username=? LIMIT 1";
-        stmt = mysql_stmt_init(sql);
-        if (!stmt) {
-            LOG_ERROR("mysql_stmt_init failed!");
-            return false;
-        }
-
-        if (mysql_stmt_prepare(stmt, check_query, strlen(check_query))) {
-            LOG_ERROR("mysql_stmt_prepare failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        memset(bind, 0, sizeof(bind));
-        // 绑定用户名参数
-        bind[0].buffer_type = MYSQL_TYPE_STRING;
-        bind[0].buffer = const_cast<char*>(name.c_str());
-        bind[0].buffer_length = name.length();
-
-        if (mysql_stmt_bind_param(stmt, bind)) {
-            LOG_ERROR("mysql_stmt_bind_param failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        // 执行查询
-        if (mysql_stmt_execute(stmt)) {
-            LOG_ERROR("mysql_stmt_execute failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        // 绑定结果
-        memset(result_bind, 0, sizeof(result_bind));
-        char db_username[50] = {0};
-        unsigned long length = 0;
-
-        result_bind[0].buffer_type = MYSQL_TYPE_STRING;
-        result_bind[0].buffer = db_username;
-        result_bind[0].buffer_length = sizeof(db_username);
-        result_bind[0].length = &length;
-
-        if (mysql_stmt_bind_result(stmt, result_bind)) {
-            LOG_ERROR("mysql_stmt_bind_result failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        // 检查是否有结果
-        if (mysql_stmt_fetch(stmt) == 0) {
-            // 用户名已存在，不能注册
-            LOG_DEBUG("Username: %s already exists!", name);
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        mysql_stmt_close(stmt);
-
-        // 插入新用户
-        const char* insert_query = "INSERT INTO user(username, password) VALUES(?, ?)";
-        stmt = mysql_stmt_init(sql);
-        if (!stmt) {
-            LOG_ERROR("mysql_stmt_init failed!");
-            return false;
-        }
-
-        if (mysql_stmt_prepare(stmt, insert_query, strlen(insert_query))) {
-            LOG_ERROR("mysql_stmt_prepare failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        memset(bind, 0, sizeof(bind));
-        // 绑定用户名参数
-        bind[0].buffer_type = MYSQL_TYPE_STRING;
-        bind[0].buffer = (char*)name.c_str();
-        bind[0].buffer_length = name.length();
-
-        // 绑定密码参数
-        bind[1].buffer_type = MYSQL_TYPE_STRING;
-        bind[1].buffer = hashed_pwd;
-        bind[1].buffer_length = strlen(hashed_pwd);
-
-        if (mysql_stmt_bind_param(stmt, bind)) {
-            LOG_ERROR("mysql_stmt_bind_param failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        // 执行插入
-        if (mysql_stmt_execute(stmt)) {
-            LOG_ERROR("mysql_stmt_execute failed: %s", mysql_stmt_error(stmt));
-            mysql_stmt_close(stmt);
-            return false;
-        }
-
-        mysql_stmt_close(stmt);
-        flag = true;
-        LOG_DEBUG("User registered successfully!");
+    SHA256((const unsigned char*)pwd.c_str(), pwd.length(), hash);
+    std::string hashed(SHA256_DIGEST_LENGTH * 2, '0');
+    for (int i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
+        hashed[i * 2] = HEX[hash[i] >> 4];
+        hashed[i * 2 + 1] = HEX[hash[i] & 0xf];
     }
-
-    return flag;
+    return hashed;
 }
 
 int HTTPRequest::ConvertHex(char ch) {
@@ -10,27 +10,27 @@
 
 #include "../log/log.h"
 #include "../buffer/buffer.h"
-#include "../pool/db_connect_pool.h"
-#include "../pool/db_connect_pool_RAII.h"
+#include "../store/user_store.h"
 
 #include <unordered_set>
 #include <unordered_map>
-#include <regex>
+#include <string_view>
 #include <errno.h>
 
 class HTTPRequest{
 public:
     /**
      * @brief 
-     * HTTP Request 解析，包括请求行、首部行、请求体和结束状态。
+     * HTTP Request 解析，包括请求行、首部行、请求体、结束状态与报文格式错误。
      */
-    enum PARSE_STATE {REQUEST_LINE, HEADER, BODY, FINISH};
+    enum PARSE_STATE {REQUEST_LINE, HEADER, BODY, FINISH, INVALID};
 
     HTTPRequest();
     ~HTTPRequest() = default;
 
     void Init();
-    bool Parse(Buffer& buffer);                                         // 从缓冲区中解析
+    bool Parse(Buffer& buffer);                                         // 从缓冲区中增量解析，报文格式错误时返回false
+    bool IsFinish() const;                                              // 是否已解析出完整请求
 
     std::string& GetPath();                                             // 返回请求路径
     std::string GetPath() const;                                        // 重载版本
@@ -39,21 +39,36 @@ public:
     std::string GetVersion() const;                                     // HTTP协议版本
     std::string GetPost(const std::string& key) const;                  // 返回post方法中指定键的值
     std::string GetPost(const char* key) const;                         // 重载版本    
+    bool HasPost(const std::string& key) const;                         // post方法中是否含有指定键，不存在时不记录日志
+    std::string GetHeader(const std::string& key) const;                // 返回指定首部字段的值(字段名不区分大小写)
+    std::string GetCookie(const std::string& name) const;               // 返回Cookie首部中指定名称的值
 
     bool IsKeepAlive() const;                                           // 是否维持长连接
+    bool IsDBRequest() const;                                           // 已解析完成且需要访问数据库(登录、注册)
+    bool IsLoginRequest() const;                                        // 待执行的验证为登录
+    bool VerifyUser(UserStore* store);                                  // 在用户存储上执行登录或注册，并将路径改为结果页面
+    void SetVerifyResult(bool is_verified);                             // 由验证结果将路径改为结果页面
+    bool GetVerifyUser(std::string* name, std::string* hashed_pwd, bool* is_login) const;   // 待验证的用户，为空时返回false
+
+    static const size_t MAX_LINE_LEN = 8192;                            // 请求行与首部行的最大长度
+    static const size_t MAX_BODY_LEN = 1 << 20;                         // 请求体的最大长度
 
 private:
-    bool ParseRequestLine(const std::string& line);                     // 解析请求行
-    void ParseHeader(const std::string& line);                          // 解析首部行
-    void ParseBody(const std::string& line);                            // 解析请求体
+    bool ParseRequestLine(std::string_view line);                       // 解析请求行
+    bool ParseHeader(std::string_view line);                            // 解析首部行
+    void ParseBody(std::string_view body);                              // 解析请求体
     void ParsePath();                                                   // 解析请求路径
     void ParsePost();                                                   // 解析post请求路径
     void ParseFromUrlEncoded();                                         // 处理url编码
 
-    static bool UserVerify(const std::string& name, const std::string& pwd, bool is_login);
+    static std::string HashPassword(const std::string& pwd);            // 密码的SHA-256十六进制串
     static int ConvertHex(char ch);                                     // 将一个字符转换为十六进制数
 
     PARSE_STATE state_;                                                 // 解析状态 
+    size_t scan_pos_;                                                   // 当前未完成行中已扫描过的长度，下次读取后从此处继续查找行尾
+    size_t content_len_;                                                // Content-Length
+    bool is_keep_alive_;                                                // 是否保持连接(HTTP/1.1默认保持，Connection首部可覆盖)
+    int verify_tag_;                                                    // 待执行的用户验证，-1:无，0:注册，1:登录
     std::string method_;                                                // 请求方法
     std::string path_;                                                  // 请求路径
     std::string version_;                                               // 协议版本
@@ -39,13 +39,25 @@ const unordered_map<string, string> HTTPResponse::SUFFIX_TYPE_ = {
     { ".tar",   "application/x-tar" },
     { ".css",   "text/css" },
     { ".js",    "text/javascript" },
+    { ".mp4",   "video/mp4" },
+    { ".webm",  "video/webm" },
+    { ".mp3",   "audio/mpeg" },
+    { ".svg",   "image/svg+xml" },
+    { ".json",  "application/json" },
+    { ".woff",  "font/woff" },
+    { ".woff2", "font/woff2" },
+    { ".ttf",   "font/ttf" },
+    { ".eot",   "application/vnd.ms-fontobject" },
 };
 
 const unordered_map<int, string> HTTPResponse::CODE_STATUS_ = {
     { 200, "OK" },
+    { 206, "Partial Content" },
+    { 304, "Not Modified" },
     { 400, "Bad Request" },
     { 403, "Forbidden" },
     { 404, "Not Found" },
+    { 416, "Range Not Satisfiable" },
 };
 
 const unordered_map<int, string> HTTPResponse::CODE_PATH_ = {
@@ -58,8 +70,9 @@ HTTPResponse::HTTPResponse(): code_(-1),
                               is_keep_alive_(false), 
                               path_(""), 
                               src_dir_(""), 
-                              mmfile_ptr_(nullptr), 
-                              mmfile_stat_{0} {}
+                              file_path_(""),
+                              file_(nullptr),
+                              is_vary_(false) {}
 
 HTTPResponse::~HTTPResponse() {
     UnmapFilePtr();
@@ -69,28 +82,73 @@ void HTTPResponse::Init(const std::string& src_dir, const std::string& path, boo
     if (src_dir.empty()) {
         LOG_ERROR("HTTP Response: source directroy path error.");
     }
-    if (mmfile_ptr_) {
-        UnmapFilePtr();
-    }
+    UnmapFilePtr();
     code_ = code;
     path_ = path;
     src_dir_ = src_dir;
+    file_path_.clear();
     is_keep_alive_ = is_keep_alive;
-    mmfile_ptr_ = nullptr;
-    mmfile_stat_ = {0};
+    range_.clear();
+    if_range_.clear();
+    if_none_match_.clear();
+    if_modified_since_.clear();
+    accept_encoding_.clear();
+    set_cookie_.clear();
+    encoding_.clear();
+    mime_.clear();
+    is_vary_ = false;
+    ranges_.clear();
 }
 
-void HTTPResponse::GenerateResponse(Buffer& buffer) {
-    std::string file_path = src_dir_ + path_;
+void HTTPResponse::SetRange(const std::string& range, const std::string& if_range) {
+    range_ = range;
+    if_range_ = if_range;
+}
+
+void HTTPResponse::SetCondition(const std::string& if_none_match, const std::string& if_modified_since) {
+    if_none_match_ = if_none_match;
+    if_modified_since_ = if_modified_since;
+}
 
-    if (stat(file_path.data(), &mmfile_stat_) < 0 || S_ISDIR(mmfile_stat_.st_mode)) {
+void HTTPResponse::SetAcceptEncoding(const std::string& accept_encoding) {
+    accept_encoding_ = accept_encoding;
+}
+
+void HTTPResponse::SetCookie(const std::string& cookie) {
+    set_cookie_ = cookie;
+}
+
+void HTTPResponse::GenerateResponse(Buffer& buffer) {
+    if (code_ >= 400) {
+        // 请求报文本身有误，直接返回对应的错误页面
+    } else if (!ResolvePath()) {
+        // 规范化后越出资源目录
+        LOG_DEBUG("HTTP Response: Path %s is outside source directory.", path_.c_str());
+        code_ = 400;
+    } else if (!(file_ = FileCache::GetFileCacheInstance().Get(file_path_))->is_exist || S_ISDIR(file_->st.st_mode)) {
         code_ = 404;
-    } else if (!(mmfile_stat_.st_mode & S_IROTH)) {
+    } else if (!(file_->st.st_mode & S_IROTH)) {
         code_ = 403;
     } else if (code_ == -1) {
         code_ = 200;
     }
 
+    if (code_ == 200) {
+        // 选择压缩副本，此后的条件请求与Range均针对选中的副本
+        Negotiate();
+    }
+
+    if (code_ == 200 && IsNotModified()) {
+        code_ = 304;
+    } else if (code_ == 200 && !range_.empty() && S_ISREG(file_->st.st_mode)) {
+        // If-Range不匹配时忽略Range，返回完整文件
+        if (if_range_.empty() || if_range_ == file_->etag || if_range_ == file_->last_modified) {
+            if (ParseRange(file_->st.st_size, ranges_)) {
+                code_ = ranges_.empty() ? 416 : 206;
+            }
+        }
+    }
+
     ErrorHtml();
 
     AddStateLine(buffer);
@@ -98,24 +156,39 @@ void HTTPResponse::GenerateResponse(Buffer& buffer) {
 
     if (code_ == 200) {
         AddContent(buffer);
+    } else if (code_ == 206) {
+        AddRangeContent(buffer);
+    } else if (code_ == 304) {
+        // 304响应没有实体
+        buffer.Append(file_->validator + "\r\n");
+        UnmapFilePtr();
     } else {
+        // 错误响应的实体已写入缓冲区，不再另行发送文件
+        UnmapFilePtr();
         ErrorContent(buffer, CODE_STATUS_.find(code_)->second);
     }
 }
 
+// 释放对缓存项的引用，描述符由缓存项的最后一个持有者关闭
 void HTTPResponse::UnmapFilePtr() {
-    if (mmfile_ptr_) {
-        munmap(mmfile_ptr_, mmfile_stat_.st_size);
-        mmfile_ptr_ = nullptr;
-    }
+    file_.reset();
+    parts_.clear();
 }
 
-char* HTTPResponse::GetFilePtr() {
-    return mmfile_ptr_;
+int HTTPResponse::GetFileFd() const {
+    return file_ ? file_->fd : -1;
 }
 
 size_t HTTPResponse::GetFileLen() const {
-    return mmfile_stat_.st_size;
+    return file_ && file_->fd >= 0 ? file_->st.st_size : 0;
+}
+
+const std::vector<FilePart>& HTTPResponse::GetFileParts() const {
+    return parts_;
+}
+
+std::shared_ptr<const FileEntry> HTTPResponse::GetFile() const {
+    return file_;
 }
 
 void HTTPResponse::ErrorContent(Buffer& buffer, std::string message) {
@@ -134,9 +207,7 @@ void HTTPResponse::ErrorContent(Buffer& buffer, std::string message) {
     body += "<p>" + message + "</p>";
     body += "<hr><em>WebServer</em></body></html>";
 
-    buffer.Append("HTTP/1.1 " + to_string(code_) + " " + status + "\r\n");
-    buffer.Append("Content-Type: text/html\r\n");
-    buffer.Append("Connection: close\r\n");
+    // 状态行、Connection与Content-Type已由AddStateLine、AddHeader写入
     buffer.Append("Content-Length: " + to_string(body.size()) + "\r\n");
     buffer.Append("\r\n");
     buffer.Append(body);
@@ -146,18 +217,29 @@ int HTTPResponse::GetCode() const {
     return code_;
 }
 
+bool HTTPResponse::IsKeepAlive() const {
+    return is_keep_alive_;
+}
+
 void HTTPResponse::ErrorHtml() {
     if (CODE_PATH_.count(code_)) {
         path_ = CODE_PATH_.find(code_)->second;
-        std::string file_path = src_dir_ + path_;
-        if (stat(file_path.data(), &mmfile_stat_) < 0) {
+        file_ = FileCache::GetFileCacheInstance().Get(src_dir_ + path_);
+        if (!file_->is_exist) {
             code_ = 404;
             path_ = "/404.html";
-            stat((src_dir_ + path_).data(), &mmfile_stat_);
+            file_ = FileCache::GetFileCacheInstance().Get(src_dir_ + path_);
         }
     }
 }
 
+// 以规范化后的路径访问缓存，与inotify失效时的路径一致；规范化后不在资源目录下的路径返回false
+bool HTTPResponse::ResolvePath() {
+    file_path_ = FileCache::NormalizePath(src_dir_ + path_);
+    auto relative = std::filesystem::path(file_path_).lexically_relative(FileCache::NormalizePath(src_dir_));
+    return !relative.empty() && *relative.begin() != "..";
+}
+
 void HTTPResponse::AddStateLine(Buffer& buffer) {
     string status;
     if (CODE_STATUS_.count(code_)) {
@@ -179,47 +261,265 @@ void HTTPResponse::AddHeader(Buffer& buffer) {
     }
     buffer.Append("Date: " + GetCurrentTime() + "\r\n");
     // buffer.Append("Last-Modified: " + GetLastModifiedTime() + "\r\n");
-    buffer.Append("Content-Type: " + GetFileType() + "\r\n");
+    if (code_ == 416) {
+        buffer.Append("Content-Range: bytes */" + to_string(file_->st.st_size) + "\r\n");
+    }
+    if (!set_cookie_.empty()) {
+        buffer.Append("Set-Cookie: " + set_cookie_ + "\r\n");
+    }
+    if (is_vary_) {
+        buffer.Append("Vary: Accept-Encoding\r\n");
+    }
+    if (!encoding_.empty() && (code_ == 200 || code_ == 206)) {
+        buffer.Append("Content-Encoding: " + encoding_ + "\r\n");
+    }
+    if (code_ >= 400) {
+        // 成功响应的Content-Type随实体首部一起输出，错误响应的实体为html页面
+        buffer.Append("Content-Type: text/html\r\n");
+    }
 }
 
 void HTTPResponse::AddContent(Buffer& buffer) {
-    // 打开目标文件
-    int src_fd = open((src_dir_ + path_).data(), O_RDONLY);
-    if (src_fd < 0) {
-        // 文件打开失败，返回错误内容并记录日志
+    if (!file_ || (file_->fd < 0 && file_->st.st_size > 0)) {
+        // 文件无法打开
+        buffer.Append("Content-Type: text/html\r\n");
         ErrorContent(buffer, "File Not Found.");
         LOG_ERROR("HTTP Response: File path %s not found.", (src_dir_ + path_).data());
         return;
     }
-    
-    // 将文件映射到内存，提高访问速度
-    void* mm_ptr = mmap(0, mmfile_stat_.st_size, PROT_READ, MAP_PRIVATE, src_fd, 0);
-    if (mm_ptr == MAP_FAILED) {
-        // 如果内存映射失败，关闭文件描述符并返回错误内容
-        close(src_fd);
-        ErrorContent(buffer, "File Not Found.");
-        LOG_ERROR("HTTP Response: Failed to map file %s.", (src_dir_ + path_).data());
+
+    // Content-Type与Content-Length由缓存项预先生成，实体不拷贝到缓冲区，由连接使用sendfile从描述符发送
+    buffer.Append("Accept-Ranges: bytes\r\n");
+    buffer.Append(file_->validator);
+    if (encoding_.empty()) {
+        buffer.Append(file_->header + "\r\n");
+    } else {
+        // 压缩副本的预生成首部中是副本自身的类型，需使用原文件的类型
+        buffer.Append("Content-Type: " + mime_ + "\r\n");
+        buffer.Append("Content-Length: " + to_string(file_->st.st_size) + "\r\n\r\n");
+    }
+    if (file_->fd >= 0 && file_->st.st_size > 0) {
+        parts_.push_back({"", 0, static_cast<size_t>(file_->st.st_size)});
+    }
+
+    LOG_DEBUG("HTTP Response: File %s, size: %ld bytes.", (src_dir_ + path_).data(), file_->st.st_size);
+}
+
+/**
+ * @brief
+ * 206响应：单个区间直接发送文件片段；多个区间使用multipart/byteranges，各段首部放在FilePart::head中
+ */
+void HTTPResponse::AddRangeContent(Buffer& buffer) {
+    std::string size = to_string(file_->st.st_size);
+    buffer.Append("Accept-Ranges: bytes\r\n");
+    buffer.Append(file_->validator);
+
+    if (ranges_.size() == 1) {
+        off_t first = ranges_[0].first, last = ranges_[0].second;
+        buffer.Append("Content-Type: " + mime_ + "\r\n");
+        buffer.Append("Content-Range: bytes " + to_string(first) + "-" + to_string(last) + "/" + size + "\r\n");
+        buffer.Append("Content-Length: " + to_string(last - first + 1) + "\r\n\r\n");
+        parts_.push_back({"", first, static_cast<size_t>(last - first + 1)});
+        return;
+    }
+
+    static thread_local std::mt19937_64 engine(std::random_device{}());
+    char boundary[17];
+    snprintf(boundary, sizeof(boundary), "%016llx", static_cast<unsigned long long>(engine()));
+
+    size_t content_len = 0;
+    for (const auto& [first, last] : ranges_) {
+        std::string head = "\r\n--" + std::string(boundary) + "\r\n"
+                         + "Content-Type: " + mime_ + "\r\n"
+                         + "Content-Range: bytes " + to_string(first) + "-" + to_string(last) + "/" + size + "\r\n\r\n";
+        content_len += head.size() + (last - first + 1);
+        parts_.push_back({std::move(head), first, static_cast<size_t>(last - first + 1)});
+    }
+    std::string tail = "\r\n--" + std::string(boundary) + "--\r\n";
+    content_len += tail.size();
+    parts_.push_back({std::move(tail), 0, 0});
+
+    buffer.Append("Content-Type: multipart/byteranges; boundary=" + std::string(boundary) + "\r\n");
+    buffer.Append("Content-Length: " + to_string(content_len) + "\r\n\r\n");
+}
+
+/**
+ * @brief
+ * 解析Range首部(bytes=0-99,200-,-500)
+ * @return false表示格式错误或区间过多，应忽略Range；返回true且ranges为空表示没有可满足的区间(416)
+ * 重叠或相邻的区间合并，避免重复发送同一段数据
+ */
+bool HTTPResponse::ParseRange(off_t size, std::vector<std::pair<off_t, off_t>>& ranges) {
+    std::string_view spec(range_);
+    if (spec.substr(0, 6) != "bytes=") {
+        return false;
+    }
+    spec.remove_prefix(6);
+
+    auto trim = [](std::string_view sv) {
+        while (!sv.empty() && (sv.front() == ' ' || sv.front() == '\t')) sv.remove_prefix(1);
+        while (!sv.empty() && (sv.back() == ' ' || sv.back() == '\t')) sv.remove_suffix(1);
+        return sv;
+    };
+    auto to_num = [](std::string_view sv, off_t& num) {
+        auto [ptr, ec] = std::from_chars(sv.data(), sv.data() + sv.size(), num);
+        return !sv.empty() && ec == std::errc() && ptr == sv.data() + sv.size();
+    };
+
+    ranges.clear();
+    size_t cnt = 0;
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view item = trim(spec.substr(0, comma));
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+        if (item.empty()) continue;
+        if (++cnt > MAX_RANGES) {
+            return false;
+        }
+
+        size_t dash = item.find('-');
+        if (dash == std::string_view::npos) {
+            return false;
+        }
+        std::string_view first_sv = item.substr(0, dash), last_sv = item.substr(dash + 1);
+        off_t first = 0, last = 0;
+        if (first_sv.empty()) {
+            // 后缀区间：最后N个字节
+            if (!to_num(last_sv, last)) return false;
+            if (last == 0 || size == 0) continue;
+            ranges.emplace_back(std::max<off_t>(0, size - last), size - 1);
+        } else {
+            if (!to_num(first_sv, first)) return false;
+            if (last_sv.empty()) {
+                last = size - 1;
+            } else if (!to_num(last_sv, last) || last < first) {
+                return false;
+            }
+            if (first >= size) continue;
+            ranges.emplace_back(first, std::min<off_t>(last, size - 1));
+        }
+    }
+    if (cnt == 0) {
+        return false;
+    }
+
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<std::pair<off_t, off_t>> merged;
+    for (const auto& range : ranges) {
+        if (!merged.empty() && range.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, range.second);
+        } else {
+            merged.push_back(range);
+        }
+    }
+    ranges.swap(merged);
+    return true;
+}
+
+/**
+ * @brief
+ * 条件请求判断：存在If-None-Match时只比较ETag(弱比较，忽略W/前缀)，否则比较If-Modified-Since与修改时间
+ */
+bool HTTPResponse::IsNotModified() const {
+    if (!if_none_match_.empty()) {
+        std::string_view list(if_none_match_);
+        while (!list.empty()) {
+            size_t comma = list.find(',');
+            std::string_view tag = list.substr(0, comma);
+            list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+            while (!tag.empty() && (tag.front() == ' ' || tag.front() == '\t')) tag.remove_prefix(1);
+            while (!tag.empty() && (tag.back() == ' ' || tag.back() == '\t')) tag.remove_suffix(1);
+            if (tag.substr(0, 2) == "W/") tag.remove_prefix(2);
+            if (tag == "*" || tag == file_->etag) {
+                return true;
+            }
+        }
+        return false;
+    }
+    time_t since;
+    if (!if_modified_since_.empty() && ParseHttpDate(if_modified_since_, since)) {
+        return file_->st.st_mtime <= since;
+    }
+    return false;
+}
+
+/**
+ * @brief
+ * 内容协商：按Accept-Encoding中的q值选择zstd或gzip副本(q值相同时优先zstd)
+ * 副本不存在、不可读或早于原文件时发送原文件
+ */
+void HTTPResponse::Negotiate() {
+    mime_ = file_->mime;
+    if (!S_ISREG(file_->st.st_mode) || !Precompressor::IsCompressible(mime_)) {
+        return;
+    }
+    is_vary_ = true;
+    if (accept_encoding_.empty()) {
         return;
     }
 
-    // 将内存映射结果转换为字符指针，方便处理
-    mmfile_ptr_ = static_cast<char*>(mm_ptr);
-    
-    // 关闭文件描述符，因为文件已被映射到内存
-    close(src_fd);
+    Precompressor::ENCODING order[2] = {Precompressor::ZSTD, Precompressor::GZIP};
+    double q[2] = {GetQValue(accept_encoding_, "zstd"), GetQValue(accept_encoding_, "gzip")};
+    if (q[1] > q[0]) {
+        std::swap(order[0], order[1]);
+        std::swap(q[0], q[1]);
+    }
+    for (int i = 0; i < 2; ++i) {
+        if (q[i] <= 0) continue;
+        auto variant = FileCache::GetFileCacheInstance().Get(file_path_ + Precompressor::GetSuffix(order[i]));
+        if (variant->is_exist && S_ISREG(variant->st.st_mode) && variant->fd >= 0 &&
+            variant->st.st_mtime >= file_->st.st_mtime) {
+            file_ = variant;
+            encoding_ = Precompressor::GetName(order[i]);
+            return;
+        }
+    }
+}
+
+double HTTPResponse::GetQValue(const std::string& accept, const std::string& coding) {
+    double wildcard_q = 0;
+    std::string_view list(accept);
+    while (!list.empty()) {
+        size_t comma = list.find(',');
+        std::string_view item = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        size_t semi = item.find(';');
+        std::string_view name = item.substr(0, semi);
+        while (!name.empty() && (name.front() == ' ' || name.front() == '\t')) name.remove_prefix(1);
+        while (!name.empty() && (name.back() == ' ' || name.back() == '\t')) name.remove_suffix(1);
 
-    buffer.Append("Content-Length: " + to_string(mmfile_stat_.st_size) + "\r\n\r\n");
-    buffer.Append(mmfile_ptr_, mmfile_stat_.st_size);
-    
-    LOG_INFO("HTTP Response: File %s successfully mapped, size: %ld bytes.", (src_dir_ + path_).data(), mmfile_stat_.st_size);
+        double value = 1;
+        if (semi != std::string_view::npos) {
+            std::string param(item.substr(semi + 1));
+            size_t pos = param.find("q=");
+            if (pos != std::string::npos) {
+                value = strtod(param.c_str() + pos + 2, nullptr);
+            }
+        }
+        auto equal = [](std::string_view a, std::string_view b) {
+            return a.size() == b.size() && strncasecmp(a.data(), b.data(), a.size()) == 0;
+        };
+        if (equal(name, coding) || (coding == "gzip" && equal(name, "x-gzip"))) {
+            return value;
+        }
+        if (name == "*") {
+            wildcard_q = value;
+        }
+    }
+    return wildcard_q;
 }
 
 std::string HTTPResponse::GetFileType() {
-    string::size_type idx = path_.find_last_of('.');
+    return GetMimeType(path_);
+}
+
+std::string HTTPResponse::GetMimeType(const std::string& path) {
+    string::size_type idx = path.find_last_of('.');
     if (idx == string::npos) {
         return "text/plain";
     }
-    string suffix = path_.substr(idx);
+    string suffix = path.substr(idx);
     if (SUFFIX_TYPE_.count(suffix)) {
         return SUFFIX_TYPE_.find(suffix)->second;
     }
@@ -227,10 +527,24 @@ std::string HTTPResponse::GetFileType() {
 }
 
 std::string HTTPResponse::GetCurrentTime() {
-    time_t now = time(0);
-    tm* gmt_time = gmtime(&now);
-    char buf[128];                     
-    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", gmt_time);
-    
+    return FormatHttpDate(time(0));
+}
+
+std::string HTTPResponse::FormatHttpDate(time_t t) {
+    tm gmt_time;
+    gmtime_r(&t, &gmt_time);
+    char buf[128];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &gmt_time);
+
     return std::string(buf);
 }
+
+bool HTTPResponse::ParseHttpDate(const std::string& date, time_t& t) {
+    tm gmt_time = {};
+    const char* end = strptime(date.c_str(), "%a, %d %b %Y %H:%M:%S GMT", &gmt_time);
+    if (end == nullptr || *end != '\0') {
+        return false;
+    }
+    t = timegm(&gmt_time);
+    return true;
+}
@@ -10,34 +10,70 @@
 
 #include "../buffer/buffer.h"
 #include "../log/log.h"
+#include "file_cache.h"
+#include "precompress.h"
 
 #include <unordered_map>
 #include <fcntl.h>
 #include <unistd.h>
+#include <strings.h>
 #include <sys/stat.h>
-#include <sys/mman.h>
 #include <string>
 #include <fstream>
+#include <memory>
+#include <vector>
+#include <random>
+#include <charconv>
+#include <algorithm>
 #include <ctime>
 
+/**
+ * @brief
+ * 实体中的一段：先发送head(multipart分隔行与段首部)，再从文件offset处发送len字节
+ */
+struct FilePart {
+    std::string head;                                                        // 文件数据之前发送的内容
+    off_t offset;                                                            // 文件偏移
+    size_t len;                                                              // 文件数据长度
+};
+
 class HTTPResponse {
 public:
     HTTPResponse();
     ~HTTPResponse();
 
     void Init(const std::string& src_dir, const std::string& path, bool is_keep_alive = false, int code = -1);
+    void SetRange(const std::string& range, const std::string& if_range);   // 设置Range与If-Range首部
+    void SetCondition(const std::string& if_none_match, const std::string& if_modified_since);  // 设置条件请求首部
+    void SetAcceptEncoding(const std::string& accept_encoding);             // 设置Accept-Encoding首部
+    void SetCookie(const std::string& cookie);                              // 设置Set-Cookie首部
     void GenerateResponse(Buffer& buffer);
     void UnmapFilePtr();
-    char* GetFilePtr();
+    int GetFileFd() const;
     size_t GetFileLen() const;
+    const std::vector<FilePart>& GetFileParts() const;                      // 由文件发送的实体各段
+    std::shared_ptr<const FileEntry> GetFile() const;                       // 实体文件的缓存项
     void ErrorContent(Buffer& buffer, std::string message);
     int GetCode() const;
+    bool IsKeepAlive() const;
+
+    static std::string GetMimeType(const std::string& path);                 // 按后缀获取MIME类型
+    static std::string FormatHttpDate(time_t t);                             // 格式化为HTTP日期
+    static bool ParseHttpDate(const std::string& date, time_t& t);           // 解析HTTP日期
+    static double GetQValue(const std::string& accept, const std::string& coding);  // Accept-Encoding中指定编码的q值
+
+    static const size_t MAX_RANGES = 16;                                     // 单个请求最多的区间数，超出时忽略Range
 
 private:
     void ErrorHtml();
     void AddStateLine(Buffer &buffer);
     void AddHeader(Buffer &buffer);
     void AddContent(Buffer &buffer);
+    void AddRangeContent(Buffer &buffer);
+    bool ParseRange(off_t size, std::vector<std::pair<off_t, off_t>>& ranges);
+    bool IsNotModified() const;
+    void Negotiate();
+    bool ResolvePath();
 
     std::string GetFileType();
     std::string GetCurrentTime();
@@ -46,8 +82,19 @@ private:
     bool is_keep_alive_;                                                     // 是否保持连接
     std::string path_;                                                       // 请求资源路径
     std::string src_dir_;                                                    // 资源存储目录
-    char* mmfile_ptr_;                                                       // 内存映射文件指针
-    struct stat mmfile_stat_;                                                // 文件信息结构
+    std::string file_path_;                                                  // 规范化后的文件路径，作为缓存键
+    std::shared_ptr<const FileEntry> file_;                                  // 缓存的文件项，实体由sendfile发送，发送完成前持有引用
+    std::string range_;                                                      // Range首部
+    std::string if_range_;                                                   // If-Range首部
+    std::string if_none_match_;                                              // If-None-Match首部
+    std::string if_modified_since_;                                          // If-Modified-Since首部
+    std::string accept_encoding_;                                            // Accept-Encoding首部
+    std::string set_cookie_;                                                 // Set-Cookie首部，为空时不输出
+    std::string encoding_;                                                   // 选中的内容编码，为空时发送原文件
+    std::string mime_;                                                       // 原文件的MIME类型
+    bool is_vary_;                                                           // 资源存在压缩副本的可能，需输出Vary
+    std::vector<std::pair<off_t, off_t>> ranges_;                            // 请求的区间[first, last]
+    std::vector<FilePart> parts_;                                            // 由文件发送的实体各段
 
     static const std::unordered_map<std::string, std::string> SUFFIX_TYPE_;  // 类型后缀映射
     static const std::unordered_map<int, std::string> CODE_STATUS_;          // 状态码映射
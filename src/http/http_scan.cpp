@@ -0,0 +1,210 @@
+/**
+ * @file http_scan.cpp
+ * @author chenyinjie
+ * @date 2024-10-26
+ * @copyright Apache 2.0
+ */
+
+#include "http_scan.h"
+
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HTTP_SCAN_X86 1
+#endif
+
+namespace {
+
+using ScanFunc = const char* (*)(const char*, const char*);
+
+// 每种实现的一组扫描函数
+struct ScanTable {
+    HTTPScan::KERNEL kernel;
+    const char* name;
+    ScanFunc form_special;
+    ScanFunc invalid_value;
+};
+
+inline bool IsFormSpecial(char ch) {
+    return ch == '%' || ch == '+' || ch == '&' || ch == '=';
+}
+
+inline bool IsInvalidValue(char ch) {
+    unsigned char c = static_cast<unsigned char>(ch);
+    return (c < 0x20 && c != '\t') || c == 0x7f;
+}
+
+// ================= 逐字节实现 ================= //
+const char* ScalarFormSpecial(const char* begin, const char* end) {
+    while (begin < end && !IsFormSpecial(*begin)) ++begin;
+    return begin;
+}
+
+const char* ScalarInvalidValue(const char* begin, const char* end) {
+    while (begin < end && !IsInvalidValue(*begin)) ++begin;
+    return begin;
+}
+
+const ScanTable SCALAR_TABLE = {
+    HTTPScan::SCALAR, "scalar", ScalarFormSpecial, ScalarInvalidValue
+};
+
+#ifdef HTTP_SCAN_X86
+// ================= SSE4.2实现 ================= //
+// pcmpestri一次比较16字节与最多16个候选字符(或字符区间)，返回第一个匹配位置，无匹配时返回16
+
+template <int MODE>
+__attribute__((target("sse4.2")))
+inline const char* Sse42Find(const char* begin, const char* end, __m128i needle, int needle_len) {
+    const int flags = _SIDD_UBYTE_OPS | MODE | _SIDD_LEAST_SIGNIFICANT;
+    while (end - begin >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        int idx = _mm_cmpestri(needle, needle_len, block, 16, flags);
+        if (idx < 16) return begin + idx;
+        begin += 16;
+    }
+    if (begin < end) {
+        // 尾部不足16字节时拷贝到栈上，避免越界读取
+        alignas(16) char tail[16] = {0};
+        int len = static_cast<int>(end - begin);
+        memcpy(tail, begin, len);
+        __m128i block = _mm_load_si128(reinterpret_cast<const __m128i*>(tail));
+        int idx = _mm_cmpestri(needle, needle_len, block, len, flags);
+        if (idx < len) return begin + idx;
+    }
+    return end;
+}
+
+__attribute__((target("sse4.2")))
+const char* Sse42FormSpecial(const char* begin, const char* end) {
+    return Sse42Find<_SIDD_CMP_EQUAL_ANY>(begin, end, _mm_setr_epi8('%', '+', '&', '=', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), 4);
+}
+
+__attribute__((target("sse4.2")))
+const char* Sse42InvalidValue(const char* begin, const char* end) {
+    // 区间 [0x00, 0x08] [0x0a, 0x1f] [0x7f, 0x7f]
+    return Sse42Find<_SIDD_CMP_RANGES>(begin, end, _mm_setr_epi8(0x00, 0x08, 0x0a, 0x1f, 0x7f, 0x7f, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0), 6);
+}
+
+const ScanTable SSE42_TABLE = {
+    HTTPScan::SSE42, "sse4.2", Sse42FormSpecial, Sse42InvalidValue
+};
+
+// ================= AVX2实现 ================= //
+// 每次加载32字节，与各候选字符逐一比较后合并为位掩码，取最低位得到第一个匹配位置
+
+template <typename MATCH>
+__attribute__((target("avx2,bmi")))
+inline const char* Avx2Find(const char* begin, const char* end, MATCH match, ScanFunc tail) {
+    while (end - begin >= 32) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(match(block)));
+        if (mask != 0) return begin + _tzcnt_u32(mask);
+        begin += 32;
+    }
+    return tail(begin, end);
+}
+
+__attribute__((target("avx2,bmi")))
+const char* Avx2FormSpecial(const char* begin, const char* end) {
+    const __m256i percent = _mm256_set1_epi8('%');
+    const __m256i plus = _mm256_set1_epi8('+');
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i eq = _mm256_set1_epi8('=');
+    return Avx2Find(begin, end, [=](__m256i block) __attribute__((target("avx2"))) {
+        __m256i m0 = _mm256_or_si256(_mm256_cmpeq_epi8(block, percent), _mm256_cmpeq_epi8(block, plus));
+        __m256i m1 = _mm256_or_si256(_mm256_cmpeq_epi8(block, amp), _mm256_cmpeq_epi8(block, eq));
+        return _mm256_or_si256(m0, m1);
+    }, Sse42FormSpecial);
+}
+
+__attribute__((target("avx2,bmi")))
+const char* Avx2InvalidValue(const char* begin, const char* end) {
+    const __m256i ctl_max = _mm256_set1_epi8(0x1f);
+    const __m256i tab = _mm256_set1_epi8('\t');
+    const __m256i del = _mm256_set1_epi8(0x7f);
+    return Avx2Find(begin, end, [=](__m256i block) __attribute__((target("avx2"))) {
+        // 无符号比较 block <= 0x1f 等价于 min(block, 0x1f) == block
+        __m256i ctl = _mm256_cmpeq_epi8(_mm256_min_epu8(block, ctl_max), block);
+        ctl = _mm256_andnot_si256(_mm256_cmpeq_epi8(block, tab), ctl);
+        return _mm256_or_si256(ctl, _mm256_cmpeq_epi8(block, del));
+    }, Sse42InvalidValue);
+}
+
+const ScanTable AVX2_TABLE = {
+    HTTPScan::AVX2, "avx2", Avx2FormSpecial, Avx2InvalidValue
+};
+#endif
+
+const ScanTable* GetTable(HTTPScan::KERNEL kernel) {
+#ifdef HTTP_SCAN_X86
+    if (kernel == HTTPScan::AVX2) return &AVX2_TABLE;
+    if (kernel == HTTPScan::SSE42) return &SSE42_TABLE;
+#endif
+    (void)kernel;
+    return &SCALAR_TABLE;
+}
+
+const ScanTable* Detect() {
+    if (HTTPScan::IsSupported(HTTPScan::AVX2)) return GetTable(HTTPScan::AVX2);
+    if (HTTPScan::IsSupported(HTTPScan::SSE42)) return GetTable(HTTPScan::SSE42);
+    return GetTable(HTTPScan::SCALAR);
+}
+
+std::atomic<const ScanTable*>& Current() {
+    static std::atomic<const ScanTable*> table(Detect());
+    return table;
+}
+
+} // namespace
+
+// 单字符查找直接使用memchr：glibc已按CPU特性选择向量化实现(ifunc)，实测快于本文件的单字符内核
+const char* HTTPScan::FindLineEnd(const char* begin, const char* end) {
+    const void* p = memchr(begin, '\n', end - begin);
+    return p ? static_cast<const char*>(p) : end;
+}
+
+const char* HTTPScan::FindColon(const char* begin, const char* end) {
+    const void* p = memchr(begin, ':', end - begin);
+    return p ? static_cast<const char*>(p) : end;
+}
+
+const char* HTTPScan::FindFormSpecial(const char* begin, const char* end) {
+    return Current().load(std::memory_order_relaxed)->form_special(begin, end);
+}
+
+const char* HTTPScan::FindInvalidValue(const char* begin, const char* end) {
+    return Current().load(std::memory_order_relaxed)->invalid_value(begin, end);
+}
+
+HTTPScan::KERNEL HTTPScan::GetKernel() {
+    return Current().load(std::memory_order_relaxed)->kernel;
+}
+
+const char* HTTPScan::GetKernelName() {
+    return Current().load(std::memory_order_relaxed)->name;
+}
+
+bool HTTPScan::SetKernel(KERNEL kernel) {
+    if (!IsSupported(kernel)) return false;
+    Current().store(GetTable(kernel), std::memory_order_relaxed);
+    return true;
+}
+
+bool HTTPScan::IsSupported(KERNEL kernel) {
+    switch (kernel) {
+        case SCALAR:
+            return true;
+#ifdef HTTP_SCAN_X86
+        case SSE42:
+            return __builtin_cpu_supports("sse4.2");
+        case AVX2:
+            // AVX2实现的尾部使用SSE4.2处理
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("sse4.2");
+#endif
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,37 @@
+/**
+ * @file http_scan.h
+ * @author chenyinjie
+ * @date 2024-10-26
+ * @copyright Apache 2.0
+ */
+
+#ifndef HTTP_SCAN_H
+#define HTTP_SCAN_H
+
+#include <cstddef>
+
+/**
+ * @brief
+ * HTTP报文字节扫描
+ * 所有函数返回[begin, end)中第一个匹配字节的位置，未找到时返回end。
+ * - 单字符查找(行尾、首部分隔符)使用memchr。
+ * - 字符集合查找(表单特殊字符、首部值非法字符)一次比较16(SSE4.2)或32(AVX2)字节，
+ *   运行时根据CPU特性选择实现，不支持时退回逐字节扫描。
+ */
+
+class HTTPScan {
+public:
+    enum KERNEL {SCALAR = 0, SSE42 = 1, AVX2 = 2};
+
+    static const char* FindLineEnd(const char* begin, const char* end);        // 查找'\n'
+    static const char* FindColon(const char* begin, const char* end);          // 查找首部分隔符':'
+    static const char* FindFormSpecial(const char* begin, const char* end);    // 查找'%' '+' '&' '='
+    static const char* FindInvalidValue(const char* begin, const char* end);   // 查找首部值中的非法控制字符(除HTAB外的0x00-0x1f及0x7f)
+
+    static KERNEL GetKernel();                                                 // 当前使用的实现
+    static const char* GetKernelName();
+    static bool SetKernel(KERNEL kernel);                                      // 指定实现(测试与基准使用)，CPU不支持时返回false
+    static bool IsSupported(KERNEL kernel);
+};
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file precompress.cpp
+ * @author chenyinjie
+ * @date 2024-10-30
+ * @copyright Apache 2.0
+ */
+
+#include "precompress.h"
+#include "http_response.h"
+
+Precompressor::Precompressor(): is_stop_(true) {}
+
+Precompressor::~Precompressor() {
+    Stop();
+}
+
+void Precompressor::Start(const std::string& root) {
+    Stop();
+    is_stop_ = false;
+    worker_ = std::thread(&Precompressor::Worker, this, root);
+}
+
+void Precompressor::Stop() {
+    is_stop_ = true;
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+}
+
+void Precompressor::Worker(std::string root) {
+    size_t cnt = 0;
+    std::error_code ec;
+    for (auto iter = std::filesystem::recursive_directory_iterator(root, ec);
+         !ec && iter != std::filesystem::recursive_directory_iterator(); iter.increment(ec)) {
+        if (is_stop_) break;
+        if (!iter->is_regular_file(ec)) continue;
+        std::string path = iter->path().string();
+        cnt += Compress(path, ZSTD);
+        if (is_stop_) break;
+        cnt += Compress(path, GZIP);
+    }
+    LOG_INFO("Precompressor: %zu compressed files generated under %s.", cnt, root.c_str());
+}
+
+/**
+ * @brief
+ * 为src生成压缩副本src.gz或src.zst
+ * 副本已存在且不早于原文件时跳过；压缩后小于原文件90%才写入
+ */
+bool Precompressor::Compress(const std::string& src, ENCODING encoding) {
+    std::string_view name(src);
+    if (name.ends_with(GetSuffix(GZIP)) || name.ends_with(GetSuffix(ZSTD))) {
+        return false;
+    }
+    if (!IsCompressible(HTTPResponse::GetMimeType(src))) {
+        return false;
+    }
+
+    struct stat src_st, dst_st;
+    std::string dst = src + GetSuffix(encoding);
+    if (stat(src.c_str(), &src_st) < 0 || !S_ISREG(src_st.st_mode)) {
+        return false;
+    }
+    if (static_cast<size_t>(src_st.st_size) < MIN_SIZE || static_cast<size_t>(src_st.st_size) > MAX_SIZE) {
+        return false;
+    }
+    if (stat(dst.c_str(), &dst_st) == 0 && dst_st.st_mtime >= src_st.st_mtime) {
+        return false;
+    }
+
+    std::ifstream in(src, std::ios::binary);
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (!in.good() && !in.eof()) {
+        LOG_WARN("Precompressor: Failed to read %s.", src.c_str());
+        return false;
+    }
+
+    std::string out;
+    bool ok = encoding == GZIP ? GzipCompress(data, out) : ZstdCompress(data, out);
+    if (!ok || out.size() * 10 >= data.size() * 9) {
+        return false;
+    }
+
+    std::string tmp = dst + ".tmp";
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), out.size());
+    file.close();
+    if (!file || rename(tmp.c_str(), dst.c_str()) < 0) {
+        LOG_WARN("Precompressor: Failed to write %s, Error: %d.", dst.c_str(), errno);
+        unlink(tmp.c_str());
+        return false;
+    }
+    LOG_DEBUG("Precompressor: %s %zu -> %zu bytes.", dst.c_str(), data.size(), out.size());
+    return true;
+}
+
+bool Precompressor::IsCompressible(const std::string& mime) {
+    return mime.starts_with("text/")
+        || mime == "application/xhtml+xml"
+        || mime == "application/json"
+        || mime == "image/svg+xml"
+        || mime == "application/vnd.ms-fontobject"
+        || mime == "font/ttf";
+}
+
+const char* Precompressor::GetSuffix(ENCODING encoding) {
+    return encoding == GZIP ? ".gz" : ".zst";
+}
+
+const char* Precompressor::GetName(ENCODING encoding) {
+    return encoding == GZIP ? "gzip" : "zstd";
+}
+
+bool Precompressor::GzipCompress(const std::string& in, std::string& out) {
+    z_stream stream = {};
+    // windowBits加16输出gzip格式
+    if (deflateInit2(&stream, GZIP_LEVEL, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+    out.resize(deflateBound(&stream, in.size()));
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    stream.avail_in = in.size();
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = out.size();
+    int ret = deflate(&stream, Z_FINISH);
+    out.resize(stream.total_out);
+    deflateEnd(&stream);
+    return ret == Z_STREAM_END;
+}
+
+bool Precompressor::ZstdCompress(const std::string& in, std::string& out) {
+    out.resize(ZSTD_compressBound(in.size()));
+    size_t len = ZSTD_compress(out.data(), out.size(), in.data(), in.size(), ZSTD_LEVEL);
+    if (ZSTD_isError(len)) {
+        LOG_WARN("Precompressor: zstd error: %s.", ZSTD_getErrorName(len));
+        return false;
+    }
+    out.resize(len);
+    return true;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file precompress.h
+ * @author chenyinjie
+ * @date 2024-10-30
+ * @copyright Apache 2.0
+ */
+
+#ifndef PRECOMPRESS_H
+#define PRECOMPRESS_H
+
+#include "../log/log.h"
+
+#include <zlib.h>
+#include <zstd.h>
+#include <sys/stat.h>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief
+ * 静态资源预压缩
+ * - 为资源目录中可压缩类型(文本、脚本、样式、svg等)的文件生成同目录下的.gz与.zst副本，
+ *   响应时按Accept-Encoding直接发送副本，不在请求路径上压缩。
+ * - 后台线程在启动时遍历资源目录，副本不存在或早于原文件时重新生成；已存在于磁盘上的副本直接使用。
+ * - 副本先写入临时文件再rename，文件缓存通过inotify感知新副本。
+ * - 压缩后体积没有明显减小的文件不生成副本。
+ */
+
+class Precompressor {
+public:
+    enum ENCODING {GZIP = 0, ZSTD = 1};
+
+    Precompressor();
+    ~Precompressor();
+
+    Precompressor(const Precompressor&) = delete;
+    Precompressor& operator=(const Precompressor&) = delete;
+
+    void Start(const std::string& root);                                    // 启动后台压缩线程
+    void Stop();                                                            // 停止并等待后台线程退出
+
+    static bool Compress(const std::string& src, ENCODING encoding);        // 为单个文件生成副本，未生成时返回false
+    static bool IsCompressible(const std::string& mime);                    // MIME类型是否值得压缩
+    static const char* GetSuffix(ENCODING encoding);                        // 副本后缀
+    static const char* GetName(ENCODING encoding);                          // Content-Encoding取值
+
+    static const size_t MIN_SIZE = 1024;                                    // 小于该大小的文件不压缩
+    static const size_t MAX_SIZE = 16 << 20;                                // 大于该大小的文件不压缩
+    static const int GZIP_LEVEL = 9;
+    static const int ZSTD_LEVEL = 19;
+
+private:
+    void Worker(std::string root);
+
+    static bool GzipCompress(const std::string& in, std::string& out);
+    static bool ZstdCompress(const std::string& in, std::string& out);
+
+    std::atomic<bool> is_stop_;                                             // 停止标志
+    std::thread worker_;                                                    // 后台压缩线程
+};
+
+#endif
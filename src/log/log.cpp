@@ -13,7 +13,16 @@ Log::Log(): is_async_log_(false),
             max_queue_size_(0),
             max_lines_(50000),
             file_expire_(30),
-            cnt_lines_(0) {}
+            cnt_lines_(0),
+            log_fd_(-1),
+            overflow_(LOG_OVERFLOW::DROP),
+            drop_cnt_(0),
+            global_level_(LOG_MIN_LEVEL) {
+    for (int i = 0; i < MODULE_NUMS; ++i) {
+        is_module_set_[i] = false;
+        module_levels_[i].store(global_level_, std::memory_order_relaxed);
+    }
+}
 
 Log::~Log() {
     Close();
@@ -29,29 +38,114 @@ void Log::WriteWorker() {
 }
 
 void Log::AsyncWriteLog() {
-    std::string log_str;
-    while (msg_deque_->PopFront(log_str)) {
-        if (!log_str.empty()) {
-            std::lock_guard<std::mutex> locker(log_mtx_);
-            if (is_closed_) break;
-            log_file_stream_ << log_str << std::endl;
-            cnt_lines_ += 1;
-            std::tm cur_tm = GetCurTime();
-            if (cnt_lines_ != 0 && (cnt_lines_ % max_lines_ == 0 || cur_tm.tm_mday != today_)) {
-                BuildLogFile(cur_tm);
-            }
+    // 批次中的字符串与队列槽位交换内存，两者轮流作为缓冲区，不拷贝日志内容
+    std::vector<std::string> batch(BATCH_LINES);
+    for (auto& log_str : batch) {
+        log_str.reserve(SLOT_RESERVE);
+    }
+    size_t n = 0;
+    size_t reported = 0;
+    bool is_woken = false;
+    auto interval = std::chrono::milliseconds(FLUSH_INTERVAL_MS);
+    auto deadline = std::chrono::steady_clock::now() + interval;
+    // 队列槽位过半时提前醒来，避免写入间隔内队列被写满
+    size_t wake_lines = std::clamp<size_t>(msg_ring_->GetCapacity() / 2, 1, BATCH_LINES);
+
+    // 关闭后继续取出队列中剩余的日志，取空后退出
+    while (true) {
+        // 先读关闭标志再取队列，关闭前入队的日志一定在本轮取出
+        bool is_closed = msg_ring_->IsClosed();
+        while (n < BATCH_LINES && msg_ring_->TryPop(batch[n])) {
+            ++n;
+        }
+        bool is_drained = (n < BATCH_LINES);
+        auto now = std::chrono::steady_clock::now();
+        if (n >= wake_lines || is_woken || is_closed || now >= deadline) {
+            WriteBatch(batch, n);
+            ReportDrop(reported);
+            n = 0;
+            is_woken = false;
+            deadline = now + interval;
+            if (!is_drained) continue;
+            if (is_closed) break;
         }
+        auto timeout = std::chrono::ceil<std::chrono::milliseconds>(deadline - now);
+        is_woken = msg_ring_->Wait(timeout, wake_lines - n);
     }
-    Flush();
 }
 
-bool Log::Init(int max_lines, bool is_async, int max_queue_size, int file_expire) {
+void Log::WriteLine(const std::string& log_str) {
+    iovec iov{const_cast<char*>(log_str.data()), log_str.size()};
+    WriteFile(&iov, 1);
+    cnt_lines_ += 1;
+    std::tm cur_tm = GetCurTime();
+    if (cnt_lines_ != 0 && (cnt_lines_ % max_lines_ == 0 || cur_tm.tm_mday != today_)) {
+        BuildLogFile(cur_tm);
+    }
+}
+
+void Log::WriteBatch(std::vector<std::string>& batch, size_t n) {
+    if (n == 0) return;
+    std::lock_guard<std::mutex> locker(log_mtx_);
+    std::tm cur_tm = GetCurTime();
+    if (cur_tm.tm_mday != today_) {
+        BuildLogFile(cur_tm);
+    }
+    iovec iov[BATCH_LINES];
+    int cnt = 0;
+    for (size_t i = 0; i < n; ++i) {
+        iov[cnt].iov_base = batch[i].data();
+        iov[cnt].iov_len = batch[i].size();
+        ++cnt;
+        cnt_lines_ += 1;
+        // 达到单个文件最大行数时，先写入已收集的部分再切换文件
+        if (cnt_lines_ % max_lines_ == 0) {
+            WriteFile(iov, cnt);
+            cnt = 0;
+            BuildLogFile(cur_tm);
+        }
+    }
+    WriteFile(iov, cnt);
+}
+
+void Log::WriteFile(iovec* iov, int cnt) {
+    while (cnt > 0 && log_fd_ >= 0) {
+        ssize_t len = writev(log_fd_, iov, cnt);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            std::cerr << "Log write failed: " << strerror(errno) << std::endl;
+            return;
+        }
+        while (cnt > 0 && static_cast<size_t>(len) >= iov->iov_len) {
+            len -= iov->iov_len;
+            ++iov;
+            --cnt;
+        }
+        if (cnt > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + len;
+            iov->iov_len -= len;
+        }
+    }
+}
+
+void Log::ReportDrop(size_t& reported) {
+    size_t dropped = drop_cnt_.load(std::memory_order_relaxed);
+    if (dropped == reported) return;
+    std::string log_msg = std::format("{} [WARN]: Log: Queue full, dropped {} messages (total {}).\n",
+                                      GetLogPrefix(), dropped - reported, dropped);
+    reported = dropped;
+    std::lock_guard<std::mutex> locker(log_mtx_);
+    WriteLine(log_msg);
+}
+
+bool Log::Init(int max_lines, bool is_async, int max_queue_size, int file_expire, LOG_OVERFLOW overflow) {
     log_file_path_ = std::filesystem::path(PROJECT_ROOT) / "logfiles";
     log_file_name_ = "logfile";
     max_lines_ = max_lines;
     is_async_log_ = is_async;
     max_queue_size_ = max_queue_size;
     file_expire_ = file_expire;
+    overflow_ = overflow;
 
     if (!std::filesystem::exists(log_file_path_)) {
         std::filesystem::create_directories(log_file_path_);
@@ -66,7 +160,7 @@ bool Log::Init(int max_lines, bool is_async, int max_queue_size, int file_expire
         return false;
     }
 
-    if (!log_file_stream_.is_open()) {
+    if (log_fd_ < 0) {
         std::cerr << "Log system Init failed: open file failed." << std::endl;
         return false;
     }
@@ -74,14 +168,14 @@ bool Log::Init(int max_lines, bool is_async, int max_queue_size, int file_expire
     // 是否启用异步
     if (is_async_log_ && max_queue_size_ > 0) {
         try {
-            msg_deque_ = std::make_unique<BlockDeque<std::string>>(max_queue_size_);
+            msg_ring_ = std::make_unique<MPSCRing<std::string>>(max_queue_size_, SLOT_RESERVE);
         } catch(const std::exception& e) {
-            std::cerr << "Init BlockQueue failed: %s" << e.what() << std::endl;
+            std::cerr << "Init log ring failed: " << e.what() << std::endl;
             return false;
         }
     }
 
-    if (is_async_log_ && msg_deque_) {
+    if (is_async_log_ && msg_ring_) {
         try {
             log_async_thread_ = std::make_unique<std::thread>(&Log::WriteWorker);
         } catch (const std::exception& e) {
@@ -94,9 +188,9 @@ bool Log::Init(int max_lines, bool is_async, int max_queue_size, int file_expire
 
 void Log::BuildLogFile(std::tm cur_tm) {
     if (cnt_lines_ % max_lines_ == 0 || today_ != cur_tm.tm_mday) {
-        if (log_file_stream_.is_open()) {
-            log_file_stream_.flush();
-            log_file_stream_.close();
+        if (log_fd_ >= 0) {
+            close(log_fd_);
+            log_fd_ = -1;
         }
         if (today_ != cur_tm.tm_mday) {
             today_ = cur_tm.tm_mday;
@@ -111,7 +205,7 @@ void Log::BuildLogFile(std::tm cur_tm) {
                                         cnt_lines_ / max_lines_ + 1
                                         );
         std::filesystem::path file_path = log_file_path_ / new_log_file_name;
-        log_file_stream_.open(file_path, std::ios::out | std::ios::app);
+        log_fd_ = open(file_path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
     }
 }
 
@@ -149,7 +243,7 @@ std::string Log::FormatString(const char* format, va_list args) {
 }
 
 void Log::WriteLog(int level, const char* format, ...) {
-    static const char* LogLevels[] = { "[INFO]:", "[DEBUG]:", "[WARN]:", "[ERROR]:" };
+    static const char* LogLevels[] = { "[DEBUG]:", "[INFO]:", "[WARN]:", "[ERROR]:" };
     const char* log_level_description = (level >= 0 && level <= 3) ? LogLevels[level] : "[INFO]:";
 
     std::string msg_time_prefix = GetLogPrefix();
@@ -159,19 +253,21 @@ void Log::WriteLog(int level, const char* format, ...) {
     std::string formatted_msg = FormatString(format, valst);
     va_end(valst);
 
-    std::string log_msg = std::format("{} {} {}", msg_time_prefix, log_level_description, formatted_msg);
+    std::string log_msg = std::format("{} {} {}\n", msg_time_prefix, log_level_description, formatted_msg);
     
     if (is_async_log_) {
-        if (!is_closed_) msg_deque_->PushBack(log_msg);
+        if (is_closed_) return;
+        if (overflow_ == LOG_OVERFLOW::BLOCK) {
+            msg_ring_->PushWait(log_msg);
+        } else if (!msg_ring_->TryPush(log_msg)) {
+            drop_cnt_.fetch_add(1, std::memory_order_relaxed);
+        }
+        // ERROR日志不等待攒批，立即写入文件
+        if (level >= 3) msg_ring_->Wake();
     } else {
         std::lock_guard<std::mutex> locker(log_mtx_);
         if (!is_closed_) {
-            log_file_stream_ << log_msg << std::endl;
-            cnt_lines_ += 1;
-            std::tm cur_tm = GetCurTime();
-            if (cnt_lines_ != 0 && (cnt_lines_ % max_lines_ == 0 || cur_tm.tm_mday != today_)) {
-                BuildLogFile(cur_tm);
-            }
+            WriteLine(log_msg);
         }
     }
 }
@@ -191,8 +287,39 @@ void Log::CleanLogs() {
 }
 
 void Log::Flush() {
-    std::lock_guard<std::mutex> lock(log_mtx_);
-    log_file_stream_.flush();
+    if (is_async_log_ && msg_ring_) {
+        msg_ring_->Wake();
+    }
+}
+
+size_t Log::GetDropCount() const {
+    return drop_cnt_.load(std::memory_order_relaxed);
+}
+
+void Log::SetLevel(LOG_LEVEL level) {
+    std::lock_guard<std::mutex> locker(level_mtx_);
+    global_level_ = static_cast<int>(level);
+    for (int i = 0; i < MODULE_NUMS; ++i) {
+        if (!is_module_set_[i]) {
+            module_levels_[i].store(global_level_, std::memory_order_relaxed);
+        }
+    }
+}
+
+void Log::SetModuleLevel(LOG_MODULE module, LOG_LEVEL level) {
+    std::lock_guard<std::mutex> locker(level_mtx_);
+    is_module_set_[static_cast<int>(module)] = true;
+    module_levels_[static_cast<int>(module)].store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Log::ResetModuleLevel(LOG_MODULE module) {
+    std::lock_guard<std::mutex> locker(level_mtx_);
+    is_module_set_[static_cast<int>(module)] = false;
+    module_levels_[static_cast<int>(module)].store(global_level_, std::memory_order_relaxed);
+}
+
+LOG_LEVEL Log::GetLevel(LOG_MODULE module) const {
+    return static_cast<LOG_LEVEL>(module_levels_[static_cast<int>(module)].load(std::memory_order_relaxed));
 }
 
 void Log::Close() {
@@ -201,13 +328,12 @@ void Log::Close() {
         is_closed_ = true;
     }
     if (is_async_log_ && log_async_thread_ && log_async_thread_->joinable()) {
-        msg_deque_->Flush();
-        msg_deque_->Close();
+        msg_ring_->Close();
         log_async_thread_->join();
     }
     std::lock_guard<std::mutex> locker(log_mtx_);
-    if (log_file_stream_.is_open()) {
-        log_file_stream_.flush();
-        log_file_stream_.close();
+    if (log_fd_ >= 0) {
+        close(log_fd_);
+        log_fd_ = -1;
     }
 }
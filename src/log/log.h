@@ -9,13 +9,16 @@
 #define LOG_H
 
 
-#include "block_queue.h"
+#include "mpsc_ring.h"
 
 #include <iostream>
 #include <string>
 #include <vector>
+#include <atomic>
 #include <thread>
 #include <ctime>
+#include <climits>
+#include <cstring>
 #include <chrono>
 #include <cstdarg>
 #include <memory>
@@ -23,10 +26,75 @@
 #include <format>
 #include <fstream>
 #include <filesystem>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+/**
+ * @brief
+ * 日志级别，由低到高，低于当前级别的日志在格式化之前被过滤
+ */
+enum class LOG_LEVEL {
+    DEBUG = 0,
+    INFO = 1,
+    WARN = 2,
+    ERROR = 3
+};
+
+/**
+ * @brief
+ * 日志模块，可为每个模块单独设置日志级别
+ * 日志宏所在源文件的上级目录名即模块名(src/http/xxx.cpp属于HTTP)，在编译期确定
+ */
+enum class LOG_MODULE {
+    OTHER = 0,
+    BUFFER,
+    CONFIG,
+    EPOLL,
+    HTTP,
+    LOG,
+    POOL,
+    SERVER,
+    STORE,
+    TIMER,
+    COUNT
+};
+
+inline constexpr const char* LOG_MODULE_NAMES[] = {
+    "other", "buffer", "config", "epoll", "http", "log", "pool", "server", "store", "timer"
+};
+
+// 由源文件路径取得所属模块，未知目录归为OTHER
+constexpr LOG_MODULE GetLogModule(std::string_view file) {
+    size_t end = file.find_last_of('/');
+    if (end == std::string_view::npos || end == 0) return LOG_MODULE::OTHER;
+    size_t begin = file.find_last_of('/', end - 1);
+    begin = (begin == std::string_view::npos) ? 0 : begin + 1;
+    std::string_view dir = file.substr(begin, end - begin);
+    for (int i = 1; i < static_cast<int>(LOG_MODULE::COUNT); ++i) {
+        if (dir == LOG_MODULE_NAMES[i]) return static_cast<LOG_MODULE>(i);
+    }
+    return LOG_MODULE::OTHER;
+}
+
+/**
+ * @brief
+ * 异步日志队列已满时的处理策略
+ * - DROP: 丢弃新日志并计数，请求线程不等待。
+ * - BLOCK: 请求线程等待写入线程腾出槽位，日志不丢失。
+ */
+enum class LOG_OVERFLOW {
+    DROP = 0,
+    BLOCK = 1
+};
 
 /**
  * @brief 
  * 单例模式设计的同步/异步日志系统
+ * 异步模式下日志写入无锁环形队列，由写入线程成批取出，每批一次writev写入文件：
+ * 攒满一批、距上次写入超过写入间隔、出现ERROR日志或关闭时写入
+ * 同步模式下每条日志直接write写入文件，不经过用户态缓冲
  */
 
 class Log {
@@ -37,10 +105,22 @@ public:
     static Log& GetLogInstance();                               // 获取日志单例
     static void WriteWorker();                                  // 异步线程调用函数
 
-    bool Init(int max_lines = 50000, bool is_async = false, int max_queue_size = 1024, int file_expire = 30);
+    bool Init(int max_lines = 50000, bool is_async = false, int max_queue_size = 1024, int file_expire = 30,
+              LOG_OVERFLOW overflow = LOG_OVERFLOW::DROP);
     void WriteLog(int level, const char* format, ...);          // 写入日志
-    void Flush();                                               // 刷新日志
+    void Flush();                                               // 异步模式下唤醒写入线程立即写入已缓冲的日志
     void Close();                                               // 关闭日志
+    size_t GetDropCount() const;                                // 队列已满被丢弃的日志数
+
+    void SetLevel(LOG_LEVEL level);                             // 设置全局日志级别，不影响单独设置过级别的模块
+    void SetModuleLevel(LOG_MODULE module, LOG_LEVEL level);    // 单独设置模块的日志级别
+    void ResetModuleLevel(LOG_MODULE module);                   // 模块恢复使用全局日志级别
+    LOG_LEVEL GetLevel(LOG_MODULE module = LOG_MODULE::OTHER) const;
+
+    // 日志宏在格式化之前调用，只有一次原子读取
+    bool IsEnabled(int level, LOG_MODULE module) const {
+        return level >= module_levels_[static_cast<int>(module)].load(std::memory_order_relaxed);
+    }
 
 private:
     Log();
@@ -51,6 +131,10 @@ private:
     std::string GetLogPrefix();                                  // 获取日志消息时间前缀
     std::string FormatString(const char* format, va_list args);  // 格式化字符串                                   
     void CleanLogs();                                            // 过期日志清理函数
+    void WriteLine(const std::string& log_str);                  // 写入一行并按需轮换日志文件，调用方持有log_mtx_
+    void WriteBatch(std::vector<std::string>& batch, size_t n);  // 一次writev写入一批日志，按需轮换日志文件
+    void WriteFile(iovec* iov, int cnt);                         // 写完全部数据，处理部分写入与信号中断
+    void ReportDrop(size_t& reported);                           // 丢弃计数变化时写入一条告警
 
 
     bool is_async_log_;                                          // 是否异步写入日志
@@ -67,22 +151,57 @@ private:
     int file_expire_;                                            // 日志过期时间设置
     int cnt_lines_;                                              // 当前日志行数
     
-    std::fstream log_file_stream_;                               // 日志文件流
-    std::unique_ptr<BlockDeque<std::string>> msg_deque_;         // 日志消息阻塞队列
+    int log_fd_;                                                 // 日志文件描述符
+    std::unique_ptr<MPSCRing<std::string>> msg_ring_;            // 日志消息无锁环形队列
+    LOG_OVERFLOW overflow_;                                      // 队列已满时的处理策略
+    std::atomic<size_t> drop_cnt_;                               // 队列已满被丢弃的日志数
+
+    static const int MODULE_NUMS = static_cast<int>(LOG_MODULE::COUNT);
+    std::mutex level_mtx_;                                       // 日志级别设置互斥锁
+    int global_level_;                                           // 全局日志级别
+    bool is_module_set_[MODULE_NUMS];                            // 模块是否单独设置过级别
+    std::atomic<int> module_levels_[MODULE_NUMS];                // 各模块生效的日志级别
     std::unique_ptr<std::thread> log_async_thread_;              // 日志异步工作线程
+
+    static const size_t SLOT_RESERVE = 256;                      // 队列槽位预分配的字节数
+    static const size_t BATCH_LINES = IOV_MAX;                   // 每批最多写入的日志行数，一行对应一个iovec
+    static const int FLUSH_INTERVAL_MS = 1000;                   // 写入线程的最长写入间隔
 };
 
-// 日志级别大于 2 时刷新文件流
+// 低于所属模块日志级别的日志直接返回，不取时间也不格式化
+// ERROR日志由WriteLog自行触发写入，其余级别随批次写入
 #define LOG_BASE(level, format, ...) \
     do {\
+        constexpr LOG_MODULE log_module = GetLogModule(__FILE__);\
         Log* log = &Log::GetLogInstance();\
-        log->WriteLog(level, format, ##__VA_ARGS__); \
-        if (level >= 2) log->Flush();\
+        if (log->IsEnabled(level, log_module)) {\
+            log->WriteLog(level, format, ##__VA_ARGS__); \
+        }\
     } while(0);
 
-#define LOG_INFO(format, ...) do {LOG_BASE(0, format, ##__VA_ARGS__)} while(0);
-#define LOG_DEBUG(format, ...) do {LOG_BASE(1, format, ##__VA_ARGS__)} while(0);
+// 编译期最低日志级别，低于该级别的日志宏展开为空语句，由编译选项-DLOG_MIN_LEVEL=n指定
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
+
+#if LOG_MIN_LEVEL <= 0
+#define LOG_DEBUG(format, ...) do {LOG_BASE(0, format, ##__VA_ARGS__)} while(0);
+#else
+#define LOG_DEBUG(format, ...) do {} while(0);
+#endif
+
+#if LOG_MIN_LEVEL <= 1
+#define LOG_INFO(format, ...) do {LOG_BASE(1, format, ##__VA_ARGS__)} while(0);
+#else
+#define LOG_INFO(format, ...) do {} while(0);
+#endif
+
+#if LOG_MIN_LEVEL <= 2
 #define LOG_WARN(format, ...) do {LOG_BASE(2, format, ##__VA_ARGS__)} while(0);
+#else
+#define LOG_WARN(format, ...) do {} while(0);
+#endif
+
 #define LOG_ERROR(format, ...) do {LOG_BASE(3, format, ##__VA_ARGS__)} while(0);
 
 #endif  // LOG_H_
\ No newline at end of file
@@ -0,0 +1,195 @@
+/**
+ * @file mpsc_ring.h
+ * @author chenyinjie
+ * @date 2024-11-10
+ * @copyright Apache 2.0
+ */
+
+#ifndef MPSC_RING_H
+#define MPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+/**
+ * @brief
+ * 有界无锁环形队列，多生产者-单消费者
+ * - 槽位在构造时一次分配，容量向上取整为2的幂；每个槽位带序号，生产者以CAS抢占写入位置，
+ *   写完后发布序号，消费者按序号判断槽位是否可读(Vyukov有界队列)。
+ * - 生产者入队不加锁；消费者休眠时指定唤醒所需的元素数，只有写入该位置的生产者才加锁唤醒它，
+ *   消费者可以攒够一批再醒来。
+ * - 队列满时TryPush立即返回false，由调用方决定丢弃还是调用PushWait自旋等待。
+ */
+
+template <typename T>
+class MPSCRing {
+public:
+    explicit MPSCRing(size_t min_capacity = 1024, size_t slot_reserve = 0);
+    ~MPSCRing();
+
+    MPSCRing(const MPSCRing&) = delete;
+    MPSCRing& operator=(const MPSCRing&) = delete;
+
+    bool TryPush(const T& item);                                // 队列满或已关闭时返回false
+    bool PushWait(const T& item);                               // 队列满时让出CPU直到有空槽位，关闭后返回false
+    bool TryPop(T& item);                                       // 仅由消费者线程调用，队列空时返回false
+    bool Wait(std::chrono::milliseconds timeout, size_t min_items = 1); // 消费者休眠直到可读元素达到min_items、被唤醒、关闭或超时，被Wake唤醒时返回true
+    void Wake();                                                // 唤醒消费者，消费者未休眠时下一次Wait立即返回
+
+    void Close();
+    bool IsClosed() const noexcept;
+    size_t GetCapacity() const noexcept;
+
+private:
+    // 每个槽位独占缓存行，相邻槽位的生产者之间不产生伪共享
+    struct alignas(64) Slot {
+        std::atomic<size_t> seq;                                // 等于写入位置时可写，等于写入位置+1时可读
+        T data;
+    };
+
+    bool IsReadable(size_t pos) const noexcept;
+    void Notify();
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+
+    alignas(64) std::atomic<size_t> tail_;                      // 下一个写入位置，生产者共享
+    alignas(64) size_t head_;                                   // 下一个读取位置，消费者独占
+
+    alignas(64) std::atomic<size_t> wake_at_;                   // 消费者休眠时等待的写入位置+1，未休眠时为最大值
+    std::atomic<bool> is_woken_;                                // 是否被Wake唤醒
+    std::atomic<bool> is_closed_;
+    std::mutex wait_mtx_;
+    std::condition_variable wait_con_var_;
+
+    static constexpr size_t NOT_WAITING = std::numeric_limits<size_t>::max();
+};
+
+template <typename T>
+MPSCRing<T>::MPSCRing(size_t min_capacity, size_t slot_reserve)
+    : tail_(0), head_(0), wake_at_(NOT_WAITING), is_woken_(false), is_closed_(false) {
+    if (min_capacity == 0) {
+        throw std::invalid_argument("MPSCRing's capacity must be greater than zero.");
+    }
+    size_t capacity = 1;
+    while (capacity < min_capacity) capacity <<= 1;
+    mask_ = capacity - 1;
+
+    slots_ = std::make_unique<Slot[]>(capacity);
+    for (size_t i = 0; i < capacity; ++i) {
+        slots_[i].seq.store(i, std::memory_order_relaxed);
+        if constexpr (requires(T& data) { data.reserve(slot_reserve); }) {
+            if (slot_reserve > 0) slots_[i].data.reserve(slot_reserve);
+        }
+    }
+}
+
+template <typename T>
+MPSCRing<T>::~MPSCRing() {
+    Close();
+}
+
+template <typename T>
+bool MPSCRing<T>::TryPush(const T& item) {
+    if (is_closed_.load(std::memory_order_relaxed)) return false;
+
+    size_t pos = tail_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[pos & mask_];
+        size_t seq = slot->seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;  // 槽位仍未被消费者读走，队列已满
+        } else {
+            pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+    // 赋值复用槽位已有的内存，不重新分配
+    slot->data = item;
+    // 发布与对wake_at_的读取均为seq_cst，与Wait配对：
+    // 要么消费者看到该位置已发布，要么生产者看到消费者在等待该位置
+    slot->seq.store(pos + 1, std::memory_order_seq_cst);
+    if (pos + 1 >= wake_at_.load(std::memory_order_seq_cst)) {
+        Notify();
+    }
+    return true;
+}
+
+template <typename T>
+bool MPSCRing<T>::PushWait(const T& item) {
+    while (!TryPush(item)) {
+        if (is_closed_.load(std::memory_order_relaxed)) return false;
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+template <typename T>
+bool MPSCRing<T>::TryPop(T& item) {
+    Slot& slot = slots_[head_ & mask_];
+    if (slot.seq.load(std::memory_order_acquire) != head_ + 1) return false;
+    // 交换而非移动，槽位保留调用方缓冲区的内存供下一轮写入
+    std::swap(item, slot.data);
+    slot.seq.store(head_ + mask_ + 1, std::memory_order_release);
+    ++head_;
+    return true;
+}
+
+template <typename T>
+bool MPSCRing<T>::Wait(std::chrono::milliseconds timeout, size_t min_items) {
+    std::unique_lock<std::mutex> locker(wait_mtx_);
+    size_t pos = head_ + std::clamp<size_t>(min_items, 1, mask_ + 1) - 1;
+    wake_at_.store(pos + 1, std::memory_order_seq_cst);
+    if (!IsReadable(pos) && !is_woken_.load(std::memory_order_seq_cst) && !is_closed_.load(std::memory_order_seq_cst)) {
+        wait_con_var_.wait_for(locker, timeout);
+    }
+    wake_at_.store(NOT_WAITING, std::memory_order_relaxed);
+    return is_woken_.exchange(false, std::memory_order_acquire);
+}
+
+template <typename T>
+void MPSCRing<T>::Wake() {
+    is_woken_.store(true, std::memory_order_seq_cst);
+    if (wake_at_.load(std::memory_order_seq_cst) != NOT_WAITING) {
+        Notify();
+    }
+}
+
+template <typename T>
+void MPSCRing<T>::Close() {
+    is_closed_.store(true, std::memory_order_seq_cst);
+    Notify();
+}
+
+template <typename T>
+bool MPSCRing<T>::IsClosed() const noexcept {
+    return is_closed_.load(std::memory_order_relaxed);
+}
+
+template <typename T>
+size_t MPSCRing<T>::GetCapacity() const noexcept {
+    return mask_ + 1;
+}
+
+template <typename T>
+bool MPSCRing<T>::IsReadable(size_t pos) const noexcept {
+    return slots_[pos & mask_].seq.load(std::memory_order_seq_cst) == pos + 1;
+}
+
+template <typename T>
+void MPSCRing<T>::Notify() {
+    std::lock_guard<std::mutex> locker(wait_mtx_);
+    wait_con_var_.notify_one();
+}
+
+#endif
@@ -17,9 +17,16 @@ int main(int argc, char* argv[]) {
 
     std::cout << "============= Server starting =============" << std::endl;
     std::cout << "PORT: " << config.PORT << std::endl;
-    std::cout << "Log mode: " << (config.ASYNC_MODE == 1 ? "Asynchronous" : "Synchronous") << std::endl;
+    std::cout << "Log mode: " << (config.ASYNC_MODE == 0 ? "Synchronous" : (config.ASYNC_MODE == 1 ? "Asynchronous, drop when full" : "Asynchronous, block when full")) << std::endl;
     std::cout << "SQL connection pool size: " << config.DB_CONNECT_NUMS << std::endl;
     std::cout << "Thread pool size: " << config.THREAD_NUMS << std::endl;
+    std::cout << "Sub reactor nums: " << config.REACTOR_NUMS << std::endl;
+    std::cout << "Event backend: " << (config.IO_BACKEND == 1 ? "io_uring" : "epoll") << std::endl;
+    std::cout << "Precompress: " << (config.PRECOMPRESS == 1 ? "on" : "off") << std::endl;
+    std::cout << "Timer: " << (config.TIMER_MODE == 1 ? "timing wheel" : "heap") << std::endl;
+    std::cout << "Database mode: " << (config.DB_ASYNC == 1 ? "nonblocking" : "executor") << ", threads: " << config.DB_THREAD_NUMS << std::endl;
+    std::cout << "User store: " << (config.USER_STORE == 1 ? "local mmap" : "mysql") << std::endl;
+    std::cout << "Log level: " << config.LOG_LEVEL << std::endl;
 
     enum class TRIGGERMODE {
     BOTH_LT = 0,      // 连接事件和监听事件均使用LT模式
@@ -37,11 +44,20 @@ int main(int argc, char* argv[]) {
     const char* database = "WebServer";
     const int dbconnectnums = config.DB_CONNECT_NUMS;
     const int threadnums = config.THREAD_NUMS;
-    const bool isasync = (config.ASYNC_MODE == 1);
-    const int blockqueuesize = 128;
-    const int timeout = 0;
+    const bool isasync = (config.ASYNC_MODE != 0);
+    const int logoverflow = (config.ASYNC_MODE == 2) ? 1 : 0;
+    const int blockqueuesize = 4096;
+    const int timeout = 60000;
+    const int reactornums = config.REACTOR_NUMS;
+    const int eventbackend = config.IO_BACKEND;
+    const bool isprecompress = (config.PRECOMPRESS == 1);
+    const int timertype = config.TIMER_MODE;
+    const int dbthreadnums = config.DB_THREAD_NUMS;
+    const bool isdbasync = (config.DB_ASYNC == 1);
+    const int userstore = config.USER_STORE;
+    const int loglevel = config.LOG_LEVEL;
 
-    WebServer server(port, triggermode, islinger, dbport, username, password, database, dbconnectnums, threadnums, isasync, blockqueuesize, timeout);
+    WebServer server(port, triggermode, islinger, dbport, username, password, database, dbconnectnums, threadnums, isasync, blockqueuesize, timeout, reactornums, eventbackend, isprecompress, timertype, dbthreadnums, isdbasync, userstore, logoverflow, loglevel);
     server.Start();
     
     return 0;
@@ -0,0 +1,390 @@
+/**
+ * @file async_sql_pool.cpp
+ * @author chenyinjie
+ * @date 2024-11-05
+ * @copyright Apache 2.0
+ */
+
+#include "async_sql_pool.h"
+
+AsyncSQLPool::AsyncSQLPool(const char* host, const char* user, const char* password, const char* db_name, int db_port,
+                           int connect_nums, int loop_nums, size_t queue_size, int timeout_ms)
+    : host_(host), user_(user), password_(password), db_name_(db_name), db_port_(db_port), queue_size_(queue_size),
+      timeout_(timeout_ms), is_stop_(false), ready_cnt_(0), next_loop_(0) {
+#ifndef ASYNC_SQL_SUPPORTED
+    LOG_ERROR("Async SQL Pool: MySQL client library does not support nonblocking API.");
+    throw std::runtime_error("MySQL client library does not support nonblocking API.");
+#endif
+    if (connect_nums <= 0 || loop_nums <= 0) {
+        LOG_ERROR("Async SQL Pool: Invalid connect nums: %d, loop nums: %d.", connect_nums, loop_nums);
+        throw std::invalid_argument("Invalid number of async sql connections.");
+    }
+    if (timeout_ms <= 0) {
+        LOG_ERROR("Async SQL Pool: Invalid timeout: %d ms.", timeout_ms);
+        throw std::invalid_argument("Invalid async sql timeout.");
+    }
+    loop_nums = std::min(loop_nums, connect_nums);
+    for (int i = 0; i < loop_nums; ++i) {
+        auto loop = std::make_unique<Loop>();
+        loop->backend = CreateEventBackend(EVENT_BACKEND::EPOLL);
+        loop->wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (loop->wakeup_fd < 0 || !loop->backend->AddFd(loop->wakeup_fd, EPOLLIN, WAKEUP_DATA)) {
+            LOG_ERROR("Async SQL Pool: Failed to create wakeup eventfd, Error: %d.", errno);
+            if (loop->wakeup_fd >= 0) close(loop->wakeup_fd);
+            for (auto& created : loops_) close(created->wakeup_fd);
+            throw std::runtime_error("Async SQL Pool: Failed to create wakeup eventfd.");
+        }
+        // 连接平均分配到各事件循环
+        loop->connects.resize(connect_nums / loop_nums + (i < connect_nums % loop_nums ? 1 : 0));
+        loops_.emplace_back(std::move(loop));
+    }
+    for (auto& loop : loops_) {
+        loop->thread = std::thread(&AsyncSQLPool::Run, this, loop.get());
+    }
+    LOG_INFO("Async SQL Pool: Init with %d connects, %d loops.", connect_nums, loop_nums);
+}
+
+AsyncSQLPool::~AsyncSQLPool() {
+    is_stop_ = true;
+    for (auto& loop : loops_) {
+        uint64_t one = 1;
+        if (write(loop->wakeup_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+            LOG_WARN("Async SQL Pool: Failed to wake up loop, Error: %d.", errno);
+        }
+    }
+    for (auto& loop : loops_) {
+        if (loop->thread.joinable()) loop->thread.join();
+        close(loop->wakeup_fd);
+    }
+}
+
+bool AsyncSQLPool::Submit(std::string query, Callback callback) {
+    if (is_stop_ || loops_.empty()) return false;
+    Loop* loop = loops_[next_loop_.fetch_add(1, std::memory_order_relaxed) % loops_.size()].get();
+    {
+        std::lock_guard<std::mutex> locker(loop->mtx);
+        if (loop->jobs.size() >= queue_size_) {
+            LOG_WARN("Async SQL Pool: Job queue is full.");
+            return false;
+        }
+        loop->jobs.push_back({std::move(query), std::move(callback), std::chrono::steady_clock::now() + timeout_});
+    }
+    uint64_t one = 1;
+    if (write(loop->wakeup_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_WARN("Async SQL Pool: Failed to wake up loop, Error: %d.", errno);
+    }
+    return true;
+}
+
+int AsyncSQLPool::GetReadyConnectNums() const {
+    return ready_cnt_.load(std::memory_order_relaxed);
+}
+
+void AsyncSQLPool::Run(Loop* loop) {
+    for (size_t i = 0; i < loop->connects.size(); ++i) {
+        StartConnect(loop, i);
+    }
+    while (!is_stop_) {
+        int event_cnt = loop->backend->EpollWait(GetWaitTime(loop));
+        for (int i = 0; i < event_cnt; ++i) {
+            uint64_t data = loop->backend->GetEventData(i);
+            if (data == WAKEUP_DATA) {
+                uint64_t cnt = 0;
+                while (read(loop->wakeup_fd, &cnt, sizeof(cnt)) > 0) {}
+            } else if (data < loop->connects.size()) {
+                Drive(loop, data);
+            }
+        }
+        // 到期重连；套接字尚未建立的连接无法等待事件，每轮主动推进
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < loop->connects.size(); ++i) {
+            Connect& conn = loop->connects[i];
+            if (conn.state == BROKEN && now >= conn.retry_time) {
+                StartConnect(loop, i);
+            } else if (conn.state != BROKEN && conn.state != IDLE && conn.fd < 0) {
+                Drive(loop, i);
+            }
+        }
+        Expire(loop);
+        Dispatch(loop);
+    }
+
+    // 退出前以失败回调未完成的查询并关闭连接
+    for (size_t i = 0; i < loop->connects.size(); ++i) {
+        Connect& conn = loop->connects[i];
+        if (conn.state == QUERYING || conn.state == STORING) {
+            Finish(conn, nullptr, false);
+        }
+        if (conn.sql != nullptr) {
+            if (conn.fd >= 0) loop->backend->DeleteFd(conn.fd);
+            mysql_close(conn.sql);
+            conn.sql = nullptr;
+        }
+    }
+    std::deque<Job> jobs;
+    {
+        std::lock_guard<std::mutex> locker(loop->mtx);
+        jobs.swap(loop->jobs);
+    }
+    for (Job& job : jobs) {
+        Fail(job);
+    }
+}
+
+void AsyncSQLPool::StartConnect(Loop* loop, size_t idx) {
+    Connect& conn = loop->connects[idx];
+    conn.sql = mysql_init(nullptr);
+    if (conn.sql == nullptr) {
+        LOG_ERROR("Async SQL Pool: MySQL init error.");
+        conn.state = BROKEN;
+        conn.retry_time = std::chrono::steady_clock::now() + MS(RECONNECT_MS);
+        return;
+    }
+    conn.state = CONNECTING;
+    conn.connect_deadline = std::chrono::steady_clock::now() + timeout_;
+    Drive(loop, idx);
+}
+
+/**
+ * @brief
+ * 按连接状态调用对应的非阻塞接口：完成时进入下一状态并继续推进，未就绪时等待套接字事件，出错时关闭连接
+ * 连接阶段可能等待可写(TCP握手)或可读(服务器握手包)，查询阶段的请求很小，只需等待可读
+ */
+void AsyncSQLPool::Drive(Loop* loop, size_t idx) {
+#ifdef ASYNC_SQL_SUPPORTED
+    Connect& conn = loop->connects[idx];
+    net_async_status status = NET_ASYNC_ERROR;
+    switch (conn.state) {
+        case CONNECTING:
+            status = mysql_real_connect_nonblocking(conn.sql, host_.c_str(), user_.c_str(), password_.c_str(),
+                                                    db_name_.c_str(), db_port_, nullptr, 0);
+            if (status == NET_ASYNC_NOT_READY) {
+                Arm(loop, idx, EPOLLIN | EPOLLOUT);
+                return;
+            } else if (status == NET_ASYNC_ERROR) {
+                LOG_ERROR("Async SQL Pool: MySQL connect error: %s", mysql_error(conn.sql));
+                Broken(loop, idx);
+                return;
+            }
+            conn.state = IDLE;
+            ready_cnt_.fetch_add(1, std::memory_order_relaxed);
+            // 空闲连接只关注对端关闭
+            Arm(loop, idx, EPOLLIN | EPOLLRDHUP);
+            return;
+
+        case QUERYING:
+            status = mysql_real_query_nonblocking(conn.sql, conn.job.query.data(), conn.job.query.size());
+            if (status == NET_ASYNC_NOT_READY) {
+                Arm(loop, idx, EPOLLIN);
+                return;
+            } else if (status == NET_ASYNC_ERROR) {
+                LOG_ERROR("Async SQL Pool: MySQL query error: %s", mysql_error(conn.sql));
+                Finish(conn, nullptr, false);
+                if (IsConnectError(conn.sql)) {
+                    Broken(loop, idx);
+                } else {
+                    Arm(loop, idx, EPOLLIN | EPOLLRDHUP);
+                }
+                return;
+            }
+            conn.state = STORING;
+            [[fallthrough]];
+
+        case STORING: {
+            MYSQL_RES* res = nullptr;
+            status = mysql_store_result_nonblocking(conn.sql, &res);
+            if (status == NET_ASYNC_NOT_READY) {
+                Arm(loop, idx, EPOLLIN);
+                return;
+            } else if (status == NET_ASYNC_ERROR || (res == nullptr && mysql_errno(conn.sql) != 0)) {
+                LOG_ERROR("Async SQL Pool: MySQL store result error: %s", mysql_error(conn.sql));
+                Finish(conn, nullptr, false);
+                if (IsConnectError(conn.sql)) {
+                    Broken(loop, idx);
+                } else {
+                    Arm(loop, idx, EPOLLIN | EPOLLRDHUP);
+                }
+                return;
+            }
+            Finish(conn, res, true);
+            if (res != nullptr) mysql_free_result(res);
+            Arm(loop, idx, EPOLLIN | EPOLLRDHUP);
+            return;
+        }
+
+        case IDLE:
+            // 空闲连接上出现事件说明服务器已关闭连接(如wait_timeout)
+            LOG_WARN("Async SQL Pool: Idle connection closed by server.");
+            Broken(loop, idx);
+            return;
+
+        default:
+            return;
+    }
+#endif
+}
+
+void AsyncSQLPool::Arm(Loop* loop, size_t idx, uint32_t events) {
+    Connect& conn = loop->connects[idx];
+    int fd = GetSocket(conn.sql);
+    if (fd < 0) return;
+    if (conn.fd == fd) {
+        loop->backend->ModifyFd(fd, events | EPOLLONESHOT, idx);
+        return;
+    }
+    if (conn.fd >= 0) {
+        loop->backend->DeleteFd(conn.fd);
+    }
+    conn.fd = fd;
+    loop->backend->AddFd(fd, events | EPOLLONESHOT, idx);
+}
+
+void AsyncSQLPool::Finish(Connect& conn, MYSQL_RES* res, bool is_ok) {
+    Job job = std::move(conn.job);
+    conn.job = Job();
+    conn.state = IDLE;
+    try {
+        job.callback(conn.sql, res, is_ok);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Async SQL Pool: Callback threw an exception: %s", e.what());
+    }
+}
+
+void AsyncSQLPool::Fail(Job& job) {
+    try {
+        job.callback(nullptr, nullptr, false);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Async SQL Pool: Callback threw an exception: %s", e.what());
+    }
+}
+
+void AsyncSQLPool::Broken(Loop* loop, size_t idx) {
+    Connect& conn = loop->connects[idx];
+    if (conn.fd >= 0) {
+        loop->backend->DeleteFd(conn.fd);
+        conn.fd = -1;
+    }
+    if (conn.state == IDLE) {
+        ready_cnt_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (conn.sql != nullptr) {
+        mysql_close(conn.sql);
+        conn.sql = nullptr;
+    }
+    conn.state = BROKEN;
+    conn.retry_time = std::chrono::steady_clock::now() + MS(RECONNECT_MS);
+}
+
+void AsyncSQLPool::Dispatch(Loop* loop) {
+    bool is_alive = false;
+    for (size_t i = 0; i < loop->connects.size(); ++i) {
+        Connect& conn = loop->connects[i];
+        is_alive |= (conn.state != BROKEN);
+        if (conn.state != IDLE) continue;
+        {
+            std::lock_guard<std::mutex> locker(loop->mtx);
+            if (loop->jobs.empty()) return;
+            conn.job = std::move(loop->jobs.front());
+            loop->jobs.pop_front();
+        }
+        conn.state = QUERYING;
+        Drive(loop, i);
+        // 查询可能立即完成，连接重新空闲后继续分配
+        if (conn.state == IDLE) --i;
+    }
+    if (is_alive) return;
+
+    // 没有可用连接，排队的查询直接失败，不等待重连
+    std::deque<Job> jobs;
+    {
+        std::lock_guard<std::mutex> locker(loop->mtx);
+        jobs.swap(loop->jobs);
+    }
+    for (Job& job : jobs) {
+        Fail(job);
+    }
+}
+
+/**
+ * @brief
+ * 查询的期限自提交起计算，队列按提交顺序排列，只需检查队首；
+ * 执行中的查询到期时连接上仍有未读完的结果，无法继续使用，关闭后重连
+ */
+void AsyncSQLPool::Expire(Loop* loop) {
+    auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < loop->connects.size(); ++i) {
+        Connect& conn = loop->connects[i];
+        if ((conn.state == QUERYING || conn.state == STORING) && now >= conn.job.deadline) {
+            LOG_WARN("Async SQL Pool: Query timeout after %lld ms.", static_cast<long long>(timeout_.count()));
+            Finish(conn, nullptr, false);
+            Broken(loop, i);
+        } else if (conn.state == CONNECTING && now >= conn.connect_deadline) {
+            LOG_WARN("Async SQL Pool: MySQL connect timeout after %lld ms.", static_cast<long long>(timeout_.count()));
+            Broken(loop, i);
+        }
+    }
+
+    std::deque<Job> jobs;
+    {
+        std::lock_guard<std::mutex> locker(loop->mtx);
+        while (!loop->jobs.empty() && now >= loop->jobs.front().deadline) {
+            jobs.push_back(std::move(loop->jobs.front()));
+            loop->jobs.pop_front();
+        }
+    }
+    if (!jobs.empty()) {
+        LOG_WARN("Async SQL Pool: %zu queued queries timeout.", jobs.size());
+    }
+    for (Job& job : jobs) {
+        Fail(job);
+    }
+}
+
+// 取重连时间、查询与建立连接期限中最早的一个
+int AsyncSQLPool::GetWaitTime(Loop* loop) const {
+    auto now = std::chrono::steady_clock::now();
+    int64_t wait = -1;
+    auto update = [&](std::chrono::steady_clock::time_point when) {
+        int64_t ms = std::max<int64_t>(std::chrono::ceil<MS>(when - now).count(), 0);
+        wait = (wait < 0) ? ms : std::min<int64_t>(wait, ms);
+    };
+    for (const Connect& conn : loop->connects) {
+        if (conn.state == BROKEN) {
+            update(conn.retry_time);
+        } else if (conn.state != IDLE && conn.fd < 0) {
+            wait = (wait < 0) ? 1 : std::min<int64_t>(wait, 1);
+        } else if (conn.state == CONNECTING) {
+            update(conn.connect_deadline);
+        } else if (conn.state == QUERYING || conn.state == STORING) {
+            update(conn.job.deadline);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> locker(loop->mtx);
+        if (!loop->jobs.empty()) update(loop->jobs.front().deadline);
+    }
+    return static_cast<int>(wait);
+}
+
+// X'..'为二进制串，转换为连接字符集后按列的排序规则比较，与预处理语句传参一致
+std::string AsyncSQLPool::ToSQLLiteral(const std::string& str) {
+    static const char HEX[] = "0123456789ABCDEF";
+    std::string literal = "CONVERT(X'";
+    literal.reserve(literal.size() + str.size() * 2 + 16);
+    for (unsigned char ch : str) {
+        literal.push_back(HEX[ch >> 4]);
+        literal.push_back(HEX[ch & 0xf]);
+    }
+    literal += "' USING utf8mb4)";
+    return literal;
+}
+
+// 服务器错误码小于2000(如语法错误、唯一键冲突)，连接仍可继续使用；客户端错误码(CR_*)表示连接已不可用
+bool AsyncSQLPool::IsConnectError(MYSQL* sql) {
+    return mysql_errno(sql) == 0 || mysql_errno(sql) >= 2000;
+}
+
+int AsyncSQLPool::GetSocket(MYSQL* sql) {
+    if (sql == nullptr || sql->net.vio == nullptr) return -1;
+    return static_cast<int>(sql->net.fd);
+}
@@ -0,0 +1,124 @@
+/**
+ * @file async_sql_pool.h
+ * @author chenyinjie
+ * @date 2024-11-05
+ * @copyright Apache 2.0
+ */
+
+#ifndef ASYNC_SQL_POOL_H
+#define ASYNC_SQL_POOL_H
+
+#include "../log/log.h"
+#include "../epoll/event_backend.h"
+
+#include <mysql/mysql.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using MS = std::chrono::milliseconds;
+
+// MySQL 8.0.16起客户端库提供非阻塞API，MariaDB客户端库的同名接口不兼容
+#if defined(MYSQL_VERSION_ID) && MYSQL_VERSION_ID >= 80016 && !defined(MARIADB_BASE_VERSION) && !defined(MARIADB_PACKAGE_VERSION_ID)
+#define ASYNC_SQL_SUPPORTED 1
+#endif
+
+/**
+ * @brief
+ * 基于MySQL非阻塞C API的异步查询池
+ * - 共loop_nums个事件循环线程，每个线程持有若干非阻塞连接与独立的事件后端。
+ *   mysql_*_nonblocking返回NET_ASYNC_NOT_READY时将连接套接字注册到事件后端，就绪后再次调用推进，线程从不阻塞。
+ * - 查询按提交顺序排队，由空闲连接依次执行；每个连接同一时刻只执行一个查询，大量在途查询共享少量线程。
+ * - 非阻塞API只支持文本协议，参数由调用者编码进SQL(如十六进制字面量)，不支持预处理语句。
+ * - 回调在事件循环线程中执行，参数为连接、结果集(无结果集的语句为nullptr)与是否成功，回调返回后结果集即被释放。
+ * - SQL语句出错只以失败回调，连接出错时关闭并在RECONNECT_MS后重连；空闲连接被服务器关闭时同样重连；全部连接不可用时排队的查询直接以失败回调。
+ * - 每个查询自提交起有timeout_ms的期限，到期时无论排队还是执行中都以失败回调，执行中的连接关闭后重连；
+ *   建立连接同样有timeout_ms的期限。服务器无响应或连接半开时查询不会无限等待。
+ * - 客户端库不支持非阻塞API时构造函数抛出异常，调用者应退回同步连接池。
+ */
+
+class AsyncSQLPool {
+public:
+    using Callback = std::function<void(MYSQL* sql, MYSQL_RES* res, bool is_ok)>;
+
+    AsyncSQLPool(const char* host, const char* user, const char* password, const char* db_name, int db_port,
+                 int connect_nums, int loop_nums = 1, size_t queue_size = 1024, int timeout_ms = QUERY_TIMEOUT_MS);
+    ~AsyncSQLPool();
+
+    AsyncSQLPool(const AsyncSQLPool&) = delete;
+    AsyncSQLPool& operator=(const AsyncSQLPool&) = delete;
+
+    bool Submit(std::string query, Callback callback);          // 提交查询，队列已满时返回false
+    int GetReadyConnectNums() const;                            // 已建立的连接数
+
+    static std::string ToSQLLiteral(const std::string& str);    // 编码为SQL十六进制字面量，无需依赖连接转义
+
+    static const int RECONNECT_MS = 1000;                       // 连接出错后的重连间隔
+    static const int QUERY_TIMEOUT_MS = 3000;                   // 默认的查询与建立连接期限
+
+private:
+    struct Job {
+        std::string query;                                      // SQL语句
+        Callback callback;                                      // 完成回调
+        std::chrono::steady_clock::time_point deadline;         // 到期时以失败回调
+    };
+
+    enum CONNECT_STATE {CONNECTING, IDLE, QUERYING, STORING, BROKEN};
+
+    struct Connect {
+        MYSQL* sql = nullptr;
+        CONNECT_STATE state = BROKEN;
+        int fd = -1;                                            // 已注册到事件后端的套接字
+        std::chrono::steady_clock::time_point retry_time;       // 下一次重连时间
+        std::chrono::steady_clock::time_point connect_deadline; // 建立连接的期限
+        Job job;                                                // 执行中的查询
+    };
+
+    struct Loop {
+        std::unique_ptr<EventBackend> backend;                  // 本线程的事件后端
+        int wakeup_fd = -1;                                     // 提交查询时唤醒事件循环
+        std::thread thread;
+        std::mutex mtx;                                         // 保护jobs
+        std::deque<Job> jobs;                                   // 等待空闲连接的查询
+        std::vector<Connect> connects;                          // 本线程的连接
+    };
+
+    void Run(Loop* loop);                                       // 事件循环
+    void StartConnect(Loop* loop, size_t idx);                  // 建立新连接
+    void Drive(Loop* loop, size_t idx);                         // 推进连接的当前操作
+    void Arm(Loop* loop, size_t idx, uint32_t events);          // 注册连接套接字，等待就绪
+    void Finish(Connect& conn, MYSQL_RES* res, bool is_ok);     // 执行回调并回到空闲状态
+    static void Fail(Job& job);                                 // 以失败回调未执行的查询
+    void Broken(Loop* loop, size_t idx);                        // 关闭出错的连接，稍后重连
+    void Dispatch(Loop* loop);                                  // 将排队的查询分配给空闲连接
+    void Expire(Loop* loop);                                    // 以失败回调到期的查询，关闭到期的连接
+    int GetWaitTime(Loop* loop) const;                          // 下一次需要主动推进的等待时间
+    static int GetSocket(MYSQL* sql);                           // 连接当前的套接字，尚未建立时返回-1
+    static bool IsConnectError(MYSQL* sql);                     // 出错后连接是否已不可用
+
+    static const uint64_t WAKEUP_DATA = UINT64_MAX;
+
+    std::string host_;
+    std::string user_;
+    std::string password_;
+    std::string db_name_;
+    int db_port_;
+    size_t queue_size_;                                         // 每个事件循环的最大排队查询数
+    MS timeout_;                                                // 查询与建立连接的期限
+    std::atomic<bool> is_stop_;
+    std::atomic<int> ready_cnt_;                                // 已建立的连接数
+    std::atomic<size_t> next_loop_;                             // 轮询选择事件循环
+    std::vector<std::unique_ptr<Loop>> loops_;
+};
+
+#endif
@@ -7,87 +7,363 @@
 
 #include "db_connect_pool.h"
 
+static const size_t MAX_SHARD_NUMS = 8;
+
 SQLConnectPool* SQLConnectPool::GetSQLConnectPoolInstance() {
     static SQLConnectPool sql_connect_pool_instance;
     return &sql_connect_pool_instance;
 }
 
-bool SQLConnectPool::Init(const char* host, const char* user, const char* password, const char* db_name, int db_port, int connect_nums) {
+bool SQLConnectPool::Init(const char* host, const char* user, const char* password, const char* db_name, int db_port,
+                          int connect_nums, int min_connect_nums) {
     if (connect_nums <= 0) {
         LOG_ERROR("Connect Pool: Init Database connect number error.");
         return false;
     }
+    if (!is_closed_) {
+        CloseConnectPool();
+    }
+
+    host_ = host;
+    user_ = user;
+    password_ = password;
+    db_name_ = db_name;
+    db_port_ = db_port;
+    max_connect_nums_ = connect_nums;
+    min_connect_nums_ = (min_connect_nums <= 0 || min_connect_nums > connect_nums) ? connect_nums : min_connect_nums;
 
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    shard_nums_ = std::min({MAX_SHARD_NUMS, static_cast<size_t>(cores), static_cast<size_t>(connect_nums)});
+    shards_ = std::make_unique<Shard[]>(shard_nums_);
+
+    checkouts_ = 0;
+    waits_ = 0;
+    timeouts_ = 0;
+    total_wait_us_ = 0;
+    max_wait_us_ = 0;
+
+    // 预先建立min_connect_nums个连接，其余按需建立
     int nums = 0;
-    for (int i = 0; i < connect_nums; ++i) {
-        MYSQL* sql = nullptr;
-        sql = mysql_init(nullptr);
-        if (!sql) {
-            LOG_ERROR("Connect Pool: MySQL connect i: %d init error.", i);
-            continue;
-        }
-        sql = mysql_real_connect(sql, host, user, password, db_name, db_port, nullptr, 0);
-        if (!sql) {
-            LOG_ERROR("Connect Pool: MySQL i: %d create connect error: %s", i, mysql_error(sql));
+    Clock::time_point now = Clock::now();
+    for (int i = 0; i < min_connect_nums_; ++i) {
+        MYSQL* sql = Connect();
+        if (sql == nullptr) {
+            LOG_ERROR("Connect Pool: MySQL i: %d create connect error.", i);
             continue;
         }
-        connect_pool_.emplace(sql);
+        shards_[nums % shard_nums_].idles.push_back({sql, now});
         ++nums;
     }
-    
+
     if (nums <= 0) {
         LOG_ERROR("Connect Pool: Init Database Connect Pool Failed.");
         return false;
     }
 
-    max_connect_nums_ = nums;
-    if (sem_init(&sems_, 0, max_connect_nums_) != 0) {
-        LOG_ERROR("Connect Pool: Failed to initialize semaphore.");
-        return false;
+    connect_nums_ = nums;
+    free_nums_ = nums;
+    is_closed_ = false;
+    LOG_INFO("Connect Pool: Init %d connects, min: %d, max: %d, shards: %zu.", nums, min_connect_nums_, max_connect_nums_, shard_nums_);
+    return true;
+}
+
+/**
+ * @brief
+ * 获取空闲连接
+ * 先从分片中获取；没有空闲连接时连接数未达上限则新建，否则等待其他线程归还，截止时间前仍无连接则返回nullptr。
+ * 新建连接失败(如数据库不可达)后本次获取不再尝试新建，只等待归还。
+ */
+MYSQL* SQLConnectPool::GetConnection(MS timeout) {
+    if (is_closed_.load(std::memory_order_acquire)) {
+        LOG_WARN("Connect Pool: Pool is closed.");
+        return nullptr;
+    }
+    MYSQL* sql = TryAcquire();
+    if (sql != nullptr) {
+        checkouts_.fetch_add(1, std::memory_order_relaxed);
+        return sql;
     }
 
-    return max_connect_nums_ > 0;
-}
+    Clock::time_point start = Clock::now();
+    Clock::time_point deadline = start + timeout;
+    bool is_grow_failed = false;
+    while (true) {
+        if (!is_grow_failed) {
+            sql = TryGrow();
+            is_grow_failed = (sql == nullptr && connect_nums_.load() < max_connect_nums_);
+        }
+        if (sql == nullptr) {
+            sql = TryAcquire();
+        }
+        if (sql != nullptr) {
+            RecordWait(start, true);
+            return sql;
+        }
 
-MYSQL* SQLConnectPool::GetConnection() {
-    MYSQL* sql = nullptr;
-    std::lock_guard<std::mutex> locker(connect_pool_mtx_);
-    if (connect_pool_.empty()) {
-        LOG_WARN("Connect Pool: No free connection.");
-    } else {
-        sem_wait(&sems_);
-        sql = connect_pool_.front();
-        connect_pool_.pop();
+        std::unique_lock<std::mutex> locker(wait_mtx_);
+        waiters_.fetch_add(1);
+        bool is_ready = wait_cond_.wait_until(locker, deadline, [&]() {
+            return free_nums_.load() > 0 || is_closed_.load() ||
+                   (!is_grow_failed && connect_nums_.load() < max_connect_nums_);
+        });
+        waiters_.fetch_sub(1);
+        if (!is_ready || is_closed_.load()) {
+            locker.unlock();
+            LOG_WARN("Connect Pool: No free connection.");
+            RecordWait(start, false);
+            return nullptr;
+        }
     }
-    return sql;
 }
 
+/**
+ * @brief
+ * 归还连接到本线程分片的栈顶
+ * 连接数超过下限时，顺带关闭本分片中空闲超过IDLE_TIMEOUT_MS的最旧连接(栈底)。
+ */
 void SQLConnectPool::FreeConnection(MYSQL* sql) {
     if (sql == nullptr) {
         LOG_ERROR("Connect Pool: Attempt to free nullptr.");
         return;
     }
-    std::lock_guard<std::mutex> locker(connect_pool_mtx_);
-    connect_pool_.push(sql);
-    sem_post(&sems_);
+    if (shards_ == nullptr) {
+        CloseConnect(sql);
+        return;
+    }
+
+    Shard& shard = shards_[GetHomeShard()];
+    Clock::time_point now = Clock::now();
+    MYSQL* expired = nullptr;
+    {
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        if (!is_closed_.load()) {
+            shard.idles.push_back({sql, now});
+            sql = nullptr;
+            IdleConnect& oldest = shard.idles.front();
+            int cur = connect_nums_.load();
+            if (shard.idles.size() > 1 && now - oldest.last_used >= MS(IDLE_TIMEOUT_MS) && cur > min_connect_nums_ &&
+                connect_nums_.compare_exchange_strong(cur, cur - 1)) {
+                expired = oldest.sql;
+                shard.idles.erase(shard.idles.begin());
+            }
+        }
+    }
+
+    if (sql != nullptr) {
+        // 连接池已关闭
+        connect_nums_.fetch_sub(1);
+        CloseConnect(sql);
+        return;
+    }
+    if (expired != nullptr) {
+        LOG_DEBUG("Connect Pool: Close idle connect, connects: %d.", connect_nums_.load());
+        CloseConnect(expired);
+    } else {
+        free_nums_.fetch_add(1);
+    }
+    if (waiters_.load() > 0) {
+        std::lock_guard<std::mutex> locker(wait_mtx_);
+        wait_cond_.notify_one();
+    }
 }
 
 int SQLConnectPool::GetFreeConnectNums() {
-    std::lock_guard<std::mutex> locker(connect_pool_mtx_);
-    return connect_pool_.size();
+    return free_nums_.load(std::memory_order_relaxed);
+}
+
+int SQLConnectPool::GetConnectNums() const {
+    return connect_nums_.load(std::memory_order_relaxed);
+}
+
+SQLConnectPool::CheckoutStats SQLConnectPool::GetCheckoutStats() const {
+    CheckoutStats stats;
+    stats.checkouts = checkouts_.load(std::memory_order_relaxed);
+    stats.waits = waits_.load(std::memory_order_relaxed);
+    stats.timeouts = timeouts_.load(std::memory_order_relaxed);
+    stats.total_wait_us = total_wait_us_.load(std::memory_order_relaxed);
+    stats.max_wait_us = max_wait_us_.load(std::memory_order_relaxed);
+    return stats;
 }
 
 void SQLConnectPool::CloseConnectPool() {
-    std::lock_guard<std::mutex> locker(connect_pool_mtx_);
-    while (!connect_pool_.empty()) {
-        auto free_sql = connect_pool_.front();
-        connect_pool_.pop();
-        mysql_close(free_sql);
+    is_closed_ = true;
+    if (shards_ != nullptr) {
+        for (size_t i = 0; i < shard_nums_; ++i) {
+            std::vector<IdleConnect> idles;
+            {
+                std::lock_guard<std::mutex> locker(shards_[i].mtx);
+                idles.swap(shards_[i].idles);
+            }
+            for (IdleConnect& idle : idles) {
+                CloseConnect(idle.sql);
+            }
+            connect_nums_.fetch_sub(static_cast<int>(idles.size()));
+        }
+    }
+    free_nums_ = 0;
+    {
+        std::lock_guard<std::mutex> locker(wait_mtx_);
+        wait_cond_.notify_all();
     }
-    sem_destroy(&sems_);
     mysql_library_end();
 }
 
+// 线程首次使用连接池时按顺序分配分片
+size_t SQLConnectPool::GetHomeShard() const {
+    static std::atomic<size_t> next_shard{0};
+    thread_local size_t shard = next_shard.fetch_add(1, std::memory_order_relaxed);
+    return shard % shard_nums_;
+}
+
+MYSQL* SQLConnectPool::TryAcquire() {
+    if (shards_ == nullptr) return nullptr;
+    size_t home = GetHomeShard();
+    for (size_t i = 0; i < shard_nums_; ++i) {
+        Shard& shard = shards_[(home + i) % shard_nums_];
+        while (true) {
+            IdleConnect idle;
+            {
+                std::lock_guard<std::mutex> locker(shard.mtx);
+                if (shard.idles.empty()) break;
+                idle = shard.idles.back();
+                shard.idles.pop_back();
+            }
+            free_nums_.fetch_sub(1);
+            if (CheckAlive(idle)) {
+                return idle.sql;
+            }
+        }
+    }
+    return nullptr;
+}
+
+bool SQLConnectPool::CheckAlive(IdleConnect& idle) {
+    if (Clock::now() - idle.last_used < MS(PING_IDLE_MS) || mysql_ping(idle.sql) == 0) {
+        return true;
+    }
+    LOG_WARN("Connect Pool: Connection lost: %s, reconnect.", mysql_error(idle.sql));
+    CloseConnect(idle.sql);
+    idle.sql = Connect();
+    if (idle.sql == nullptr) {
+        connect_nums_.fetch_sub(1);
+        return false;
+    }
+    return true;
+}
+
+MYSQL* SQLConnectPool::TryGrow() {
+    int cur = connect_nums_.load();
+    do {
+        if (cur >= max_connect_nums_) return nullptr;
+    } while (!connect_nums_.compare_exchange_weak(cur, cur + 1));
+
+    MYSQL* sql = Connect();
+    if (sql == nullptr) {
+        connect_nums_.fetch_sub(1);
+        return nullptr;
+    }
+    LOG_DEBUG("Connect Pool: Grow to %d connects.", cur + 1);
+    return sql;
+}
+
+MYSQL* SQLConnectPool::Connect() {
+    MYSQL* sql = mysql_init(nullptr);
+    if (!sql) {
+        LOG_ERROR("Connect Pool: MySQL init error.");
+        return nullptr;
+    }
+    if (!mysql_real_connect(sql, host_.c_str(), user_.c_str(), password_.c_str(), db_name_.c_str(), db_port_, nullptr, 0)) {
+        LOG_ERROR("Connect Pool: MySQL create connect error: %s", mysql_error(sql));
+        mysql_close(sql);
+        return nullptr;
+    }
+    return sql;
+}
+
+void SQLConnectPool::CloseConnect(MYSQL* sql) {
+    {
+        std::lock_guard<std::mutex> locker(stmt_mtx_);
+        auto it = stmt_caches_.find(sql);
+        if (it != stmt_caches_.end()) {
+            ClearStmtCache(it->second);
+            stmt_caches_.erase(it);
+        }
+    }
+    mysql_close(sql);
+}
+
+void SQLConnectPool::RecordWait(Clock::time_point start, bool is_ok) {
+    uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    (is_ok ? checkouts_ : timeouts_).fetch_add(1, std::memory_order_relaxed);
+    waits_.fetch_add(1, std::memory_order_relaxed);
+    total_wait_us_.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max_us = max_wait_us_.load(std::memory_order_relaxed);
+    while (us > max_us && !max_wait_us_.compare_exchange_weak(max_us, us, std::memory_order_relaxed)) {}
+}
+
+/**
+ * @brief
+ * 获取连接上缓存的预处理语句，未缓存时预处理并加入缓存。
+ * 连接的服务端线程ID与预处理时不同说明连接已重建，服务端的语句已随旧会话释放，先清空缓存。
+ */
+MYSQL_STMT* SQLConnectPool::GetStatement(MYSQL* sql, const std::string& query) {
+    if (sql == nullptr) return nullptr;
+    StmtCache& cache = GetStmtCache(sql);
+    unsigned long thread_id = mysql_thread_id(sql);
+    if (cache.thread_id != thread_id) {
+        if (!cache.stmts.empty()) {
+            LOG_INFO("Connect Pool: Connection reconnected, re-prepare %zu statements.", cache.stmts.size());
+            ClearStmtCache(cache);
+        }
+        cache.thread_id = thread_id;
+    }
+
+    auto it = cache.stmts.find(query);
+    if (it != cache.stmts.end()) {
+        return it->second;
+    }
+
+    MYSQL_STMT* stmt = mysql_stmt_init(sql);
+    if (stmt == nullptr) {
+        LOG_ERROR("Connect Pool: mysql_stmt_init failed.");
+        return nullptr;
+    }
+    if (mysql_stmt_prepare(stmt, query.c_str(), query.size())) {
+        LOG_ERROR("Connect Pool: mysql_stmt_prepare failed: %s", mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+        return nullptr;
+    }
+    cache.stmts.emplace(query, stmt);
+    return stmt;
+}
+
+void SQLConnectPool::DiscardStatement(MYSQL* sql, const std::string& query) {
+    if (sql == nullptr) return;
+    StmtCache& cache = GetStmtCache(sql);
+    auto it = cache.stmts.find(query);
+    if (it != cache.stmts.end()) {
+        mysql_stmt_close(it->second);
+        cache.stmts.erase(it);
+    }
+}
+
+size_t SQLConnectPool::GetStatementNums(MYSQL* sql) {
+    return GetStmtCache(sql).stmts.size();
+}
+
+// unordered_map的元素引用在插入时保持有效，取出后由持有连接的线程独占使用
+SQLConnectPool::StmtCache& SQLConnectPool::GetStmtCache(MYSQL* sql) {
+    std::lock_guard<std::mutex> locker(stmt_mtx_);
+    return stmt_caches_[sql];
+}
+
+void SQLConnectPool::ClearStmtCache(StmtCache& cache) {
+    for (auto& [query, stmt] : cache.stmts) {
+        mysql_stmt_close(stmt);
+    }
+    cache.stmts.clear();
+}
+
 SQLConnectPool::~SQLConnectPool() {
     CloseConnectPool();
 }
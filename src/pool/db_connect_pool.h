@@ -14,36 +14,124 @@
 
 #include <iostream>
 #include <string>
-#include <queue>
+#include <vector>
+#include <algorithm>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <unordered_map>
 
 /**
- * @brief 
+ * @brief
  * 单例模式实现的MySQL数据库连接池
+ * - 空闲连接分散在若干分片中，每个线程固定归属一个分片：归还时放回本线程分片的栈顶，获取时先取本线程分片，
+ *   同一线程大概率拿回上次使用的连接(语句缓存已预热)；本分片为空时再从其他分片获取，各分片独立加锁。
+ * - 没有空闲连接时，连接数未达上限则新建连接，否则等待至截止时间，超时返回nullptr。
+ * - 连接空闲超过PING_IDLE_MS时取出前先mysql_ping检测，失效则关闭并重建；
+ *   连接数超过下限时，空闲超过IDLE_TIMEOUT_MS的连接被关闭，连接数在[min, max]之间伸缩。
+ * - 每个连接带有以SQL文本为键的预处理语句缓存：语句在连接上只预处理一次，之后重新绑定参数即可执行；
+ *   连接重建(服务端线程ID变化)后缓存的语句全部失效，下次使用时自动重新预处理。
+ *   语句缓存只能由持有该连接的线程使用。
+ * - 统计获取次数、超时次数与等待时间，可通过GetCheckoutStats读取。
  */
 
 class SQLConnectPool {
 public:
+    using MS = std::chrono::milliseconds;
+
+    struct CheckoutStats {
+        uint64_t checkouts = 0;                     // 成功获取次数
+        uint64_t waits = 0;                         // 需要新建连接或等待的次数
+        uint64_t timeouts = 0;                      // 超时次数
+        uint64_t total_wait_us = 0;                 // 累计等待时间
+        uint64_t max_wait_us = 0;                   // 最长等待时间
+    };
+
     static SQLConnectPool* GetSQLConnectPoolInstance();
 
     SQLConnectPool(const SQLConnectPool&) = delete;
     SQLConnectPool& operator=(const SQLConnectPool&) = delete;
-    
-    bool Init(const char* host, const char* user, const char* password, const char* db_name, int db_port, int connect_nums = 16);
-    MYSQL* GetConnection();                         // 获取空闲连接
+
+    // min_connect_nums为0或大于connect_nums时连接数固定为connect_nums
+    bool Init(const char* host, const char* user, const char* password, const char* db_name, int db_port,
+              int connect_nums = 16, int min_connect_nums = 0);
+    MYSQL* GetConnection(MS timeout = MS(CHECKOUT_TIMEOUT_MS)); // 获取空闲连接，超时返回nullptr
     void FreeConnection(MYSQL*);                    // 释放连接
     int GetFreeConnectNums();                       // 获取当前空闲连接数
+    int GetConnectNums() const;                     // 获取当前连接总数
+    CheckoutStats GetCheckoutStats() const;         // 获取连接的等待统计
     void CloseConnectPool();                        // 关闭连接池
 
+    MYSQL_STMT* GetStatement(MYSQL* sql, const std::string& query);     // 获取连接上已预处理的语句，失败时返回nullptr
+    void DiscardStatement(MYSQL* sql, const std::string& query);        // 关闭执行出错的语句，下次使用时重新预处理
+    size_t GetStatementNums(MYSQL* sql);                                // 连接上缓存的语句数
+
+    static const int CHECKOUT_TIMEOUT_MS = 500;     // 默认获取连接的等待时间
+    static const int PING_IDLE_MS = 30000;          // 空闲超过该时间的连接取出前检测存活
+    static const int IDLE_TIMEOUT_MS = 60000;       // 超过连接数下限时，空闲连接的最长保留时间
+
 private:
     SQLConnectPool() = default;
     ~SQLConnectPool();
 
-    int max_connect_nums_;                          // 最大连接数
-    std::queue<MYSQL*> connect_pool_;               // 连接池
-    std::mutex connect_pool_mtx_;                   // 互斥锁
-    sem_t sems_;                                    // 信号量
+    using Clock = std::chrono::steady_clock;
+
+    struct IdleConnect {
+        MYSQL* sql;
+        Clock::time_point last_used;                // 最近一次归还的时间
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::vector<IdleConnect> idles;             // 空闲连接栈，栈顶为最近归还的连接
+    };
+
+    struct StmtCache {
+        unsigned long thread_id = 0;                                    // 预处理时连接的服务端线程ID
+        std::unordered_map<std::string, MYSQL_STMT*> stmts;            // SQL文本 -> 预处理语句
+    };
+
+    size_t GetHomeShard() const;                    // 当前线程归属的分片
+    MYSQL* TryAcquire();                            // 从分片中取出可用的空闲连接
+    bool CheckAlive(IdleConnect& idle);             // 检测空闲较久的连接，失效时重建
+    MYSQL* TryGrow();                               // 连接数未达上限时新建连接
+    MYSQL* Connect();                               // 建立新连接
+    void CloseConnect(MYSQL* sql);                  // 关闭连接并释放其语句缓存
+    void RecordWait(Clock::time_point start, bool is_ok);
+
+    StmtCache& GetStmtCache(MYSQL* sql);
+    static void ClearStmtCache(StmtCache& cache);
+
+    std::string host_;
+    std::string user_;
+    std::string password_;
+    std::string db_name_;
+    int db_port_ = 0;
+
+    int max_connect_nums_ = 0;                      // 最大连接数
+    int min_connect_nums_ = 0;                      // 最小连接数
+    std::atomic<int> connect_nums_{0};              // 当前连接数(含使用中的连接)
+    std::atomic<int> free_nums_{0};                 // 当前空闲连接数
+    std::atomic<bool> is_closed_{true};
+
+    size_t shard_nums_ = 0;
+    std::unique_ptr<Shard[]> shards_;               // 空闲连接分片
+
+    std::mutex wait_mtx_;                           // 等待空闲连接
+    std::condition_variable wait_cond_;
+    std::atomic<int> waiters_{0};                   // 等待中的线程数，为0时归还连接不加锁
+
+    std::atomic<uint64_t> checkouts_{0};
+    std::atomic<uint64_t> waits_{0};
+    std::atomic<uint64_t> timeouts_{0};
+    std::atomic<uint64_t> total_wait_us_{0};
+    std::atomic<uint64_t> max_wait_us_{0};
+
+    std::mutex stmt_mtx_;                           // 保护stmt_caches_表本身
+    std::unordered_map<MYSQL*, StmtCache> stmt_caches_;                 // 各连接的语句缓存
 };
 
-#endif
\ No newline at end of file
+#endif
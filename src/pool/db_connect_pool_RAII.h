@@ -17,13 +17,15 @@
 
 class SQLConnectPoolRAII {
 public:
-    SQLConnectPoolRAII(MYSQL** sql, SQLConnectPool* sql_connect_pool) {
+    SQLConnectPoolRAII(MYSQL** sql, SQLConnectPool* sql_connect_pool,
+                       SQLConnectPool::MS timeout = SQLConnectPool::MS(SQLConnectPool::CHECKOUT_TIMEOUT_MS))
+        : sql_(nullptr), connect_pool_(sql_connect_pool) {
         if (!sql_connect_pool) {
             LOG_ERROR("MySQL Connect RAII: sql_connect_pool is nullptr.");
+        } else {
+            sql_ = sql_connect_pool->GetConnection(timeout);
         }
-        *sql = sql_connect_pool->GetConnection();
-        sql_ = *sql;
-        connect_pool_ = sql_connect_pool;
+        *sql = sql_;
     }
 
     ~SQLConnectPoolRAII() {
@@ -32,6 +34,9 @@ public:
         }
     }
 
+    SQLConnectPoolRAII(const SQLConnectPoolRAII&) = delete;
+    SQLConnectPoolRAII& operator=(const SQLConnectPoolRAII&) = delete;
+
 private:
     MYSQL* sql_;
     SQLConnectPool* connect_pool_;
@@ -0,0 +1,117 @@
+/**
+ * @file inplace_task.h
+ * @author chenyinjie
+ * @date 2024-11-02
+ * @copyright Apache 2.0
+ */
+
+#ifndef INPLACE_TASK_H
+#define INPLACE_TASK_H
+
+#include <new>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+/**
+ * @brief
+ * 固定容量的仅移动任务对象
+ * - 可调用对象直接构造在对象内部的Capacity字节缓冲区中，从不分配堆内存；超出容量或对齐要求时编译失败。
+ * - 可平凡复制的可调用对象(如只捕获指针的lambda)移动时直接复制字节，析构时不做任何操作。
+ * - 只支持无参数、无返回值的调用，用于线程池任务。
+ */
+
+template <size_t Capacity>
+class InplaceTask {
+public:
+    InplaceTask() noexcept = default;
+
+    template <typename F>
+        requires (!std::is_same_v<std::decay_t<F>, InplaceTask>)
+    InplaceTask(F&& func) noexcept(std::is_nothrow_constructible_v<std::decay_t<F>, F&&>) {
+        using Func = std::decay_t<F>;
+        static_assert(std::is_invocable_v<Func&>, "InplaceTask: callable must be invocable without arguments.");
+        static_assert(sizeof(Func) <= Capacity, "InplaceTask: callable exceeds the inplace capacity.");
+        static_assert(alignof(Func) <= alignof(std::max_align_t), "InplaceTask: callable is over-aligned.");
+        static_assert(std::is_nothrow_move_constructible_v<Func>, "InplaceTask: callable must be nothrow movable.");
+        ::new (static_cast<void*>(storage_)) Func(std::forward<F>(func));
+        invoke_ = &Invoke<Func>;
+        if constexpr (!std::is_trivially_copyable_v<Func>) {
+            manage_ = &Manage<Func>;
+        }
+    }
+
+    InplaceTask(InplaceTask&& other) noexcept {
+        MoveFrom(other);
+    }
+
+    InplaceTask& operator=(InplaceTask&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    InplaceTask(const InplaceTask&) = delete;
+    InplaceTask& operator=(const InplaceTask&) = delete;
+
+    ~InplaceTask() {
+        Reset();
+    }
+
+    void operator()() {
+        invoke_(storage_);
+    }
+
+    explicit operator bool() const noexcept {
+        return invoke_ != nullptr;
+    }
+
+    // 析构持有的可调用对象，释放其捕获的资源
+    void Reset() noexcept {
+        if (manage_ != nullptr) {
+            manage_(nullptr, storage_);
+        }
+        invoke_ = nullptr;
+        manage_ = nullptr;
+    }
+
+    static constexpr size_t CAPACITY = Capacity;
+
+private:
+    template <typename Func>
+    static void Invoke(void* storage) {
+        (*static_cast<Func*>(storage))();
+    }
+
+    // dst非空时移动构造到dst，随后析构src
+    template <typename Func>
+    static void Manage(void* dst, void* src) noexcept {
+        Func* func = static_cast<Func*>(src);
+        if (dst != nullptr) {
+            ::new (dst) Func(std::move(*func));
+        }
+        func->~Func();
+    }
+
+    void MoveFrom(InplaceTask& other) noexcept {
+        if (other.invoke_ == nullptr) return;
+        if (other.manage_ != nullptr) {
+            other.manage_(storage_, other.storage_);
+        } else {
+            std::memcpy(storage_, other.storage_, Capacity);
+        }
+        invoke_ = other.invoke_;
+        manage_ = other.manage_;
+        other.invoke_ = nullptr;
+        other.manage_ = nullptr;
+    }
+
+    alignas(std::max_align_t) unsigned char storage_[Capacity];     // 可调用对象存储区
+    void (*invoke_)(void*) = nullptr;                               // 调用
+    void (*manage_)(void*, void*) = nullptr;                        // 移动与析构，可平凡复制时为空
+};
+
+#endif
@@ -7,7 +7,13 @@
 
 #include "thread_pool.h"
 
-ThreadPool::ThreadPool(size_t max_thread_nums = 8, size_t max_task_nums = 16): max_thread_nums_(max_thread_nums), max_task_nums_(max_task_nums), is_stop_(false) {
+thread_local ThreadPool* ThreadPool::tls_pool_ = nullptr;
+thread_local size_t ThreadPool::tls_idx_ = 0;
+
+ThreadPool::ThreadPool(size_t max_thread_nums = 8, size_t max_task_nums = 16)
+    : is_stop_(false), max_task_nums_(max_task_nums), max_thread_nums_(max_thread_nums), task_cnt_(0),
+      inject_queue_(max_task_nums), free_slots_(max_task_nums + max_thread_nums),
+      min_delay_ns_(INT64_MAX), sleeper_cnt_(0), waiter_cnt_(0) {
     if (max_thread_nums_ <= 0) {
         LOG_ERROR("Thread Pool: Invalid thread nums: %zu.", max_thread_nums_);
         throw std::invalid_argument("Invalid number of threads.");
@@ -16,27 +22,24 @@ ThreadPool::ThreadPool(size_t max_thread_nums = 8, size_t max_task_nums = 16): m
         LOG_ERROR("Thread Pool: Invalid task queue size: %zu.", max_task_nums_);
         throw std::invalid_argument("Invalid task queue size.");
     }
+    // 排队中的任务最多max_task_nums个，执行中的任务最多每线程一个
+    slots_ = std::make_unique<Task[]>(max_task_nums_ + max_thread_nums_);
+    enqueue_ns_ = std::make_unique<int64_t[]>(max_task_nums_ + max_thread_nums_);
+    for (size_t i = 0; i < max_task_nums_ + max_thread_nums_; ++i) {
+        free_slots_.Push(&slots_[i]);
+    }
+    // 先建立全部本地队列，工作线程启动后即可互相窃取
+    for (size_t i = 0; i < max_thread_nums_; ++i) {
+        workers_.emplace_back(std::make_unique<Worker>());
+    }
     for (size_t i = 0; i < max_thread_nums_; ++i) {
         try {
-            thread_pool_.emplace_back([this]() {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> locker(thread_pool_mtx_);
-                        con_var_.wait(locker, [this]() {return !task_queue_.empty() || is_stop_;});
-                        if (is_stop_ && task_queue_.empty()) return;
-                        task = std::move(task_queue_.front());
-                        task_queue_.pop();
-                    }
-                    try {
-                        task();
-                    } catch (const std::exception& e) {
-                        LOG_ERROR("Thread Pool: Task threw an exception: %s", e.what());
-                    }
-                }
-            });
+            workers_[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
         } catch (const std::system_error& e) {
             LOG_ERROR("Thread Pool: Failed to create thread: %s", e.what());
+            is_stop_ = true;
+            park_cv_.notify_all();
+            for (size_t j = 0; j < i; ++j) workers_[j]->thread.join();
             throw;
         }
     }
@@ -45,12 +48,142 @@ ThreadPool::ThreadPool(size_t max_thread_nums = 8, size_t max_task_nums = 16): m
 
 ThreadPool::~ThreadPool() {
     {
-        std::lock_guard<std::mutex> locker(thread_pool_mtx_);
+        std::lock_guard<std::mutex> locker(park_mtx_);
         is_stop_ = true;
     }
-    con_var_.notify_all();
+    park_cv_.notify_all();
+    {
+        std::lock_guard<std::mutex> locker(space_mtx_);
+    }
+    space_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) worker->thread.join();
+    }
+}
+
+bool ThreadPool::TryReserve() {
+    size_t cnt = task_cnt_.load(std::memory_order_relaxed);
+    while (cnt < max_task_nums_) {
+        if (task_cnt_.compare_exchange_weak(cnt, cnt + 1, std::memory_order_seq_cst)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ThreadPool::Reserve(MS timeout) {
+    if (TryReserve()) {
+        return true;
+    }
+    if (timeout <= MS(0)) {
+        return false;
+    }
+    std::unique_lock<std::mutex> locker(space_mtx_);
+    waiter_cnt_.fetch_add(1, std::memory_order_seq_cst);
+    bool is_reserved = space_cv_.wait_for(locker, timeout, [this]() { return TryReserve(); });
+    waiter_cnt_.fetch_sub(1, std::memory_order_relaxed);
+    return is_reserved;
+}
+
+void ThreadPool::Release() {
+    task_cnt_.fetch_sub(1, std::memory_order_seq_cst);
+    if (waiter_cnt_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> locker(space_mtx_);
+        space_cv_.notify_one();
+    }
+}
+
+ThreadPool::Task* ThreadPool::AcquireSlot() {
+    // 已占用排队名额，必有空闲槽位；归还槽位的线程尚未完成发布时短暂重试
+    Task* slot;
+    while ((slot = free_slots_.Pop()) == nullptr) {
+        std::this_thread::yield();
+    }
+    return slot;
+}
+
+void ThreadPool::Push(Task* task) {
+    // 排队名额已占用，注入队列容量不小于名额数，不会长时间处于满状态
+    if (tls_pool_ != this || !workers_[tls_idx_]->deque.Push(task)) {
+        while (!inject_queue_.Push(task)) {
+            std::this_thread::yield();
+        }
+    }
+    // 与工作线程休眠前的检查配对：要么工作线程看到新任务，要么这里看到休眠线程
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeper_cnt_.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> locker(park_mtx_);
+        park_cv_.notify_one();
+    }
+}
+
+ThreadPool::Task* ThreadPool::FindTask(size_t idx) {
+    Task* task = workers_[idx]->deque.Pop();
+    if (task != nullptr) return task;
+    task = inject_queue_.Pop();
+    if (task != nullptr) return task;
 
-    for (auto& thread : thread_pool_) { 
-        if (thread.joinable()) thread.join();
+    // 从随机位置开始依次窃取其他线程的本地队列
+    thread_local uint32_t seed = static_cast<uint32_t>(idx) * 2654435761u + 1;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    size_t n = workers_.size();
+    for (size_t i = 0, start = seed % n; i < n; ++i) {
+        size_t victim = (start + i) % n;
+        if (victim == idx) continue;
+        task = workers_[victim]->deque.Steal();
+        if (task != nullptr) return task;
     }
-}
\ No newline at end of file
+    return nullptr;
+}
+
+void ThreadPool::WorkerLoop(size_t idx) {
+    tls_pool_ = this;
+    tls_idx_ = idx;
+    while (true) {
+        Task* task = FindTask(idx);
+        for (int i = 0; task == nullptr && i < SPIN_NUMS && !is_stop_; ++i) {
+            std::this_thread::yield();
+            task = FindTask(idx);
+        }
+        if (task == nullptr) {
+            std::unique_lock<std::mutex> locker(park_mtx_);
+            sleeper_cnt_.fetch_add(1, std::memory_order_seq_cst);
+            // 登记为休眠线程后再检查任务数，提交方在放入任务后检查休眠线程数，不会丢失唤醒
+            park_cv_.wait(locker, [this]() { return task_cnt_.load(std::memory_order_seq_cst) > 0 || is_stop_; });
+            sleeper_cnt_.fetch_sub(1, std::memory_order_relaxed);
+            if (is_stop_ && task_cnt_.load() == 0) return;
+            continue;
+        }
+
+        Release();
+        RecordDelay(task);
+        try {
+            (*task)();
+        } catch (const std::exception& e) {
+            LOG_ERROR("Thread Pool: Task threw an exception: %s", e.what());
+        }
+        task->Reset();
+        free_slots_.Push(task);
+    }
+}
+
+void ThreadPool::RecordDelay(Task* task) {
+    int64_t delay = NowNs() - enqueue_ns_[task - slots_.get()];
+    int64_t cur = min_delay_ns_.load(std::memory_order_relaxed);
+    while (delay < cur && !min_delay_ns_.compare_exchange_weak(cur, delay, std::memory_order_relaxed)) {}
+}
+
+std::chrono::nanoseconds ThreadPool::TakeMinQueueDelay() {
+    return std::chrono::nanoseconds(min_delay_ns_.exchange(INT64_MAX, std::memory_order_relaxed));
+}
+
+size_t ThreadPool::QueueSize() const {
+    return task_cnt_.load(std::memory_order_relaxed);
+}
+
+int64_t ThreadPool::NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
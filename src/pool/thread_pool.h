@@ -9,18 +9,33 @@
 #define THREAD_POOL_H
 
 #include "../log/log.h"
+#include "work_queue.h"
+#include "inplace_task.h"
 
-#include <queue>
 #include <vector>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include <thread>
 #include <chrono>
 #include <stdexcept>
-#include <functional>
+#include <type_traits>
 #include <condition_variable>
 
 using MS = std::chrono::milliseconds;
 
+/**
+ * @brief
+ * 工作窃取线程池
+ * - 每个工作线程持有Chase-Lev本地队列，工作线程内提交的任务压入自己的队列；Reactor等外部线程提交的任务进入全局注入队列。
+ * - 工作线程依次从本地队列、注入队列取任务，都为空时从其他线程的本地队列窃取。
+ * - 找不到任务时先自旋重试SPIN_NUMS轮再休眠，提交任务时只有存在休眠线程才加锁唤醒。
+ * - 排队任务总数不超过max_task_nums，队列满时AddTask最多等待timeout，超时返回false；timeout为0时不阻塞，立即返回。
+ * - 记录每个任务的排队时延，TakeMinQueueDelay返回上次调用以来的最小时延，供准入控制判断是否过载。
+ * - 任务以InplaceTask保存在预先分配的任务槽中，空闲槽位由无锁队列回收复用，提交与执行任务均不分配内存；
+ *   捕获超过TASK_CAPACITY字节的任务编译失败。
+ */
+
 class ThreadPool {
 public:
     explicit ThreadPool(size_t max_thread_nums, size_t max_task_nums);
@@ -32,14 +47,56 @@ public:
     template <typename F>
     bool AddTask(F&& task, MS timeout = MS(100));
 
+    // 快速路径：提交(obj->*Method)(arg)，如AddTask<&WebServer::OnRead>(this, client)，编译期检查调用合法性
+    template <auto Method, typename T, typename Arg>
+    bool AddTask(T* obj, Arg* arg, MS timeout = MS(100));
+
+    std::chrono::nanoseconds TakeMinQueueDelay();              // 取出并重置最小排队时延，期间无任务出队时返回max()
+    size_t QueueSize() const;                                   // 排队中的任务数
+
+    static const int SPIN_NUMS = 64;                            // 休眠前自旋查找任务的轮数
+    static const size_t DEQUE_CAPACITY = 256;                   // 每个工作线程本地队列容量
+    static const size_t TASK_CAPACITY = 48;                     // 任务可捕获的最大字节数
+
+    using Task = InplaceTask<TASK_CAPACITY>;
+
 private:
-    bool is_stop_;                                              // 线程停止标识符
-    std::mutex thread_pool_mtx_;                                // 线程互斥锁
-    std::condition_variable con_var_;                           // 条件变量
-    size_t max_task_nums_;                                      // 任务队列最大任务数
+
+    struct Worker {
+        WorkStealingDeque<Task> deque{DEQUE_CAPACITY};          // 本地任务队列
+        std::thread thread;                                     // 工作线程
+    };
+
+    bool Reserve(MS timeout);                                   // 占用一个排队名额，队列满时等待
+    bool TryReserve();
+    void Release();                                             // 任务被取出，归还名额
+    Task* AcquireSlot();                                        // 取得空闲任务槽
+    void Push(Task* task);                                      // 放入任务并按需唤醒休眠线程
+    Task* FindTask(size_t idx);                                 // 本地队列->注入队列->窃取
+    void WorkerLoop(size_t idx);
+    void RecordDelay(Task* task);                               // 记录任务的排队时延
+    static int64_t NowNs();
+
+    std::atomic<bool> is_stop_;                                 // 线程停止标识符
+    size_t max_task_nums_;                                      // 最大排队任务数
     size_t max_thread_nums_;                                    // 线程池线程线程数
-    std::vector<std::thread> thread_pool_;                      // 线程池
-    std::queue<std::function<void()>> task_queue_;              // 任务队列
+    std::atomic<size_t> task_cnt_;                              // 已提交尚未被取出的任务数
+    InjectQueue<Task> inject_queue_;                            // 全局注入队列
+    std::unique_ptr<Task[]> slots_;                             // 任务槽，数量为最大排队任务数加线程数
+    std::unique_ptr<int64_t[]> enqueue_ns_;                     // 各任务槽的入队时间
+    InjectQueue<Task> free_slots_;                              // 空闲任务槽
+    std::atomic<int64_t> min_delay_ns_;                         // 本周期内的最小排队时延
+    std::vector<std::unique_ptr<Worker>> workers_;              // 工作线程
+
+    std::mutex park_mtx_;                                       // 休眠互斥锁
+    std::condition_variable park_cv_;                           // 休眠条件变量
+    std::atomic<size_t> sleeper_cnt_;                           // 休眠中的工作线程数
+    std::mutex space_mtx_;                                      // 等待队列空位的互斥锁
+    std::condition_variable space_cv_;                          // 等待队列空位的条件变量
+    std::atomic<size_t> waiter_cnt_;                            // 等待队列空位的提交者数
+
+    static thread_local ThreadPool* tls_pool_;                  // 当前线程所属的线程池
+    static thread_local size_t tls_idx_;                        // 当前线程在线程池中的编号
 };
 
 template <typename F>
@@ -49,16 +106,29 @@ bool ThreadPool::AddTask(F&& task, MS timeout) {
         throw std::runtime_error("Thread Pool has stopped, can not add new task.");
     }
 
-    {
-        std::unique_lock<std::mutex> locker(thread_pool_mtx_);
-        if (!con_var_.wait_for(locker, timeout, [this]() {return task_queue_.size() < max_task_nums_;})) {
-            LOG_WARN("Thread Pool: Task queue is full, failed to add new task within timeout.");
-            return false;
-        }
-        task_queue_.emplace(std::forward<F>(task));
+    if (!Reserve(timeout)) {
+        LOG_WARN("Thread Pool: Task queue is full, failed to add new task within timeout.");
+        return false;
     }
-    con_var_.notify_one();
+    Task* slot = AcquireSlot();
+    *slot = Task(std::forward<F>(task));
+    enqueue_ns_[slot - slots_.get()] = NowNs();
+    Push(slot);
     return true;
 }
 
-#endif
\ No newline at end of file
+template <auto Method, typename T, typename Arg>
+bool ThreadPool::AddTask(T* obj, Arg* arg, MS timeout) {
+    static_assert(std::is_member_function_pointer_v<decltype(Method)>, "Thread Pool: Method must be a member function pointer.");
+    static_assert(std::is_invocable_v<decltype(Method), T*, Arg*>, "Thread Pool: Method can not be called with (T*, Arg*).");
+
+    struct MemberCall {
+        T* obj;
+        Arg* arg;
+        void operator()() const { (obj->*Method)(arg); }
+    };
+    static_assert(std::is_trivially_copyable_v<MemberCall> && sizeof(MemberCall) <= TASK_CAPACITY);
+    return AddTask(MemberCall{obj, arg}, timeout);
+}
+
+#endif
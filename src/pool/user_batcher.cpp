@@ -0,0 +1,281 @@
+/**
+ * @file user_batcher.cpp
+ * @author chenyinjie
+ * @date 2024-11-06
+ * @copyright Apache 2.0
+ */
+
+#include "user_batcher.h"
+
+UserBatcher::UserBatcher(AsyncSQLPool* pool, size_t batch_size, int window_us, size_t max_pending)
+    : pool_(pool), batch_size_(batch_size), window_(window_us), max_pending_(max_pending),
+      login_inflight_(0), is_register_inflight_(false), is_stop_(false), batch_nums_(0), request_nums_(0) {
+    if (pool_ == nullptr || batch_size_ == 0 || window_us < 0) {
+        LOG_ERROR("User Batcher: Invalid pool or batch size: %zu, window: %d us.", batch_size, window_us);
+        throw std::invalid_argument("Invalid user batcher arguments.");
+    }
+    thread_ = std::thread(&UserBatcher::Run, this);
+}
+
+UserBatcher::~UserBatcher() {
+    Stop();
+}
+
+void UserBatcher::Stop() {
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        is_stop_ = true;
+    }
+    cond_.notify_one();
+    if (thread_.joinable()) thread_.join();
+}
+
+bool UserBatcher::Login(std::string name, std::string hashed_pwd, Callback callback) {
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (is_stop_ || logins_.size() + registers_.size() >= max_pending_) return false;
+        if (logins_.empty()) {
+            login_start_ = std::chrono::steady_clock::now();
+        }
+        logins_.push_back({std::move(name), std::move(hashed_pwd), std::move(callback)});
+        // 只在需要重新计算等待时间或已攒满一批时唤醒合并线程
+        if (logins_.size() != 1 && logins_.size() != batch_size_) return true;
+    }
+    cond_.notify_one();
+    return true;
+}
+
+bool UserBatcher::Register(std::string name, std::string hashed_pwd, Callback callback) {
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        if (is_stop_ || logins_.size() + registers_.size() >= max_pending_) return false;
+        registers_.push_back({std::move(name), std::move(hashed_pwd), std::move(callback)});
+        if (registers_.size() != 1 || is_register_inflight_) return true;
+    }
+    cond_.notify_one();
+    return true;
+}
+
+uint64_t UserBatcher::GetBatchNums() const {
+    return batch_nums_.load(std::memory_order_relaxed);
+}
+
+uint64_t UserBatcher::GetRequestNums() const {
+    return request_nums_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief
+ * 派生表逐行携带序号与用户名，与user表连接后只返回已存在的用户，由序号对应到请求
+ * SELECT k.idx, u.password FROM (SELECT 0 AS idx, <name0> AS name UNION ALL SELECT 1, <name1> ...) AS k
+ * JOIN user AS u ON u.username = k.name
+ */
+std::string UserBatcher::BuildLookupSQL(const std::vector<std::string>& names) {
+    std::string sql = "SELECT k.idx, u.password FROM (";
+    for (size_t i = 0; i < names.size(); ++i) {
+        sql += (i == 0) ? "SELECT 0 AS idx, " : " UNION ALL SELECT ";
+        if (i != 0) sql += std::to_string(i) + ", ";
+        sql += AsyncSQLPool::ToSQLLiteral(names[i]);
+        if (i == 0) sql += " AS name";
+    }
+    sql += ") AS k JOIN user AS u ON u.username = k.name";
+    return sql;
+}
+
+std::string UserBatcher::BuildInsertSQL(const std::vector<std::pair<std::string, std::string>>& users) {
+    std::string sql = "INSERT INTO user(username, password) VALUES ";
+    for (size_t i = 0; i < users.size(); ++i) {
+        if (i != 0) sql += ", ";
+        sql += "(" + AsyncSQLPool::ToSQLLiteral(users[i].first) + ", " + AsyncSQLPool::ToSQLLiteral(users[i].second) + ")";
+    }
+    return sql;
+}
+
+/**
+ * @brief
+ * 合并线程
+ * 登录：没有批次在执行、攒满一批或第一个请求已等待window_时发出；注册：上一批结束后立即发出
+ */
+void UserBatcher::Run() {
+    std::unique_lock<std::mutex> locker(mtx_);
+    while (!is_stop_) {
+        bool is_expired = std::chrono::steady_clock::now() - login_start_ >= window_;
+        if (!logins_.empty() && (login_inflight_ == 0 || logins_.size() >= batch_size_ || is_expired)) {
+            size_t cnt = std::min(batch_size_, logins_.size());
+            Batch batch(std::make_move_iterator(logins_.begin()), std::make_move_iterator(logins_.begin() + cnt));
+            logins_.erase(logins_.begin(), logins_.begin() + cnt);
+            login_start_ = std::chrono::steady_clock::now();
+            ++login_inflight_;
+            locker.unlock();
+            FlushLogin(std::move(batch));
+            locker.lock();
+            continue;
+        }
+        if (!registers_.empty() && !is_register_inflight_) {
+            size_t cnt = std::min(batch_size_, registers_.size());
+            Batch batch(std::make_move_iterator(registers_.begin()), std::make_move_iterator(registers_.begin() + cnt));
+            registers_.erase(registers_.begin(), registers_.begin() + cnt);
+            is_register_inflight_ = true;
+            locker.unlock();
+            FlushRegister(std::move(batch));
+            locker.lock();
+            continue;
+        }
+        if (!logins_.empty()) {
+            cond_.wait_until(locker, login_start_ + window_);
+        } else {
+            cond_.wait(locker);
+        }
+    }
+
+    Batch pending;
+    pending.swap(logins_);
+    for (Request& req : registers_) {
+        pending.push_back(std::move(req));
+    }
+    registers_.clear();
+    locker.unlock();
+    Fail(pending);
+}
+
+void UserBatcher::FlushLogin(Batch batch) {
+    std::vector<std::string> names;
+    names.reserve(batch.size());
+    for (const Request& req : batch) {
+        names.push_back(req.name);
+    }
+    batch_nums_.fetch_add(1, std::memory_order_relaxed);
+    request_nums_.fetch_add(batch.size(), std::memory_order_relaxed);
+
+    auto shared = std::make_shared<Batch>(std::move(batch));
+    auto done = [this]() {
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            --login_inflight_;
+        }
+        cond_.notify_one();
+    };
+    bool is_submit = pool_->Submit(BuildLookupSQL(names), [shared, done](MYSQL*, MYSQL_RES* res, bool is_ok) {
+        if (!is_ok) {
+            Fail(*shared);
+        } else {
+            std::vector<std::string> pwds = ReadLookup(res, shared->size());
+            std::vector<bool> results(shared->size());
+            for (size_t i = 0; i < shared->size(); ++i) {
+                results[i] = !pwds[i].empty() && pwds[i] == (*shared)[i].hashed_pwd;
+            }
+            Complete(*shared, results);
+        }
+        done();
+    });
+    if (!is_submit) {
+        Fail(*shared);
+        done();
+    }
+}
+
+// 批内重复的用户名直接失败，其余先查出已存在的用户，再插入剩余用户
+void UserBatcher::FlushRegister(Batch batch) {
+    Batch unique;
+    Batch duplicate;
+    std::unordered_set<std::string> names;
+    for (Request& req : batch) {
+        if (names.insert(req.name).second) {
+            unique.push_back(std::move(req));
+        } else {
+            duplicate.push_back(std::move(req));
+        }
+    }
+    Fail(duplicate);
+    batch_nums_.fetch_add(1, std::memory_order_relaxed);
+    request_nums_.fetch_add(batch.size(), std::memory_order_relaxed);
+
+    std::vector<std::string> lookup;
+    lookup.reserve(unique.size());
+    for (const Request& req : unique) {
+        lookup.push_back(req.name);
+    }
+    auto shared = std::make_shared<Batch>(std::move(unique));
+    bool is_submit = pool_->Submit(BuildLookupSQL(lookup), [this, shared](MYSQL*, MYSQL_RES* res, bool is_ok) {
+        if (!is_ok) {
+            Fail(*shared);
+            FinishRegister();
+            return;
+        }
+        InsertUsers(shared, res);
+    });
+    if (!is_submit) {
+        Fail(*shared);
+        FinishRegister();
+    }
+}
+
+void UserBatcher::InsertUsers(std::shared_ptr<Batch> batch, MYSQL_RES* res) {
+    std::vector<std::string> pwds = ReadLookup(res, batch->size());
+    std::vector<std::pair<std::string, std::string>> users;
+    auto inserts = std::make_shared<Batch>();
+    Batch exists;
+    for (size_t i = 0; i < batch->size(); ++i) {
+        Request& req = (*batch)[i];
+        if (pwds[i].empty()) {
+            users.emplace_back(req.name, req.hashed_pwd);
+            inserts->push_back(std::move(req));
+        } else {
+            exists.push_back(std::move(req));
+        }
+    }
+    LOG_DEBUG("User Batcher: Register %zu users, %zu already exist.", inserts->size(), exists.size());
+    Fail(exists);
+    if (inserts->empty()) {
+        FinishRegister();
+        return;
+    }
+
+    size_t cnt = inserts->size();
+    bool is_submit = pool_->Submit(BuildInsertSQL(users), [this, inserts, cnt](MYSQL* sql, MYSQL_RES*, bool is_ok) {
+        bool is_inserted = is_ok && sql != nullptr && mysql_affected_rows(sql) == cnt;
+        if (!is_inserted) {
+            LOG_ERROR("User Batcher: Insert %zu users failed.", cnt);
+        }
+        Complete(*inserts, std::vector<bool>(cnt, is_inserted));
+        FinishRegister();
+    });
+    if (!is_submit) {
+        Fail(*inserts);
+        FinishRegister();
+    }
+}
+
+void UserBatcher::FinishRegister() {
+    {
+        std::lock_guard<std::mutex> locker(mtx_);
+        is_register_inflight_ = false;
+    }
+    cond_.notify_one();
+}
+
+std::vector<std::string> UserBatcher::ReadLookup(MYSQL_RES* res, size_t size) {
+    std::vector<std::string> pwds(size);
+    if (res == nullptr) return pwds;
+    MYSQL_ROW row;
+    while ((row = mysql_fetch_row(res)) != nullptr) {
+        if (row[0] == nullptr || row[1] == nullptr) continue;
+        size_t idx = std::strtoul(row[0], nullptr, 10);
+        if (idx < size) pwds[idx] = row[1];
+    }
+    return pwds;
+}
+
+void UserBatcher::Complete(Batch& batch, const std::vector<bool>& results) {
+    for (size_t i = 0; i < batch.size(); ++i) {
+        try {
+            batch[i].callback(results[i]);
+        } catch (const std::exception& e) {
+            LOG_ERROR("User Batcher: Callback threw an exception: %s", e.what());
+        }
+    }
+}
+
+void UserBatcher::Fail(Batch& batch) {
+    Complete(batch, std::vector<bool>(batch.size(), false));
+}
@@ -0,0 +1,98 @@
+/**
+ * @file user_batcher.h
+ * @author chenyinjie
+ * @date 2024-11-06
+ * @copyright Apache 2.0
+ */
+
+#ifndef USER_BATCHER_H
+#define USER_BATCHER_H
+
+#include "../log/log.h"
+#include "async_sql_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief
+ * 登录、注册请求的批量合并器，建立在异步查询池之上
+ * - 登录：等待中的查询合并为一条语句，以派生表携带每个请求的序号与用户名，与user表连接后按序号取回各自的密码。
+ *   连接比较使用列的排序规则，与逐条查询的匹配结果一致。
+ * - 注册(组提交)：同一时刻只有一批注册在执行，执行期间到达的注册进入下一批。每批先按上述方式查出已存在的用户名，
+ *   再将其余用户以一条多行INSERT写入；批内重复的用户名只保留第一个。
+ * - 没有批次在执行时立即发出，数据库空闲时不增加延迟；有批次在执行时最多等待window_us或攒满batch_size再发出。
+ * - 回调参数为是否验证通过，在异步查询池或合并器线程中执行；数据库出错时所有请求以失败回调。
+ * - 等待中的请求数达到max_pending时拒绝提交。
+ * - 执行中批次的回调会访问合并器：应先Stop，再销毁异步查询池(未完成的查询以失败回调)，最后销毁合并器。
+ */
+
+class UserBatcher {
+public:
+    using Callback = std::function<void(bool is_verified)>;
+
+    UserBatcher(AsyncSQLPool* pool, size_t batch_size = 64, int window_us = 500, size_t max_pending = 4096);
+    ~UserBatcher();
+
+    UserBatcher(const UserBatcher&) = delete;
+    UserBatcher& operator=(const UserBatcher&) = delete;
+
+    void Stop();                                            // 停止合并，等待中的请求以失败回调
+    bool Login(std::string name, std::string hashed_pwd, Callback callback);       // 等待中的请求已满时返回false
+    bool Register(std::string name, std::string hashed_pwd, Callback callback);
+
+    uint64_t GetBatchNums() const;                          // 已发出的批次数
+    uint64_t GetRequestNums() const;                        // 已合并的请求数
+
+    // 批量查询语句：返回(序号, 密码)，只包含已存在的用户
+    static std::string BuildLookupSQL(const std::vector<std::string>& names);
+    // 多行插入语句
+    static std::string BuildInsertSQL(const std::vector<std::pair<std::string, std::string>>& users);
+
+private:
+    struct Request {
+        std::string name;
+        std::string hashed_pwd;
+        Callback callback;
+    };
+
+    using Batch = std::vector<Request>;
+
+    void Run();                                             // 合并线程
+    void FlushLogin(Batch batch);
+    void FlushRegister(Batch batch);
+    void InsertUsers(std::shared_ptr<Batch> batch, MYSQL_RES* res);
+    void FinishRegister();                                  // 一批注册结束，允许发出下一批
+    static std::vector<std::string> ReadLookup(MYSQL_RES* res, size_t size);    // 按序号取回密码，不存在为空串
+    static void Complete(Batch& batch, const std::vector<bool>& results);
+    static void Fail(Batch& batch);
+
+    AsyncSQLPool* pool_;
+    size_t batch_size_;                                     // 每批最大请求数
+    std::chrono::microseconds window_;                      // 有批次在执行时的最长等待时间
+    size_t max_pending_;                                    // 最大等待请求数
+
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::vector<Request> logins_;                           // 等待合并的登录
+    std::vector<Request> registers_;                        // 等待合并的注册
+    std::chrono::steady_clock::time_point login_start_;     // 本批第一个登录到达的时间
+    int login_inflight_;                                    // 执行中的登录批次数
+    bool is_register_inflight_;                             // 是否有注册批次在执行
+    bool is_stop_;
+
+    std::atomic<uint64_t> batch_nums_;
+    std::atomic<uint64_t> request_nums_;
+    std::thread thread_;
+};
+
+#endif
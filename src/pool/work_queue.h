@@ -0,0 +1,191 @@
+/**
+ * @file work_queue.h
+ * @author chenyinjie
+ * @date 2024-11-01
+ * @copyright Apache 2.0
+ */
+
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @brief
+ * Chase-Lev工作窃取双端队列(固定容量)
+ * - 只有所属线程调用Push/Pop，在底部后进先出；其他线程调用Steal，从顶部先进先出窃取。
+ * - 内存序参照Lê等人针对弱内存模型的实现，只有最后一个元素上的竞争需要CAS。
+ * - 元素为指针，队列为空或窃取竞争失败时返回nullptr。
+ */
+
+template <typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity = 1024);
+    ~WorkStealingDeque() = default;
+
+    WorkStealingDeque(const WorkStealingDeque&) = delete;
+    WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+    bool Push(T* item);                                         // 所属线程压入底部，队列满时返回false
+    T* Pop();                                                   // 所属线程从底部弹出
+    T* Steal();                                                 // 其他线程从顶部窃取
+    bool IsEmpty() const noexcept;
+
+private:
+    size_t mask_;
+    std::unique_ptr<std::atomic<T*>[]> buffer_;
+    alignas(64) std::atomic<int64_t> top_;                     // 窃取端
+    alignas(64) std::atomic<int64_t> bottom_;                  // 所属线程端
+};
+
+template <typename T>
+WorkStealingDeque<T>::WorkStealingDeque(size_t capacity): top_(0), bottom_(0) {
+    size_t cap = 1;
+    while (cap < capacity) cap <<= 1;
+    mask_ = cap - 1;
+    buffer_ = std::make_unique<std::atomic<T*>[]>(cap);
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::Push(T* item) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > static_cast<int64_t>(mask_)) {
+        return false;
+    }
+    buffer_[b & mask_].store(item, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+template <typename T>
+T* WorkStealingDeque<T>::Pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+        bottom_.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    T* item = buffer_[b & mask_].load(std::memory_order_relaxed);
+    if (t == b) {
+        // 只剩最后一个元素，与窃取者竞争
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            item = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+}
+
+template <typename T>
+T* WorkStealingDeque<T>::Steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+        return nullptr;
+    }
+    T* item = buffer_[t & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+        return nullptr;
+    }
+    return item;
+}
+
+template <typename T>
+bool WorkStealingDeque<T>::IsEmpty() const noexcept {
+    return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief
+ * 有界多生产者-多消费者无锁队列(Vyukov)
+ * 每个槽位带序号，生产者与消费者各自以CAS推进位置，槽位序号表明其可写或可读，不需要加锁。
+ * 作为线程池的全局注入队列，Reactor等外部线程提交的任务由此进入，各工作线程从中取出。
+ */
+
+template <typename T>
+class InjectQueue {
+public:
+    explicit InjectQueue(size_t capacity = 1024);
+    ~InjectQueue() = default;
+
+    InjectQueue(const InjectQueue&) = delete;
+    InjectQueue& operator=(const InjectQueue&) = delete;
+
+    bool Push(T* item);                                         // 队列满时返回false
+    T* Pop();                                                   // 队列空时返回nullptr
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T* data;
+    };
+
+    size_t mask_;
+    std::unique_ptr<Cell[]> buffer_;
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) std::atomic<size_t> dequeue_pos_;
+};
+
+template <typename T>
+InjectQueue<T>::InjectQueue(size_t capacity): enqueue_pos_(0), dequeue_pos_(0) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    mask_ = cap - 1;
+    buffer_ = std::make_unique<Cell[]>(cap);
+    for (size_t i = 0; i < cap; ++i) {
+        buffer_[i].seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+bool InjectQueue<T>::Push(T* item) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &buffer_[pos & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    cell->data = item;
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+template <typename T>
+T* InjectQueue<T>::Pop() {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+        cell = &buffer_[pos & mask_];
+        size_t seq = cell->seq.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return nullptr;
+        } else {
+            pos = dequeue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+    T* item = cell->data;
+    cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+    return item;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * @file admission.cpp
+ * @author chenyinjie
+ * @date 2024-11-03
+ * @copyright Apache 2.0
+ */
+
+#include "admission.h"
+
+AdmissionController::AdmissionController(ThreadPool* pool, MS target, MS interval)
+    : pool_(pool), target_(target), interval_(interval), next_check_(std::chrono::steady_clock::now() + interval),
+      is_overload_(false), shed_connects_(0), shed_requests_(0) {}
+
+bool AdmissionController::AdmitConnect() {
+    Update(std::chrono::steady_clock::now());
+    if (is_overload_) {
+        shed_connects_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void AdmissionController::Reject(int fd, bool is_connect) {
+    if (!is_connect) {
+        shed_requests_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 套接字发送缓冲区足以容纳响应，发送不完整时直接放弃，不阻塞Reactor
+    if (send(fd, SERVICE_UNAVAILABLE.data(), SERVICE_UNAVAILABLE.size(), MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+        LOG_WARN("Admission: Failed to send 503 to client [%d]: %s.", fd, strerror(errno));
+    }
+    // 接收缓冲区中留有未读的请求时close会发送RST，客户端可能收不到503：
+    // 先关闭写端发送FIN，再读走已到达的请求，读取量有上限，不阻塞Reactor
+    shutdown(fd, SHUT_WR);
+    char buf[4096];
+    for (size_t total = 0; total < MAX_DRAIN_BYTES; ) {
+        ssize_t len = recv(fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (len <= 0) break;
+        total += len;
+    }
+}
+
+bool AdmissionController::IsOverload() const {
+    return is_overload_;
+}
+
+uint64_t AdmissionController::GetShedConnects() const {
+    return shed_connects_.load(std::memory_order_relaxed);
+}
+
+uint64_t AdmissionController::GetShedRequests() const {
+    return shed_requests_.load(std::memory_order_relaxed);
+}
+
+void AdmissionController::Update(std::chrono::steady_clock::time_point now) {
+    if (pool_ == nullptr || now < next_check_) return;
+    next_check_ = now + interval_;
+
+    std::chrono::nanoseconds min_delay = pool_->TakeMinQueueDelay();
+    bool is_overload = (min_delay == std::chrono::nanoseconds::max()) ? pool_->QueueSize() > 0 : min_delay > target_;
+    if (is_overload && !is_overload_) {
+        LOG_WARN("Admission: Enter overload, min queue delay: %lld us, shed connects: %llu, shed requests: %llu.",
+                 static_cast<long long>(min_delay.count() / 1000), static_cast<unsigned long long>(GetShedConnects()),
+                 static_cast<unsigned long long>(GetShedRequests()));
+    } else if (!is_overload && is_overload_) {
+        LOG_INFO("Admission: Leave overload, shed connects: %llu, shed requests: %llu.",
+                 static_cast<unsigned long long>(GetShedConnects()), static_cast<unsigned long long>(GetShedRequests()));
+    }
+    is_overload_ = is_overload;
+}
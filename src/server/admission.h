@@ -0,0 +1,69 @@
+/**
+ * @file admission.h
+ * @author chenyinjie
+ * @date 2024-11-03
+ * @copyright Apache 2.0
+ */
+
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "../log/log.h"
+#include "../pool/thread_pool.h"
+
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <string_view>
+
+// 预先生成的过载响应，拒绝连接与请求时直接发送
+inline constexpr std::string_view SERVICE_UNAVAILABLE =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Retry-After: 1\r\n"
+    "Connection: close\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 20\r\n"
+    "\r\n"
+    "Service Unavailable\n";
+
+/**
+ * @brief
+ * 基于排队时延的准入控制(参照CoDel)
+ * - 每经过一个interval，从线程池取出该周期内任务的最小排队时延：最小时延超过target说明队列持续积压而非短时突发，进入过载状态；
+ *   低于target时退出过载状态。周期内没有任务出队但队列非空同样视为过载。
+ * - 过载状态下拒绝全部新连接，已有连接的请求仍然派发；线程池队列已满时由调用者以非阻塞方式拒绝单个请求。
+ * - 被拒绝的客户端收到SERVICE_UNAVAILABLE，拒绝数可随时读取。
+ * - AdmitConnect只在Reactor线程中调用，Reject与计数可在任意线程调用。
+ * - pool为空时不检测过载，只用于拒绝请求并计数(多Reactor模式)。
+ */
+
+class AdmissionController {
+public:
+    explicit AdmissionController(ThreadPool* pool, MS target = MS(5), MS interval = MS(100));
+    ~AdmissionController() = default;
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    bool AdmitConnect();                                        // 是否接受新连接，拒绝时计数
+    void Reject(int fd, bool is_connect);                       // 发送503并关闭写端、读走已到达的请求，不关闭fd
+
+    bool IsOverload() const;
+    uint64_t GetShedConnects() const;                           // 被拒绝的新连接数
+    uint64_t GetShedRequests() const;                           // 被拒绝的请求数
+
+private:
+    void Update(std::chrono::steady_clock::time_point now);     // 到达周期边界时更新过载状态
+
+    static const size_t MAX_DRAIN_BYTES = 64 * 1024;            // 拒绝时最多读走的请求字节数
+
+    ThreadPool* pool_;                                          // 被控制的线程池，可为空
+    std::chrono::nanoseconds target_;                           // 可接受的排队时延
+    std::chrono::nanoseconds interval_;                         // 统计周期
+    std::chrono::steady_clock::time_point next_check_;          // 下一次更新状态的时间
+    bool is_overload_;                                          // 过载标识符
+    std::atomic<uint64_t> shed_connects_;
+    std::atomic<uint64_t> shed_requests_;
+};
+
+#endif
@@ -0,0 +1,68 @@
+/**
+ * @file connect_table.cpp
+ * @author chenyinjie
+ * @date 2024-10-24
+ * @copyright Apache 2.0
+ */
+
+#include "connect_table.h"
+
+ConnectTable::ConnectTable(int max_fd)
+    : max_fd_(max_fd), chunks_((max_fd + CHUNK_SIZE - 1) / CHUNK_SIZE) {}
+
+HTTPConnect* ConnectTable::Acquire(int fd) {
+    if (fd < 0 || fd >= max_fd_) {
+        LOG_ERROR("ConnectTable: fd: %d out of range.", fd);
+        return nullptr;
+    }
+    std::unique_ptr<Slot[]>& chunk = chunks_[fd >> CHUNK_SHIFT];
+    if (!chunk) {
+        chunk = std::make_unique<Slot[]>(CHUNK_SIZE);
+    }
+    Slot* slot = &chunk[fd & (CHUNK_SIZE - 1)];
+    slot->gen.fetch_add(1, std::memory_order_release);
+    return &slot->client;
+}
+
+void ConnectTable::Release(HTTPConnect* client) {
+    Slot* slot = client ? GetSlot(client->GetFd()) : nullptr;
+    if (slot != nullptr && &slot->client == client) {
+        slot->gen.fetch_add(1, std::memory_order_release);
+    }
+}
+
+HTTPConnect* ConnectTable::Get(int fd) const {
+    Slot* slot = GetSlot(fd);
+    return slot ? &slot->client : nullptr;
+}
+
+uint64_t ConnectTable::GetTag(const HTTPConnect* client) const {
+    Slot* slot = GetSlot(client->GetFd());
+    if (slot == nullptr) {
+        LOG_ERROR("ConnectTable: No slot for client fd: %d.", client->GetFd());
+        return 0;
+    }
+    return MakeTag(slot, slot->gen.load(std::memory_order_acquire));
+}
+
+HTTPConnect* ConnectTable::Resolve(uint64_t tag) const {
+    Slot* slot = reinterpret_cast<Slot*>(tag & PTR_MASK);
+    uint16_t gen = static_cast<uint16_t>(tag >> TAG_SHIFT);
+    if (slot == nullptr || slot->gen.load(std::memory_order_acquire) != gen) {
+        return nullptr;
+    }
+    return &slot->client;
+}
+
+ConnectTable::Slot* ConnectTable::GetSlot(int fd) const {
+    if (fd < 0 || fd >= max_fd_) {
+        return nullptr;
+    }
+    const std::unique_ptr<Slot[]>& chunk = chunks_[fd >> CHUNK_SHIFT];
+    return chunk ? &chunk[fd & (CHUNK_SIZE - 1)] : nullptr;
+}
+
+uint64_t ConnectTable::MakeTag(const Slot* slot, uint16_t gen) {
+    // x86-64/AArch64用户态地址不超过48位，高16位用于存放代数
+    return (static_cast<uint64_t>(gen) << TAG_SHIFT) | (reinterpret_cast<uint64_t>(slot) & PTR_MASK);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file connect_table.h
+ * @author chenyinjie
+ * @date 2024-10-24
+ * @copyright Apache 2.0
+ */
+
+#ifndef CONNECT_TABLE_H
+#define CONNECT_TABLE_H
+
+#include "../log/log.h"
+#include "../http/http_connect.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief
+ * 以fd为下标的连接槽表
+ * - 槽位按块(CHUNK_SIZE个连接)在首次使用时分配，此后常驻复用，连接对象地址在整个生命周期内不变。
+ * - 每个槽位带16位代数，连接建立与关闭时递增。
+ * - 事件数据使用带标签指针：低48位为槽位地址，高16位为代数。分发时直接由事件数据得到连接，无需查表；
+ *   若事件在同一批次内因连接关闭、fd被新连接复用而过期，代数不一致，Resolve返回nullptr。
+ * - 监听套接字等以fd作为事件数据的注册取值小于MAX_FD，不会与连接地址冲突。
+ */
+
+class ConnectTable {
+public:
+    explicit ConnectTable(int max_fd);
+    ~ConnectTable() = default;
+
+    ConnectTable(const ConnectTable&) = delete;
+    ConnectTable& operator=(const ConnectTable&) = delete;
+
+    HTTPConnect* Acquire(int fd);                           // 为新连接取得槽位，递增代数
+    void Release(HTTPConnect* client);                      // 连接关闭，递增代数使已有事件失效
+    HTTPConnect* Get(int fd) const;                         // 按fd获取连接，槽位未分配时返回nullptr
+    uint64_t GetTag(const HTTPConnect* client) const;       // 连接当前的事件数据
+    HTTPConnect* Resolve(uint64_t tag) const;               // 由事件数据获取连接，过期时返回nullptr
+
+private:
+    static constexpr int CHUNK_SHIFT = 8;
+    static constexpr int CHUNK_SIZE = 1 << CHUNK_SHIFT;     // 每块连接数
+    static constexpr int TAG_SHIFT = 48;
+    static constexpr uint64_t PTR_MASK = (1ULL << TAG_SHIFT) - 1;
+
+    struct Slot {
+        HTTPConnect client;                                 // 连接对象
+        std::atomic<uint16_t> gen{0};                       // 槽位代数
+    };
+
+    Slot* GetSlot(int fd) const;
+    static uint64_t MakeTag(const Slot* slot, uint16_t gen);
+
+    int max_fd_;                                            // 最大fd
+    std::vector<std::unique_ptr<Slot[]>> chunks_;           // 槽位块，按需分配
+};
+
+#endif
@@ -11,49 +11,112 @@ WebServer::WebServer(
     int port, int trigger_mode, bool is_linger, 
     int sql_port, const char* sql_user, const char* sql_pwd, const char* db_name, 
     int connect_pool_nums, int thread_pool_nums, 
-    bool is_async, int block_queue_size, int timeout
+    bool is_async, int block_queue_size, int timeout,
+    int reactor_nums, int event_backend, bool is_precompress, int timer_type,
+    int db_thread_nums, bool is_db_async, int user_store, int log_overflow, int log_level
     )
 {   
     port_ = port;    
     timeoutMS_ = timeout;
-
-    // 初始化日志系统
-    if (!Log::GetLogInstance().Init(500, is_async, block_queue_size, 3)) {
+    listen_fd_ = -1;
+    wakeup_fd_ = -1;
+    is_close_ = false;
+    backend_type_ = (event_backend == 1) ? EVENT_BACKEND::IO_URING : EVENT_BACKEND::EPOLL;
+    timer_type_ = (timer_type == 0) ? TIMER_TYPE::HEAP : TIMER_TYPE::WHEEL;
+
+    // 初始化日志系统，异步队列已满时按log_overflow丢弃或等待，低于log_level的日志不格式化直接丢弃
+    Log::GetLogInstance().SetLevel(static_cast<LOG_LEVEL>(log_level));
+    LOG_OVERFLOW overflow = (log_overflow == 1) ? LOG_OVERFLOW::BLOCK : LOG_OVERFLOW::DROP;
+    if (!Log::GetLogInstance().Init(500, is_async, block_queue_size, 3, overflow)) {
         LOG_ERROR("Server: Init Log system failed.");
         is_close_ = true;
     } else {
         LOG_INFO("Server: Init Log system success.");
     }
 
-    // 初始化线程池
-    try {
-        thread_pool_ = std::make_unique<ThreadPool>(thread_pool_nums, 16);
-    } catch (const std::exception& e) {
-        LOG_ERROR("Failed to init thread pool: %s.", e.what());
-        is_close_ = true;  // 设置服务器关闭标志
+    // 初始化线程池，多Reactor模式下连接在各自的事件循环线程内处理，不需要线程池
+    if (reactor_nums <= 0) {
+        try {
+            thread_pool_ = std::make_unique<ThreadPool>(thread_pool_nums, 16);
+            admission_ = std::make_unique<AdmissionController>(thread_pool_.get());
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to init thread pool: %s.", e.what());
+            is_close_ = true;  // 设置服务器关闭标志
+        }
     }
 
-    // 初始化数据库连接池
-    if (!SQLConnectPool::GetSQLConnectPoolInstance()->Init("localhost", sql_user, sql_pwd, db_name, sql_port, connect_pool_nums)) {
-        LOG_ERROR("Sever: Init SQL Connect Pool failed.");
+    // 本地用户存储不需要数据库，登录、注册在I/O线程内直接执行
+    if (user_store == 1) {
+        try {
+            user_store_ = CreateUserStore(USER_STORE::MMAP, (std::filesystem::path(PROJECT_ROOT) / "userdata").string());
+        } catch (const std::exception& e) {
+            LOG_ERROR("Server: Failed to init user store: %s.", e.what());
+            is_close_ = true;
+        }
+    }
+
+    // 初始化非阻塞数据库访问，客户端库不支持时退回同步连接池与执行器
+    if (user_store != 1 && is_db_async) {
+        try {
+            async_sql_ = std::make_unique<AsyncSQLPool>("localhost", sql_user, sql_pwd, db_name, sql_port,
+                                                        connect_pool_nums, db_thread_nums, ASYNC_QUEUE_SIZE);
+            user_batcher_ = std::make_unique<UserBatcher>(async_sql_.get());
+        } catch (const std::exception& e) {
+            LOG_WARN("Server: Async SQL unavailable: %s, use database executor.", e.what());
+            async_sql_.reset();
+        }
+    }
+
+    if (user_store != 1 && !async_sql_) {
+        // 初始化数据库连接池，预先建立与执行器线程数相同的连接，其余按需建立
+        int min_connect_nums = std::max(1, std::min(db_thread_nums, connect_pool_nums));
+        if (!SQLConnectPool::GetSQLConnectPoolInstance()->Init("localhost", sql_user, sql_pwd, db_name, sql_port,
+                                                               connect_pool_nums, min_connect_nums)) {
+            LOG_ERROR("Sever: Init SQL Connect Pool failed.");
+            is_close_ = true;
+        } else {
+            LOG_INFO("Sever: Init SQL Connect Pool sucess.");
+        }
+
+        // 初始化数据库执行器，每个线程至多占用一个数据库连接，线程数不超过连接数
+        try {
+            db_pool_ = std::make_unique<ThreadPool>(std::max(1, std::min(db_thread_nums, connect_pool_nums)), DB_QUEUE_SIZE);
+            user_store_ = CreateUserStore(USER_STORE::MYSQL);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Server: Failed to init database executor: %s.", e.what());
+            is_close_ = true;
+        }
+    }
+    HTTPConnect::user_store = user_store_.get();
+
+    // 初始化定时器与连接表
+    try {
+        timer_ = CreateTimerQueue(timer_type_);
+        users_ = std::make_unique<ConnectTable>(MAX_FD);
+    } catch (const std::exception& e) {
+        LOG_ERROR("Server: Failed to init timer: %s.", e.what());
         is_close_ = true;
-    } else {
-        LOG_INFO("Sever: Init SQL Connect Pool sucess.");
     }
 
-    // 初始化计时器小顶堆
+    // 初始化会话表，过期会话由事件循环的定时器周期清理，多Reactor模式下由0号从Reactor负责
     try {
-        timer_ = std::make_unique<TimerHeap>();
+        session_store_ = std::make_unique<SessionStore>();
+        HTTPConnect::session_store = session_store_.get();
+        if (reactor_nums <= 0 && timer_) {
+            session_timer_.id = -1;     // 不与连接的fd冲突
+            session_timer_.callback = std::bind(&WebServer::SweepSession, this);
+            timer_->AddTimer(&session_timer_, SessionStore::SWEEP_INTERVAL_MS);
+        }
     } catch (const std::exception& e) {
-        LOG_ERROR("Server: Failed to init timer heap: %s.", e.what());
+        LOG_ERROR("Server: Failed to init session store: %s.", e.what());
         is_close_ = true;
     }
 
-    // 初始化Epoll
+    // 初始化事件后端
     try {
-        epolls_ = std::make_unique<Epoll>();
+        epolls_ = CreateEventBackend(backend_type_);
     } catch (const std::exception& e) {
-        LOG_ERROR("Server: Failed to init epolls: %s.", e.what());
+        LOG_ERROR("Server: Failed to init event backend: %s.", e.what());
         is_close_ = true;
     }
     
@@ -68,13 +131,24 @@ WebServer::WebServer(
         is_close_ = true;
     } else {
         LOG_INFO("Server: current work directory: %s.", src_dir_.string().c_str());
+        // 静态资源缓存，初始化失败时退化为每次请求直接访问文件系统
+        if (!FileCache::GetFileCacheInstance().Init(src_dir_.string())) {
+            LOG_WARN("Server: Init file cache failed, serve files without cache.");
+        }
+        if (is_precompress) {
+            precompressor_.Start(src_dir_.string());
+        }
     }
 
     HTTPConnect::user_cnt = 0;
     HTTPConnect::src_dir = src_dir_;
     is_linger_ = is_linger;
 
-    if (!InitSocket()) {
+    if (reactor_nums > 0) {
+        if (!InitSubReactors(reactor_nums)) {
+            is_close_ = true;
+        }
+    } else if (!InitSocket()) {
         is_close_ = true;
     }
     
@@ -86,53 +160,108 @@ WebServer::WebServer(
         LOG_INFO("Port:%d, Socket close linger: %s.", port_, is_linger ? "true":"false");
         LOG_INFO("Listen Mode: %s, Connect Mode: %s.", (listen_event_ & EPOLLET ? "ET": "LT"), (connect_event_ & EPOLLET ? "ET": "LT"));
         LOG_INFO("Source Directory: %s.", HTTPConnect::src_dir.c_str());
-        LOG_INFO("SQL Connect Pool nums: %d, ThreadPool nums: %d.", connect_pool_nums, thread_pool_nums);
+        if (is_async) {
+            LOG_INFO("Log mode: async, Queue size: %d, Queue full: %s.", block_queue_size,
+                     overflow == LOG_OVERFLOW::BLOCK ? "block" : "drop");
+        } else {
+            LOG_INFO("Log mode: sync.");
+        }
+        LOG_INFO("SQL Connect Pool nums: %d, ThreadPool nums: %d, DB threads: %d, DB mode: %s, User store: %s.",
+                 connect_pool_nums, thread_pool_nums, db_thread_nums,
+                 async_sql_ ? "nonblocking" : (db_pool_ ? "executor" : "inline"),
+                 async_sql_ ? "mysql" : user_store_->GetName());
+        LOG_INFO("Reactor Mode: %s, SubReactor nums: %zu.", sub_reactors_.empty() ? "single" : "multi", sub_reactors_.size());
+        LOG_INFO("Event Backend: %s, Timer: %s, Timeout: %d ms.", epolls_->GetName(), timer_->GetName(), timeoutMS_);
     }
 }
 
 WebServer::~WebServer() {
-    close(listen_fd_);
+    bool is_sql_pool = (db_pool_ != nullptr);
+    // 先停止合并器与异步查询池(未完成的请求以失败回调，仍会交给I/O线程池)，再停止I/O线程池与数据库执行器，
+    // 其任务完成后仍会通知从Reactor
+    if (user_batcher_) {
+        user_batcher_->Stop();
+        LOG_INFO("Server: User batches: %llu, batched requests: %llu.",
+                 static_cast<unsigned long long>(user_batcher_->GetBatchNums()),
+                 static_cast<unsigned long long>(user_batcher_->GetRequestNums()));
+    }
+    async_sql_.reset();
+    user_batcher_.reset();
+    thread_pool_.reset();
+    db_pool_.reset();
+    sub_reactors_.clear();
+    HTTPConnect::user_store = nullptr;
+    user_store_.reset();
+    HTTPConnect::session_store = nullptr;
+    session_store_.reset();
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (wakeup_fd_ >= 0) close(wakeup_fd_);
     is_close_ = true;
+    if (is_sql_pool) {
+        SQLConnectPool::CheckoutStats stats = SQLConnectPool::GetSQLConnectPoolInstance()->GetCheckoutStats();
+        LOG_INFO("Server: SQL checkouts: %llu, waits: %llu, timeouts: %llu, avg wait: %llu us, max wait: %llu us.",
+                 static_cast<unsigned long long>(stats.checkouts), static_cast<unsigned long long>(stats.waits),
+                 static_cast<unsigned long long>(stats.timeouts),
+                 static_cast<unsigned long long>(stats.waits > 0 ? stats.total_wait_us / stats.waits : 0),
+                 static_cast<unsigned long long>(stats.max_wait_us));
+    }
     SQLConnectPool::GetSQLConnectPoolInstance()->CloseConnectPool();
+    precompressor_.Stop();
+    if (admission_) {
+        LOG_INFO("Server: Shed connects: %llu, shed requests: %llu.",
+                 static_cast<unsigned long long>(admission_->GetShedConnects()),
+                 static_cast<unsigned long long>(admission_->GetShedRequests()));
+    }
+    FileCache::GetFileCacheInstance().Close();
 }
 
 void WebServer::Start() {
+    if (!sub_reactors_.empty()) {
+        // 多Reactor模式：每个从Reactor在独立线程中运行事件循环，主线程等待其退出
+        if (is_close_) return;
+        LOG_INFO("========== Server start ==========");
+        for (auto& reactor : sub_reactors_) reactor->Start();
+        for (auto& reactor : sub_reactors_) reactor->Join();
+        return;
+    }
+
     int timeMS = -1;
 
     LOG_INFO("========== Server start =========="); 
     while (!is_close_) {
-        if (timeoutMS_ > 0) {
-            timeMS = timer_->GetNextExpireTime();
-        }
+        // 连接超时与会话清理共用定时器
+        timeMS = timer_->GetNextExpireTime();
         // 处理事件
         // 若 timeMS == -1, 则表示阻塞IO
         // 若 timeMS >= 0 则表示阻塞一定时间(为0表示非阻塞)
         int event_cnt = epolls_->EpollWait(timeMS);
         for (int i = 0; i < event_cnt; i++) {
-            int fd = epolls_->GetEventFd(i);
+            uint64_t data = epolls_->GetEventData(i);
             uint32_t events = epolls_->GetEvents(i);
-            if (fd == listen_fd_) {
+            if (data == static_cast<uint64_t>(listen_fd_)) {
                 // 处理新连接
                 DealListen();
-            } else if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                continue;
+            } else if (data == static_cast<uint64_t>(wakeup_fd_)) {
+                // 处理工作线程交回的连接
+                uint64_t cnt = 0;
+                while (read(wakeup_fd_, &cnt, sizeof(cnt)) > 0) {}
+                DealLoopTask();
+                continue;
+            }
+            // 事件数据直接指向连接槽位，代数不一致说明连接已关闭或fd已被复用
+            HTTPConnect* client = users_->Resolve(data);
+            if (client == nullptr) {
+                LOG_WARN("Server: Drop stale event for closed connection.");
+                continue;
+            }
+            if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
                 // 是否出现半关闭、挂起、错误
-                if (!users_.count(fd)) {
-                    LOG_ERROR("Server: No corresponding user found for fd: %d during disconnection or error event.", fd);
-                    continue;
-                }
-                CloseConnect(&users_[fd]);
+                CloseConnect(client);
             } else if (events & EPOLLIN) {
-                if (!users_.count(fd)) {
-                    LOG_ERROR("Server: No corresponding user found for fd: %d during read event.", fd);
-                    continue;
-                }
-                DealRead(&users_[fd]);
+                DealRead(client);
             } else if (events & EPOLLOUT) {
-                if (!users_.count(fd)) {
-                    LOG_ERROR("Server: No corresponding user found for fd: %d during write event.", fd);
-                    continue;
-                }
-                DealWrite(&users_[fd]);
+                DealWrite(client);
             } else {
                 LOG_ERROR("Server: Unexpected event.");
             }
@@ -141,11 +270,69 @@ void WebServer::Start() {
 }
 
 bool WebServer::InitSocket() {
+    if ((listen_fd_ = CreateListenFd(false)) < 0) {
+        return false;
+    }
+
+    if (epolls_->AddFd(listen_fd_, listen_event_ | EPOLLIN) == 0) {
+        LOG_ERROR("Add listen fd error!");
+        close(listen_fd_);
+        return false;
+    }
+
+    // 工作线程不直接关闭连接，由eventfd唤醒事件循环关闭，定时器只在事件循环线程中修改
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0 || epolls_->AddFd(wakeup_fd_, EPOLLIN) == 0) {
+        LOG_ERROR("Server: Failed to init wakeup eventfd, Error: %d.", errno);
+        close(listen_fd_);
+        return false;
+    }
+
+    SetFdNonblock(listen_fd_);
+    LOG_INFO("Server: Server port:%d init socket success.", port_);
+    return true;
+}
+
+/**
+ * @brief 
+ * 初始化多Reactor模式
+ * 每个从Reactor持有一个开启SO_REUSEPORT的监听套接字，由内核在各套接字间分发新连接，避免accept争用。
+ * @param reactor_nums 从Reactor数量
+ */
+bool WebServer::InitSubReactors(int reactor_nums) {
+    // 没有线程池，准入控制只用于拒绝数据库请求，由各从Reactor共享
+    admission_ = std::make_unique<AdmissionController>(nullptr);
+    for (int i = 0; i < reactor_nums; ++i) {
+        int listen_fd = CreateListenFd(true);
+        if (listen_fd < 0) {
+            return false;
+        }
+        SetFdNonblock(listen_fd);
+        try {
+            sub_reactors_.emplace_back(std::make_unique<SubReactor>(i, listen_fd, listen_event_, connect_event_, timeoutMS_, backend_type_, timer_type_, db_pool_.get(), user_batcher_.get(),
+                                                                         i == 0 ? session_store_.get() : nullptr, admission_.get()));
+        } catch (const std::exception& e) {
+            LOG_ERROR("Server: Failed to init sub reactor %d: %s.", i, e.what());
+            close(listen_fd);
+            return false;
+        }
+    }
+    LOG_INFO("Server: Server port:%d init %d sub reactors success.", port_, reactor_nums);
+    return true;
+}
+
+/**
+ * @brief 
+ * 创建并监听服务器套接字
+ * @param is_reuse_port 是否开启SO_REUSEPORT, 多Reactor模式下多个套接字绑定同一端口
+ * @return 监听套接字文件描述符，失败返回-1
+ */
+int WebServer::CreateListenFd(bool is_reuse_port) {
     struct sockaddr_in server_addr;
     if (port_ > 65535 || port_ < 1024) {
         LOG_ERROR("Server: invalid server port:%d.", port_);
         is_close_ = true;
-        return false;
+        return -1;
     }
 
     server_addr.sin_family = AF_INET;
@@ -159,46 +346,45 @@ bool WebServer::InitSocket() {
         optlinger.l_linger = 1;
     }
 
-    if ((listen_fd_ = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) {
         LOG_ERROR("Server: Create socket error, port: %d.", port_);
-        return false;
+        return -1;
     }
 
-    if (setsockopt(listen_fd_, SOL_SOCKET, SO_LINGER, &optlinger, sizeof(optlinger)) < 0) {
-        close(listen_fd_);
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_LINGER, &optlinger, sizeof(optlinger)) < 0) {
+        close(listen_fd);
         LOG_ERROR("Server: Init linger error, port: %d.", port_);
-        return false;
+        return -1;
     }
 
     int optval = 1;
 
-    if (setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, (const void*) &optval, sizeof(int)) == -1) {
+    if (setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, (const void*) &optval, sizeof(int)) == -1) {
         LOG_ERROR("Server: set socket error.");
-        close(listen_fd_);
-        return false;
+        close(listen_fd);
+        return -1;
     }
 
-    if (bind(listen_fd_, (struct sockaddr*) &server_addr, sizeof(server_addr)) < 0) {
-        LOG_ERROR("Server: Listen socket bind port: %d error.", port_);
-        close(listen_fd_);
-        return false;
+    if (is_reuse_port && setsockopt(listen_fd, SOL_SOCKET, SO_REUSEPORT, (const void*) &optval, sizeof(int)) == -1) {
+        LOG_ERROR("Server: set socket reuse port error.");
+        close(listen_fd);
+        return -1;
     }
 
-    if (listen(listen_fd_, 6) < 0) {
-        LOG_ERROR("Server: Listen port:%d error.", port_);
-        close(listen_fd_);
-        return false;
+    if (bind(listen_fd, (struct sockaddr*) &server_addr, sizeof(server_addr)) < 0) {
+        LOG_ERROR("Server: Listen socket bind port: %d error.", port_);
+        close(listen_fd);
+        return -1;
     }
 
-    if (epolls_->AddFd(listen_fd_, listen_event_ | EPOLLIN) == 0) {
-        LOG_ERROR("Add listen fd error!");
-        close(listen_fd_);
-        return false;
+    if (listen(listen_fd, 6) < 0) {
+        LOG_ERROR("Server: Listen port:%d error.", port_);
+        close(listen_fd);
+        return -1;
     }
 
-    SetFdNonblock(listen_fd_);
-    LOG_INFO("Server: Server port:%d init socket success.", port_);
-    return true;
+    return listen_fd;
 }
 
 /**
@@ -243,15 +429,23 @@ void WebServer::AddClient(int fd, sockaddr_in& addr) {
         LOG_ERROR("Server: Invalid client fd: %d.", fd);
         return;
     }
+    HTTPConnect* client = users_->Acquire(fd);
+    if (client == nullptr) {
+        SendError(fd, SERVICE_UNAVAILABLE.data());
+        return;
+    }
     // 保存客户端连接套接字的文件描述符以及客户端地址结构体
-    users_[fd].Init(fd, addr);
+    client->Init(fd, addr);
     if (timeoutMS_ > 0) {
-        // 绑定关闭套接字连接的函数作为回调函数
-        timer_->AddTimer(fd, timeoutMS_, std::bind(&WebServer::CloseConnect, this, &users_[fd]));
+        // 绑定关闭套接字连接的函数作为回调函数，定时器节点由连接持有
+        TimerNode* node = client->GetTimerNode();
+        node->id = fd;
+        node->callback = std::bind(&WebServer::CloseConnect, this, client);
+        timer_->AddTimer(node, timeoutMS_);
     }
-    epolls_->AddFd(fd, EPOLLIN | connect_event_);
+    epolls_->AddFd(fd, EPOLLIN | connect_event_, users_->GetTag(client));
     SetFdNonblock(fd);
-    LOG_INFO("Server: Client[%d] connect.", users_[fd].GetFd());
+    LOG_INFO("Server: Client[%d] connect.", client->GetFd());
 }
 
 void WebServer::DealListen() {
@@ -263,9 +457,14 @@ void WebServer::DealListen() {
             LOG_ERROR("Server: Failed to accept new client connection.");
             return;
         } else if (HTTPConnect::user_cnt >= MAX_FD) {
-            SendError(fd, "Server is busy.");
+            SendError(fd, SERVICE_UNAVAILABLE.data());
             LOG_WARN("Server: Server connect is full.");
             return;
+        } else if (!admission_->AdmitConnect()) {
+            // 线程池排队时延持续超标，拒绝新连接，不再接收其请求
+            admission_->Reject(fd, true);
+            close(fd);
+            continue;
         }
         AddClient(fd, addr);
     } while (listen_event_ & EPOLLET);
@@ -277,7 +476,11 @@ void WebServer::DealRead(HTTPConnect* client) {
         return;
     }
     ExtentTime(client);
-    thread_pool_->AddTask(std::bind(&WebServer::OnRead, this, client));
+    // 不阻塞Reactor：队列已满时直接拒绝该请求，避免连接在EPOLLONESHOT下无人处理
+    if (!thread_pool_->AddTask<&WebServer::OnRead>(this, client, MS(0))) {
+        admission_->Reject(client->GetFd(), false);
+        CloseConnect(client);
+    }
 }
 
 void WebServer::DealWrite(HTTPConnect* client) {
@@ -286,7 +489,11 @@ void WebServer::DealWrite(HTTPConnect* client) {
         return;
     }
     ExtentTime(client);
-    thread_pool_->AddTask(std::bind(&WebServer::OnWrite, this, client));
+    // 响应已部分写出，无法再回复503，只能关闭连接
+    if (!thread_pool_->AddTask<&WebServer::OnWrite>(this, client, MS(0))) {
+        LOG_WARN("Server: Task queue is full, close client [%d] while writing.", client->GetFd());
+        CloseConnect(client);
+    }
 }
 
 void WebServer::SendError(int fd, const char* info) {
@@ -309,22 +516,60 @@ void WebServer::ExtentTime(HTTPConnect* client) {
         return;
     }
     if (timeoutMS_ > 0) {
-        timer_->UpdateTimer(client->GetFd(), timeoutMS_);
+        timer_->UpdateTimer(client->GetTimerNode(), timeoutMS_);
         LOG_INFO("Server: Updated timer for client [%d] with timeout [%d] ms", client->GetFd(), timeoutMS_);
     }
 }
 
+// 只在事件循环线程中调用，工作线程经QueueLoopTask交回
 void WebServer::CloseConnect(HTTPConnect* client) {
     if (client == nullptr) {
         LOG_ERROR("Server: Client is null in Close Connect.");
         return;
     }
-    LOG_INFO("Client[%d] quit.", client->GetFd());
-    if (!epolls_->DeleteFd(client->GetFd())) {
-        LOG_WARN("Server: Failed to delete client fd[%d] from epoll.", client->GetFd());
+    int fd = client->GetFd();
+    if (fd < 0) return;
+    LOG_INFO("Client[%d] quit.", fd);
+    if (timeoutMS_ > 0) {
+        timer_->DeleteTimer(client->GetTimerNode());
+    }
+    if (!epolls_->DeleteFd(fd)) {
+        LOG_WARN("Server: Failed to delete client fd[%d] from epoll.", fd);
     }
+    users_->Release(client);
     client->Close();
-    LOG_INFO("Server: Client[%d] connection closed successfully.", client->GetFd());
+    LOG_INFO("Server: Client[%d] connection closed successfully.", fd);
+}
+
+// 连接在EPOLLONESHOT下不会被再次派发，槽位保留到事件循环处理为止；以事件数据入队，定时器先行关闭时代数不一致
+void WebServer::QueueLoopTask(HTTPConnect* client, LOOP_TASK task) {
+    {
+        std::lock_guard<std::mutex> locker(loop_mtx_);
+        loop_tasks_.emplace_back(users_->GetTag(client), task);
+    }
+    uint64_t one = 1;
+    if (write(wakeup_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_WARN("Server: Failed to wake up event loop, Error: %d.", errno);
+    }
+}
+
+void WebServer::DealLoopTask() {
+    std::vector<std::pair<uint64_t, LOOP_TASK>> tasks;
+    {
+        std::lock_guard<std::mutex> locker(loop_mtx_);
+        tasks.swap(loop_tasks_);
+    }
+    for (auto& [tag, task] : tasks) {
+        HTTPConnect* client = users_->Resolve(tag);
+        if (client == nullptr) continue;
+        if (task == LOOP_TASK::CLOSE) {
+            CloseConnect(client);
+        } else if (task == LOOP_TASK::DB_SUBMIT) {
+            DealDB(client);
+        } else {
+            DealDBDone(client);
+        }
+    }
 }
 
 void WebServer::OnRead(HTTPConnect* client) {
@@ -337,7 +582,7 @@ void WebServer::OnRead(HTTPConnect* client) {
     val = client->Read(&readErrno);
     if (val <= 0 && readErrno != EAGAIN) {
         LOG_WARN("Server: Read from client [%d] failed with errno: %d", client->GetFd(), readErrno);
-        CloseConnect(client);
+        QueueLoopTask(client, LOOP_TASK::CLOSE);
         return;
     }
     OnProcess(client);
@@ -359,21 +604,107 @@ void WebServer::OnWrite(HTTPConnect* client) {
     } else if (val < 0) {
         if (writeErrno == EAGAIN) {
             LOG_INFO("Server: Write buffer full for client [%d], retrying later", client->GetFd());
-            epolls_->ModifyFd(client->GetFd(), connect_event_ | EPOLLOUT);
+            epolls_->ModifyFd(client->GetFd(), connect_event_ | EPOLLOUT, users_->GetTag(client));
             return;
         }
         LOG_WARN("Server: Write to client [%d] failed with errno: %d", client->GetFd(), writeErrno);
     } else {
         LOG_INFO("Server: Wrote %d bytes to client [%d]", val, client->GetFd());
     }
+    QueueLoopTask(client, LOOP_TASK::CLOSE);
+}
+
+/**
+ * @brief
+ * 在事件循环线程中将数据库请求交给批量合并器或数据库执行器，与SubReactor::DealDB一致：
+ * 提交前移出定时器，等待期间连接不会被超时关闭；完成通知同样在事件循环线程中处理，移出操作一定先于重新添加。
+ * 队列已满时拒绝该请求；已有响应排队时无法插入503，直接关闭连接
+ */
+void WebServer::DealDB(HTTPConnect* client) {
+    if (timeoutMS_ > 0) {
+        timer_->DeleteTimer(client->GetTimerNode());
+    }
+    if (SubmitDB(client)) return;
+    LOG_WARN("Server: Database queue is full, reject client [%d].", client->GetFd());
+    if (client->ToWriteBytes() == 0) {
+        admission_->Reject(client->GetFd(), false);
+    }
+    CloseConnect(client);
+}
+
+// 参数非法的请求不需要访问数据库，同样经事件循环返回
+bool WebServer::SubmitDB(HTTPConnect* client) {
+    if (!user_batcher_) {
+        return db_pool_->AddTask<&WebServer::OnDBProcess>(this, client, MS(0));
+    }
+    std::string name, hashed_pwd;
+    bool is_login = false;
+    if (!client->GetDBUser(&name, &hashed_pwd, &is_login)) {
+        client->SetDBResult(false);
+        OnDBDone(client);
+        return true;
+    }
+    // 回调在数据库事件循环中执行，只记录结果
+    auto callback = [this, client](bool is_verified) {
+        client->SetDBResult(is_verified);
+        OnDBDone(client);
+    };
+    return is_login ? user_batcher_->Login(std::move(name), std::move(hashed_pwd), callback)
+                    : user_batcher_->Register(std::move(name), std::move(hashed_pwd), callback);
+}
+
+void WebServer::OnDBProcess(HTTPConnect* client) {
+    client->VerifyDB();
+    OnDBDone(client);
+}
+
+// 在数据库执行器或数据库事件循环中执行，交回事件循环重新添加定时器
+void WebServer::OnDBDone(HTTPConnect* client) {
+    QueueLoopTask(client, LOOP_TASK::DB_DONE);
+}
+
+// 响应与后续请求交回I/O线程池处理；线程池已满时响应尚未生成，拒绝该请求
+void WebServer::DealDBDone(HTTPConnect* client) {
+    if (timeoutMS_ > 0) {
+        timer_->AddTimer(client->GetTimerNode(), timeoutMS_);
+    }
+    if (thread_pool_->AddTask<&WebServer::OnDBFinish>(this, client, MS(0))) {
+        return;
+    }
+    LOG_WARN("Server: Task queue is full, reject client [%d] after database request.", client->GetFd());
+    if (client->ToWriteBytes() == 0) {
+        admission_->Reject(client->GetFd(), false);
+    }
     CloseConnect(client);
 }
 
+void WebServer::OnDBFinish(HTTPConnect* client) {
+    client->FinishDB();
+    OnProcess(client);
+}
+
+// 在事件循环线程中执行，清理后重新添加定时器
+void WebServer::SweepSession() {
+    size_t cnt = session_store_->Expire();
+    if (cnt > 0) {
+        LOG_DEBUG("Server: Expire %zu sessions, %zu remain.", cnt, session_store_->Size());
+    }
+    timer_->AddTimer(&session_timer_, SessionStore::SWEEP_INTERVAL_MS);
+}
+
 void WebServer::OnProcess(HTTPConnect* client) {
-    if (client->Process()) {
-        epolls_->ModifyFd(client->GetFd(), connect_event_ | EPOLLOUT);
+    bool has_response = client->Process();
+    if (client->IsDBPending() && !db_pool_ && !user_batcher_) {
+        // 本地用户存储，直接在当前线程执行
+        client->ProcessDB();
+        OnProcess(client);
+    } else if (client->IsDBPending()) {
+        // 定时器只在事件循环线程中修改，由事件循环提交
+        QueueLoopTask(client, LOOP_TASK::DB_SUBMIT);
+    } else if (has_response) {
+        epolls_->ModifyFd(client->GetFd(), connect_event_ | EPOLLOUT, users_->GetTag(client));
     } else {
-        epolls_->ModifyFd(client->GetFd(), connect_event_ | EPOLLIN);
+        epolls_->ModifyFd(client->GetFd(), connect_event_ | EPOLLIN, users_->GetTag(client));
     }
 }
 
@@ -9,12 +9,29 @@
 #define SERVER_H
 
 #include "../log/log.h"
-#include "../timer/timer.h"
+#include "../timer/timer_queue.h"
 #include "../epoll/epoll.h"
+#include "../epoll/event_backend.h"
 #include "../pool/thread_pool.h"
 #include "../http/http_connect.h"
+#include "../http/file_cache.h"
+#include "../http/precompress.h"
+#include "sub_reactor.h"
+#include "admission.h"
+#include "connect_table.h"
 #include "../pool/db_connect_pool.h"
 #include "../pool/db_connect_pool_RAII.h"
+#include "../pool/async_sql_pool.h"
+#include "../pool/user_batcher.h"
+#include "../store/user_store.h"
+#include "../store/session_store.h"
+
+// 工作线程交回事件循环线程执行的操作
+enum class LOOP_TASK {
+    CLOSE = 0,          // 关闭连接
+    DB_SUBMIT = 1,      // 提交数据库请求
+    DB_DONE = 2         // 数据库请求已完成
+};
 
 class WebServer {
 public:
@@ -22,7 +39,9 @@ public:
         int port, int trigger_mode, bool is_linger,
         int sql_port, const char* sql_user, const char* sql_pwd, const char* db_name,
         int connect_pool_nums, int thread_pool_nums,
-        bool is_async, int block_queue_size, int timesout
+        bool is_async, int block_queue_size, int timesout,
+        int reactor_nums = 0, int event_backend = 0, bool is_precompress = true, int timer_type = 1,
+        int db_thread_nums = 4, bool is_db_async = true, int user_store = 0, int log_overflow = 0, int log_level = 0
     );
               
     ~WebServer();
@@ -30,37 +49,64 @@ public:
 
 private:
     bool InitSocket(); 
+    bool InitSubReactors(int reactor_nums);
+    int CreateListenFd(bool is_reuse_port);
     void InitEventMode(int trigger_mode);
     void AddClient(int fd, struct sockaddr_in& addr);
   
     void DealListen();
     void DealWrite(HTTPConnect* client);
     void DealRead(HTTPConnect* client);
+    void DealDB(HTTPConnect* client);
+    void DealDBDone(HTTPConnect* client);
+    bool SubmitDB(HTTPConnect* client);
 
     void SendError(int fd, const char* info);
     void ExtentTime(HTTPConnect* client);
     void CloseConnect(HTTPConnect* client);
+    void QueueLoopTask(HTTPConnect* client, LOOP_TASK task);
+    void DealLoopTask();
 
     void OnRead(HTTPConnect* client);
     void OnWrite(HTTPConnect* client);
     void OnProcess(HTTPConnect* client);
+    void OnDBProcess(HTTPConnect* client);
+    void OnDBDone(HTTPConnect* client);
+    void OnDBFinish(HTTPConnect* client);
+    void SweepSession();
 
     static int SetFdNonblock(int fd);
     static const int MAX_FD = 65536;
+    static const int DB_QUEUE_SIZE = 64;           // 数据库执行器排队任务数
+    static const int ASYNC_QUEUE_SIZE = 1024;      // 异步查询池每个事件循环的排队查询数
     
     int port_;                                      // 服务器端口号                           
     int timeoutMS_;                                 // 连接超时时间                              
     int listen_fd_;                                 // 监听文件描述符
+    int wakeup_fd_;                                 // 单Reactor模式下唤醒事件循环的eventfd
     bool is_linger_;                                // 套接字优雅关闭标识符
     bool is_close_;                                 // 服务器关闭标志符
     uint32_t listen_event_;                         // 设置套接字监听事件类型
     uint32_t connect_event_;                        // 存储连接套接字发生的事件类型
     std::filesystem::path src_dir_;                 // 资源目录
    
-    std::unique_ptr<TimerHeap> timer_;              // 小顶堆计时器
+    TIMER_TYPE timer_type_;                         // 定时器类型
+    std::unique_ptr<TimerQueue> timer_;             // 连接超时定时器(小顶堆或时间轮)
     std::unique_ptr<ThreadPool> thread_pool_;       // 线程池
-    std::unique_ptr<Epoll> epolls_;                 // epoll实例
-    std::unordered_map<int, HTTPConnect> users_;    // 用户连接管理
+    std::unique_ptr<AdmissionController> admission_; // 准入控制，多Reactor模式下只用于拒绝数据库请求
+    std::unique_ptr<ThreadPool> db_pool_;           // 数据库执行器，登录、注册请求与静态资源请求隔离
+    std::unique_ptr<AsyncSQLPool> async_sql_;       // 非阻塞数据库访问，为空时使用数据库执行器
+    std::unique_ptr<UserBatcher> user_batcher_;     // 合并登录、注册请求，建立在async_sql_之上
+    std::unique_ptr<UserStore> user_store_;         // 同步执行登录、注册的用户存储(数据库执行器或本地存储)
+    std::unique_ptr<SessionStore> session_store_;   // 登录会话表，由定时器周期清理过期会话
+    TimerNode session_timer_;                       // 单Reactor模式下清理过期会话的定时器
+    std::mutex loop_mtx_;                           // 事件循环任务队列互斥锁
+    std::vector<std::pair<uint64_t, LOOP_TASK>> loop_tasks_; // 工作线程交回事件循环的连接(事件数据)与操作
+    EVENT_BACKEND backend_type_;                    // 事件后端类型
+    std::unique_ptr<EventBackend> epolls_;          // 事件后端实例(epoll或io_uring)
+    std::unique_ptr<ConnectTable> users_;           // 以fd为下标的用户连接表
+    Precompressor precompressor_;                   // 静态资源后台预压缩
+    std::vector<std::unique_ptr<SubReactor>> sub_reactors_; // 多Reactor模式下的从Reactor, 为空时使用单Reactor+线程池模式
 };
 
 #endif
@@ -0,0 +1,308 @@
+/**
+ * @file sub_reactor.cpp
+ * @author chenyinjie
+ * @date 2024-10-20
+ * @copyright Apache 2.0
+ */
+
+#include "sub_reactor.h"
+
+SubReactor::SubReactor(int id, int listen_fd, uint32_t listen_event, uint32_t connect_event, int timeout_ms,
+                       EVENT_BACKEND backend_type, TIMER_TYPE timer_type, ThreadPool* db_pool,
+                       UserBatcher* user_batcher, SessionStore* session_store, AdmissionController* admission)
+    : id_(id),
+      listen_fd_(listen_fd),
+      wakeup_fd_(-1),
+      timeoutMS_(timeout_ms),
+      listen_event_(listen_event),
+      connect_event_(connect_event & ~EPOLLONESHOT),
+      is_close_(false),
+      users_(MAX_FD),
+      db_pool_(db_pool),
+      user_batcher_(user_batcher),
+      session_store_(session_store),
+      admission_(admission) {
+    timer_ = CreateTimerQueue(timer_type);
+    if (session_store_ != nullptr) {
+        session_timer_.id = -1;     // 不与连接的fd冲突
+        session_timer_.callback = std::bind(&SubReactor::SweepSession, this);
+        timer_->AddTimer(&session_timer_, SessionStore::SWEEP_INTERVAL_MS);
+    }
+    epoll_ = CreateEventBackend(backend_type);
+
+    wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeup_fd_ < 0) {
+        LOG_ERROR("SubReactor[%d]: Failed to create wakeup eventfd, Error: %d.", id_, errno);
+        throw std::runtime_error("SubReactor: Failed to create wakeup eventfd.");
+    }
+    if (!epoll_->AddFd(wakeup_fd_, EPOLLIN) || !epoll_->AddFd(listen_fd_, listen_event_ | EPOLLIN)) {
+        close(wakeup_fd_);
+        throw std::runtime_error("SubReactor: Failed to register fds to epoll.");
+    }
+    LOG_INFO("SubReactor[%d]: init with listen fd: %d.", id_, listen_fd_);
+}
+
+SubReactor::~SubReactor() {
+    Stop();
+    Join();
+    if (wakeup_fd_ >= 0) close(wakeup_fd_);
+    if (listen_fd_ >= 0) close(listen_fd_);
+}
+
+void SubReactor::Start() {
+    loop_thread_ = std::thread(&SubReactor::Loop, this);
+}
+
+void SubReactor::Stop() {
+    is_close_ = true;
+    uint64_t one = 1;
+    if (wakeup_fd_ >= 0 && write(wakeup_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_WARN("SubReactor[%d]: Failed to wake up event loop, Error: %d.", id_, errno);
+    }
+}
+
+void SubReactor::Join() {
+    if (loop_thread_.joinable()) loop_thread_.join();
+}
+
+void SubReactor::Loop() {
+    int timeMS = -1;
+    LOG_INFO("SubReactor[%d]: event loop start.", id_);
+    while (!is_close_) {
+        timeMS = timer_->GetNextExpireTime();
+        int event_cnt = epoll_->EpollWait(timeMS);
+        for (int i = 0; i < event_cnt; i++) {
+            uint64_t data = epoll_->GetEventData(i);
+            uint32_t events = epoll_->GetEvents(i);
+            if (data == static_cast<uint64_t>(listen_fd_)) {
+                DealListen();
+                continue;
+            } else if (data == static_cast<uint64_t>(wakeup_fd_)) {
+                uint64_t cnt = 0;
+                while (read(wakeup_fd_, &cnt, sizeof(cnt)) > 0) {}
+                DealDBDone();
+                continue;
+            }
+            HTTPConnect* client = users_.Resolve(data);
+            if (client == nullptr) {
+                LOG_WARN("SubReactor[%d]: Drop stale event for closed connection.", id_);
+                continue;
+            }
+            if (events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                CloseConnect(client);
+            } else if (events & EPOLLIN) {
+                DealRead(client);
+            } else if (events & EPOLLOUT) {
+                DealWrite(client);
+            } else {
+                LOG_ERROR("SubReactor[%d]: Unexpected event.", id_);
+            }
+        }
+    }
+    LOG_INFO("SubReactor[%d]: event loop quit.", id_);
+}
+
+void SubReactor::DealListen() {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    do {
+        // 非阻塞标志直接在accept4中设置，省去一次fcntl调用
+        int fd = accept4(listen_fd_, (struct sockaddr*) &addr, &len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd <= 0) {
+            if (errno != EAGAIN) {
+                LOG_ERROR("SubReactor[%d]: Failed to accept new client connection.", id_);
+            }
+            return;
+        } else if (HTTPConnect::user_cnt >= MAX_FD) {
+            SendError(fd, SERVICE_UNAVAILABLE.data());
+            LOG_WARN("SubReactor[%d]: Server connect is full.", id_);
+            return;
+        }
+        AddClient(fd, addr);
+    } while (listen_event_ & EPOLLET);
+}
+
+void SubReactor::AddClient(int fd, struct sockaddr_in& addr) {
+    HTTPConnect* client = users_.Acquire(fd);
+    if (client == nullptr) {
+        SendError(fd, SERVICE_UNAVAILABLE.data());
+        return;
+    }
+    client->Init(fd, addr);
+    if (timeoutMS_ > 0) {
+        TimerNode* node = client->GetTimerNode();
+        node->id = fd;
+        node->callback = [this, client]() { CloseConnect(client); };
+        timer_->AddTimer(node, timeoutMS_);
+    }
+    epoll_->AddFd(fd, EPOLLIN | connect_event_, users_.GetTag(client));
+    LOG_INFO("SubReactor[%d]: Client[%d] connect.", id_, fd);
+}
+
+void SubReactor::DealRead(HTTPConnect* client) {
+    ExtentTime(client);
+    int read_errno = 0;
+    ssize_t len = client->Read(&read_errno);
+    if (len <= 0 && read_errno != EAGAIN) {
+        LOG_WARN("SubReactor[%d]: Read from client [%d] failed with errno: %d", id_, client->GetFd(), read_errno);
+        CloseConnect(client);
+        return;
+    }
+    OnProcess(client);
+}
+
+void SubReactor::DealWrite(HTTPConnect* client) {
+    ExtentTime(client);
+    OnWrite(client, true);
+}
+
+void SubReactor::OnProcess(HTTPConnect* client) {
+    // 连接只在本线程处理，生成响应后立即尝试写回，省去一次epoll_ctl与epoll_wait往返
+    bool has_response = client->Process();
+    if (client->IsDBPending()) {
+        DealDB(client);
+    } else if (has_response) {
+        OnWrite(client, false);
+    }
+}
+
+/**
+ * @brief
+ * 提交成功后将连接移出epoll与定时器，等待期间不会被读写或超时关闭；
+ * 完成通知只在本线程的下一轮事件循环中处理，移出操作一定先于重新注册。
+ */
+void SubReactor::DealDB(HTTPConnect* client) {
+    if (db_pool_ == nullptr && user_batcher_ == nullptr) {
+        client->ProcessDB();
+        OnProcess(client);
+        return;
+    }
+    if (!SubmitDB(client)) {
+        LOG_WARN("SubReactor[%d]: Database queue is full, reject client [%d].", id_, client->GetFd());
+        if (client->ToWriteBytes() == 0 && admission_ != nullptr) {
+            admission_->Reject(client->GetFd(), false);
+        }
+        CloseConnect(client);
+        return;
+    }
+    if (timeoutMS_ > 0) {
+        timer_->DeleteTimer(client->GetTimerNode());
+    }
+    epoll_->DeleteFd(client->GetFd());
+}
+
+// 参数非法的请求不需要访问数据库，同样经完成队列返回，保证移出操作先于重新注册
+bool SubReactor::SubmitDB(HTTPConnect* client) {
+    if (user_batcher_ == nullptr) {
+        return db_pool_->AddTask<&SubReactor::OnDBProcess>(this, client, MS(0));
+    }
+    std::string name, hashed_pwd;
+    bool is_login = false;
+    if (!client->GetDBUser(&name, &hashed_pwd, &is_login)) {
+        client->SetDBResult(false);
+        OnDBDone(client);
+        return true;
+    }
+    // 回调在数据库事件循环中执行，只记录结果，响应回到本线程生成
+    auto callback = [this, client](bool is_verified) {
+        client->SetDBResult(is_verified);
+        OnDBDone(client);
+    };
+    return is_login ? user_batcher_->Login(std::move(name), std::move(hashed_pwd), callback)
+                    : user_batcher_->Register(std::move(name), std::move(hashed_pwd), callback);
+}
+
+void SubReactor::OnDBProcess(HTTPConnect* client) {
+    client->VerifyDB();
+    OnDBDone(client);
+}
+
+void SubReactor::OnDBDone(HTTPConnect* client) {
+    {
+        std::lock_guard<std::mutex> locker(done_mtx_);
+        done_clients_.push_back(client);
+    }
+    uint64_t one = 1;
+    if (write(wakeup_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_WARN("SubReactor[%d]: Failed to wake up event loop, Error: %d.", id_, errno);
+    }
+}
+
+void SubReactor::DealDBDone() {
+    std::vector<HTTPConnect*> clients;
+    {
+        std::lock_guard<std::mutex> locker(done_mtx_);
+        clients.swap(done_clients_);
+    }
+    for (HTTPConnect* client : clients) {
+        if (timeoutMS_ > 0) {
+            timer_->AddTimer(client->GetTimerNode(), timeoutMS_);
+        }
+        epoll_->AddFd(client->GetFd(), EPOLLIN | connect_event_, users_.GetTag(client));
+        client->FinishDB();
+        OnProcess(client);
+    }
+}
+
+void SubReactor::SweepSession() {
+    size_t cnt = session_store_->Expire();
+    if (cnt > 0) {
+        LOG_DEBUG("SubReactor[%d]: Expire %zu sessions, %zu remain.", id_, cnt, session_store_->Size());
+    }
+    timer_->AddTimer(&session_timer_, SessionStore::SWEEP_INTERVAL_MS);
+}
+
+/**
+ * @brief
+ * 写回响应
+ * @param is_out_armed 当前连接是否注册了EPOLLOUT，写完后需要切换回EPOLLIN
+ */
+void SubReactor::OnWrite(HTTPConnect* client, bool is_out_armed) {
+    int write_errno = 0;
+    ssize_t len = client->Write(&write_errno);
+    if (client->ToWriteBytes() == 0) {
+        if (client->IsKeepAlive()) {
+            if (is_out_armed) {
+                epoll_->ModifyFd(client->GetFd(), connect_event_ | EPOLLIN, users_.GetTag(client));
+            }
+            OnProcess(client);
+            return;
+        }
+    } else if (len < 0) {
+        if (write_errno == EAGAIN) {
+            if (!is_out_armed) {
+                epoll_->ModifyFd(client->GetFd(), connect_event_ | EPOLLOUT, users_.GetTag(client));
+            }
+            return;
+        }
+        LOG_WARN("SubReactor[%d]: Write to client [%d] failed with errno: %d", id_, client->GetFd(), write_errno);
+    }
+    CloseConnect(client);
+}
+
+void SubReactor::ExtentTime(HTTPConnect* client) {
+    if (timeoutMS_ > 0) {
+        timer_->UpdateTimer(client->GetTimerNode(), timeoutMS_);
+    }
+}
+
+void SubReactor::CloseConnect(HTTPConnect* client) {
+    int fd = client->GetFd();
+    if (fd < 0) return;
+    LOG_INFO("SubReactor[%d]: Client[%d] quit.", id_, fd);
+    if (timeoutMS_ > 0) {
+        timer_->DeleteTimer(client->GetTimerNode());
+    }
+    if (!epoll_->DeleteFd(fd)) {
+        LOG_WARN("SubReactor[%d]: Failed to delete client fd[%d] from epoll.", id_, fd);
+    }
+    users_.Release(client);
+    client->Close();
+}
+
+void SubReactor::SendError(int fd, const char* info) {
+    if (send(fd, info, strlen(info), 0) == -1) {
+        LOG_WARN("SubReactor[%d]: Failed to send error message to client [%d]: %s.", id_, fd, strerror(errno));
+    }
+    close(fd);
+}
@@ -0,0 +1,92 @@
+/**
+ * @file sub_reactor.h
+ * @author chenyinjie
+ * @date 2024-10-20
+ * @copyright Apache 2.0
+ */
+
+#ifndef SUB_REACTOR_H
+#define SUB_REACTOR_H
+
+#include "../log/log.h"
+#include "../timer/timer_queue.h"
+#include "../epoll/event_backend.h"
+#include "../http/http_connect.h"
+#include "connect_table.h"
+#include "admission.h"
+#include "../pool/thread_pool.h"
+#include "../pool/user_batcher.h"
+
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief
+ * 多Reactor模式下的从Reactor
+ * 每个SubReactor在独立线程中运行事件循环，持有独立的Epoll实例、监听套接字(SO_REUSEPORT)、定时器与连接表。
+ * 连接的读写与报文处理均在所属线程内完成，连接不会跨线程迁移，因此无需EPOLLONESHOT与线程池。
+ * 登录、注册等数据库请求交给共享的批量合并器或数据库执行器：等待期间连接暂时移出epoll与定时器，
+ * 执行完成后经完成队列与eventfd交回本线程，重新注册后继续处理，数据库变慢时不阻塞事件循环。
+ */
+
+class SubReactor {
+public:
+    SubReactor(int id, int listen_fd, uint32_t listen_event, uint32_t connect_event, int timeout_ms,
+               EVENT_BACKEND backend_type = EVENT_BACKEND::EPOLL, TIMER_TYPE timer_type = TIMER_TYPE::WHEEL,
+               ThreadPool* db_pool = nullptr, UserBatcher* user_batcher = nullptr, SessionStore* session_store = nullptr,
+               AdmissionController* admission = nullptr);
+    ~SubReactor();
+
+    SubReactor(const SubReactor&) = delete;
+    SubReactor& operator=(const SubReactor&) = delete;
+
+    void Start();                                   // 启动事件循环线程
+    void Stop();                                    // 通知事件循环退出
+    void Join();                                    // 等待事件循环线程结束
+
+private:
+    void Loop();                                    // 事件循环
+    void DealListen();                              // 接收新连接
+    void AddClient(int fd, struct sockaddr_in& addr);
+    void DealRead(HTTPConnect* client);             // 处理读事件
+    void DealWrite(HTTPConnect* client);            // 处理写事件
+    void OnProcess(HTTPConnect* client);            // 解析请求并直接写回响应
+    void DealDB(HTTPConnect* client);               // 将数据库请求交给批量合并器或数据库执行器
+    bool SubmitDB(HTTPConnect* client);             // 提交数据库请求，队列已满时返回false
+    void OnDBProcess(HTTPConnect* client);          // 在数据库执行器中执行，完成后交回本线程
+    void OnDBDone(HTTPConnect* client);             // 数据库请求完成，加入完成队列并唤醒本线程
+    void DealDBDone();                              // 重新注册已完成数据库请求的连接并继续处理
+    void SweepSession();                            // 清理过期会话
+    void OnWrite(HTTPConnect* client, bool is_out_armed);
+    void ExtentTime(HTTPConnect* client);
+    void CloseConnect(HTTPConnect* client);
+    void SendError(int fd, const char* info);
+
+    static const int MAX_FD = 65536;
+
+    int id_;                                        // Reactor编号
+    int listen_fd_;                                 // 本Reactor独占的监听套接字
+    int wakeup_fd_;                                 // 用于唤醒事件循环的eventfd
+    int timeoutMS_;                                 // 连接超时时间
+    uint32_t listen_event_;                         // 监听套接字事件类型
+    uint32_t connect_event_;                        // 连接套接字事件类型
+    std::atomic<bool> is_close_;                    // 事件循环退出标志
+
+    std::unique_ptr<TimerQueue> timer_;             // 本线程的定时器
+    std::unique_ptr<EventBackend> epoll_;           // 本线程的事件后端实例
+    ConnectTable users_;                            // 本线程的连接表
+    ThreadPool* db_pool_;                           // 数据库执行器，两者都为空时在本线程内直接执行
+    UserBatcher* user_batcher_;                     // 批量合并器，非空时优先使用
+    SessionStore* session_store_;                   // 由本线程定时清理的会话表，为空时不负责清理
+    AdmissionController* admission_;                // 共享的准入控制，拒绝数据库请求时发送503并计数
+    TimerNode session_timer_;                       // 清理过期会话的定时器
+    std::mutex done_mtx_;                           // 完成队列互斥锁
+    std::vector<HTTPConnect*> done_clients_;        // 已完成数据库请求、等待交回本线程的连接
+    std::thread loop_thread_;                       // 事件循环线程
+};
+
+#endif
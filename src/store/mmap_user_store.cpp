@@ -0,0 +1,391 @@
+/**
+ * @file mmap_user_store.cpp
+ * @author chenyinjie
+ * @date 2024-11-08
+ * @copyright Apache 2.0
+ */
+
+#include "mmap_user_store.h"
+
+static const char MAGIC[8] = {'W', 'S', 'U', 'S', 'E', 'R', 'S', '\0'};
+static const uint32_t VERSION = 1;
+static const size_t RECORD_HEAD_LEN = 5;            // 日志记录：校验和(4字节) + 用户名长度(1字节) + 用户名 + 密码
+
+MmapUserStore::MmapUserStore(const std::string& dir, size_t init_capacity, bool is_sync)
+    : init_capacity_(16), is_sync_(is_sync) {
+    while (init_capacity_ < init_capacity) {
+        init_capacity_ <<= 1;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        LOG_ERROR("Mmap User Store: Failed to create directory %s: %s.", dir.c_str(), ec.message().c_str());
+        throw std::runtime_error("Failed to create user store directory.");
+    }
+    table_path_ = std::filesystem::path(dir) / "users.tbl";
+    tmp_path_ = std::filesystem::path(dir) / "users.tbl.tmp";
+    journal_path_ = std::filesystem::path(dir) / "users.journal";
+
+    journal_fd_ = open(journal_path_.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    struct stat st;
+    if (journal_fd_ < 0 || fstat(journal_fd_, &st) < 0) {
+        LOG_ERROR("Mmap User Store: Failed to open journal %s, Error: %d.", journal_path_.c_str(), errno);
+        Close();
+        throw std::runtime_error("Failed to open user store journal.");
+    }
+
+    bool is_ok = false;
+    if (OpenTable(static_cast<uint64_t>(st.st_size))) {
+        is_ok = Replay(header_->journal_off);
+    } else {
+        // 未正常关闭或文件损坏，由日志完整重建
+        if (st.st_size > 0) {
+            LOG_WARN("Mmap User Store: Rebuild table from journal, %lld bytes.", static_cast<long long>(st.st_size));
+        } else {
+            LOG_INFO("Mmap User Store: Create user store in %s.", dir.c_str());
+        }
+        int fd = -1;
+        Header* header = CreateTable(init_capacity_, std::random_device{}() | (static_cast<uint64_t>(std::random_device{}()) << 32), &fd);
+        is_ok = header != nullptr && ReplaceTable(header, fd) && Replay(0);
+    }
+    if (!is_ok) {
+        Close();
+        throw std::runtime_error("Failed to load user store.");
+    }
+
+    // 运行期间标记为未完整，进程崩溃后下次启动由日志重建
+    Sync(false);
+    LOG_INFO("Mmap User Store: %zu users, capacity: %zu.", GetUserNums(), GetCapacity());
+}
+
+MmapUserStore::~MmapUserStore() {
+    std::unique_lock<std::shared_mutex> locker(mtx_);
+    Sync(true);
+    Close();
+}
+
+bool MmapUserStore::Login(const std::string& name, const std::string& hashed_pwd) {
+    uint8_t pwd[HASH_LEN];
+    if (name.empty() || name.size() > MAX_NAME_LEN || !ParseHash(hashed_pwd, pwd)) return false;
+
+    std::shared_lock<std::shared_mutex> locker(mtx_);
+    Slot* slot = Probe(header_, name.data(), name.size(), Hash(name.data(), name.size()));
+    if (slot->name_len == 0) {
+        LOG_DEBUG("Mmap User Store: User not found.");
+        return false;
+    }
+    if (memcmp(slot->pwd, pwd, HASH_LEN) != 0) {
+        LOG_DEBUG("Mmap User Store: User password incorrect.");
+        return false;
+    }
+    return true;
+}
+
+bool MmapUserStore::Register(const std::string& name, const std::string& hashed_pwd) {
+    uint8_t pwd[HASH_LEN];
+    if (name.empty() || name.size() > MAX_NAME_LEN || !ParseHash(hashed_pwd, pwd)) return false;
+
+    std::unique_lock<std::shared_mutex> locker(mtx_);
+    uint64_t hash = Hash(name.data(), name.size());
+    if (Probe(header_, name.data(), name.size(), hash)->name_len != 0) {
+        LOG_DEBUG("Mmap User Store: Username: %s already exists!", name.c_str());
+        return false;
+    }
+    if ((header_->size + 1) * 10 > header_->capacity * 7 && !Grow()) {
+        return false;
+    }
+    // 先写日志再写哈希表，扩容后需重新探测插入位置
+    if (!AppendJournal(name.data(), name.size(), pwd)) {
+        return false;
+    }
+    Slot* slot = Probe(header_, name.data(), name.size(), hash);
+    slot->hash = hash;
+    memcpy(slot->name, name.data(), name.size());
+    memcpy(slot->pwd, pwd, HASH_LEN);
+    slot->name_len = static_cast<uint32_t>(name.size());
+    ++header_->size;
+    header_->journal_off += RECORD_HEAD_LEN + name.size() + HASH_LEN;
+    return true;
+}
+
+size_t MmapUserStore::GetUserNums() const {
+    std::shared_lock<std::shared_mutex> locker(mtx_);
+    return header_->size;
+}
+
+size_t MmapUserStore::GetCapacity() const {
+    std::shared_lock<std::shared_mutex> locker(mtx_);
+    return header_->capacity;
+}
+
+bool MmapUserStore::OpenTable(uint64_t journal_len) {
+    table_fd_ = open(table_path_.c_str(), O_RDWR | O_CLOEXEC);
+    struct stat st;
+    if (table_fd_ < 0 || fstat(table_fd_, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+        Unmap();
+        return false;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, table_fd_, 0);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("Mmap User Store: mmap %s failed, Error: %d.", table_path_.c_str(), errno);
+        Unmap();
+        return false;
+    }
+    header_ = static_cast<Header*>(addr);
+    map_len_ = st.st_size;
+
+    uint64_t cap = header_->capacity;
+    bool is_valid = memcmp(header_->magic, MAGIC, sizeof(MAGIC)) == 0 && header_->version == VERSION &&
+                    header_->is_clean == 1 && cap != 0 && (cap & (cap - 1)) == 0 &&
+                    map_len_ == GetTableLen(cap) && header_->size * 10 <= cap * 7 &&
+                    header_->journal_off <= journal_len;
+    if (!is_valid) {
+        Unmap();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief
+ * 逐条校验日志记录并写入哈希表，已存在的用户名跳过(哈希表可能已包含部分记录)
+ * 遇到不完整或校验失败的记录时停止，并截断日志，之后的注册从该位置继续追加
+ */
+bool MmapUserStore::Replay(uint64_t offset) {
+    struct stat st;
+    if (fstat(journal_fd_, &st) < 0) {
+        LOG_ERROR("Mmap User Store: fstat journal failed, Error: %d.", errno);
+        return false;
+    }
+    std::vector<uint8_t> buf(static_cast<uint64_t>(st.st_size) - offset);
+    size_t len = 0;
+    while (len < buf.size()) {
+        ssize_t n = pread(journal_fd_, buf.data() + len, buf.size() - len, offset + len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            LOG_ERROR("Mmap User Store: Read journal failed, Error: %d.", errno);
+            return false;
+        }
+        len += n;
+    }
+
+    size_t pos = 0;
+    size_t cnt = 0;
+    while (pos + RECORD_HEAD_LEN <= buf.size()) {
+        size_t name_len = buf[pos + 4];
+        size_t rec_len = RECORD_HEAD_LEN + name_len + HASH_LEN;
+        uint32_t checksum;
+        memcpy(&checksum, buf.data() + pos, sizeof(checksum));
+        if (name_len == 0 || name_len > MAX_NAME_LEN || pos + rec_len > buf.size() ||
+            Checksum(buf.data() + pos + 4, rec_len - 4) != checksum) {
+            break;
+        }
+
+        const char* name = reinterpret_cast<const char*>(buf.data() + pos + RECORD_HEAD_LEN);
+        uint64_t hash = Hash(name, name_len);
+        if (Probe(header_, name, name_len, hash)->name_len == 0) {
+            if ((header_->size + 1) * 10 > header_->capacity * 7 && !Grow()) {
+                return false;
+            }
+            Slot* slot = Probe(header_, name, name_len, hash);
+            slot->hash = hash;
+            memcpy(slot->name, name, name_len);
+            memcpy(slot->pwd, name + name_len, HASH_LEN);
+            slot->name_len = static_cast<uint32_t>(name_len);
+            ++header_->size;
+            ++cnt;
+        }
+        pos += rec_len;
+    }
+
+    header_->journal_off = offset + pos;
+    if (pos < buf.size()) {
+        LOG_WARN("Mmap User Store: Truncate %zu bytes of broken journal tail.", buf.size() - pos);
+        if (ftruncate(journal_fd_, header_->journal_off) < 0) {
+            LOG_ERROR("Mmap User Store: Truncate journal failed, Error: %d.", errno);
+            return false;
+        }
+    }
+    if (cnt > 0) {
+        LOG_INFO("Mmap User Store: Replay %zu users from journal.", cnt);
+    }
+    return true;
+}
+
+bool MmapUserStore::Grow() {
+    int fd = -1;
+    Header* header = CreateTable(header_->capacity * 2, header_->seed, &fd);
+    if (header == nullptr) {
+        return false;
+    }
+    // 种子不变，槽位中保存的哈希值可直接使用
+    Slot* slots = reinterpret_cast<Slot*>(header_ + 1);
+    for (uint64_t i = 0; i < header_->capacity; ++i) {
+        if (slots[i].name_len == 0) continue;
+        *Probe(header, slots[i].name, slots[i].name_len, slots[i].hash) = slots[i];
+        ++header->size;
+    }
+    header->journal_off = header_->journal_off;
+    LOG_INFO("Mmap User Store: Grow capacity to %llu.", static_cast<unsigned long long>(header->capacity));
+    return ReplaceTable(header, fd);
+}
+
+bool MmapUserStore::AppendJournal(const char* name, size_t len, const uint8_t* pwd) {
+    uint8_t rec[RECORD_HEAD_LEN + MAX_NAME_LEN + HASH_LEN];
+    size_t rec_len = RECORD_HEAD_LEN + len + HASH_LEN;
+    rec[4] = static_cast<uint8_t>(len);
+    memcpy(rec + RECORD_HEAD_LEN, name, len);
+    memcpy(rec + RECORD_HEAD_LEN + len, pwd, HASH_LEN);
+    uint32_t checksum = Checksum(rec + 4, rec_len - 4);
+    memcpy(rec, &checksum, sizeof(checksum));
+
+    ssize_t n;
+    do {
+        n = write(journal_fd_, rec, rec_len);
+    } while (n < 0 && errno == EINTR);
+    if (n != static_cast<ssize_t>(rec_len) || (is_sync_ && fdatasync(journal_fd_) < 0)) {
+        LOG_ERROR("Mmap User Store: Write journal failed, Error: %d.", errno);
+        // 去掉写入了一部分的记录，保持日志完整
+        if (ftruncate(journal_fd_, header_->journal_off) < 0) {
+            LOG_ERROR("Mmap User Store: Truncate journal failed, Error: %d.", errno);
+        }
+        return false;
+    }
+    return true;
+}
+
+MmapUserStore::Header* MmapUserStore::CreateTable(size_t capacity, uint64_t seed, int* fd) {
+    size_t len = GetTableLen(capacity);
+    *fd = open(tmp_path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (*fd < 0 || ftruncate(*fd, len) < 0) {
+        LOG_ERROR("Mmap User Store: Create table %s failed, Error: %d.", tmp_path_.c_str(), errno);
+        if (*fd >= 0) close(*fd);
+        return nullptr;
+    }
+    void* addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("Mmap User Store: mmap %s failed, Error: %d.", tmp_path_.c_str(), errno);
+        close(*fd);
+        return nullptr;
+    }
+
+    // ftruncate扩展的部分全部为0，即全部为空槽
+    Header* header = static_cast<Header*>(addr);
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->version = VERSION;
+    header->is_clean = 0;
+    header->capacity = capacity;
+    header->size = 0;
+    header->journal_off = 0;
+    header->seed = seed;
+    return header;
+}
+
+bool MmapUserStore::ReplaceTable(Header* header, int fd) {
+    size_t len = GetTableLen(header->capacity);
+    if (rename(tmp_path_.c_str(), table_path_.c_str()) < 0) {
+        LOG_ERROR("Mmap User Store: Replace table failed, Error: %d.", errno);
+        munmap(header, len);
+        close(fd);
+        return false;
+    }
+    Unmap();
+    header_ = header;
+    table_fd_ = fd;
+    map_len_ = len;
+    return true;
+}
+
+// 先将日志与槽位落盘，最后再写完整标记，标记落盘时其余数据一定已经落盘
+void MmapUserStore::Sync(bool is_clean) {
+    if (header_ == nullptr) return;
+    if (is_clean) {
+        if (fdatasync(journal_fd_) < 0 || msync(header_, map_len_, MS_SYNC) < 0) {
+            LOG_ERROR("Mmap User Store: Sync failed, Error: %d.", errno);
+            return;
+        }
+    }
+    header_->is_clean = is_clean ? 1 : 0;
+    if (msync(header_, sizeof(Header), MS_SYNC) < 0) {
+        LOG_ERROR("Mmap User Store: Sync header failed, Error: %d.", errno);
+    }
+}
+
+void MmapUserStore::Unmap() {
+    if (header_ != nullptr) {
+        munmap(header_, map_len_);
+        header_ = nullptr;
+        map_len_ = 0;
+    }
+    if (table_fd_ >= 0) {
+        close(table_fd_);
+        table_fd_ = -1;
+    }
+}
+
+void MmapUserStore::Close() {
+    Unmap();
+    if (journal_fd_ >= 0) {
+        close(journal_fd_);
+        journal_fd_ = -1;
+    }
+}
+
+// 以种子初始化的FNV-1a，再经过murmur3的混合函数，使低位分布均匀
+uint64_t MmapUserStore::Hash(const char* name, size_t len) const {
+    uint64_t hash = 14695981039346656037ULL ^ header_->seed;
+    for (size_t i = 0; i < len; ++i) {
+        hash ^= static_cast<uint8_t>(name[i]);
+        hash *= 1099511628211ULL;
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// 装载因子不超过0.7，一定存在空槽
+MmapUserStore::Slot* MmapUserStore::Probe(Header* header, const char* name, size_t len, uint64_t hash) {
+    Slot* slots = reinterpret_cast<Slot*>(header + 1);
+    uint64_t mask = header->capacity - 1;
+    for (uint64_t i = hash & mask; ; i = (i + 1) & mask) {
+        Slot* slot = &slots[i];
+        if (slot->name_len == 0 ||
+            (slot->hash == hash && slot->name_len == len && memcmp(slot->name, name, len) == 0)) {
+            return slot;
+        }
+    }
+}
+
+size_t MmapUserStore::GetTableLen(size_t capacity) {
+    return sizeof(Header) + capacity * sizeof(Slot);
+}
+
+bool MmapUserStore::ParseHash(const std::string& hashed_pwd, uint8_t* pwd) {
+    if (hashed_pwd.size() != HASH_LEN * 2) return false;
+    auto hex = [](char ch) {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < HASH_LEN; ++i) {
+        int high = hex(hashed_pwd[i * 2]);
+        int low = hex(hashed_pwd[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        pwd[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+uint32_t MmapUserStore::Checksum(const uint8_t* data, size_t len) {
+    uint32_t checksum = 2166136261U;
+    for (size_t i = 0; i < len; ++i) {
+        checksum ^= data[i];
+        checksum *= 16777619U;
+    }
+    return checksum;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file mmap_user_store.h
+ * @author chenyinjie
+ * @date 2024-11-08
+ * @copyright Apache 2.0
+ */
+
+#ifndef MMAP_USER_STORE_H
+#define MMAP_USER_STORE_H
+
+#include "user_store.h"
+#include "../log/log.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief
+ * 嵌入式用户存储，不依赖数据库
+ * - 用户名 -> SHA-256(32字节)保存在内存映射的开放寻址哈希表中(线性探测)，登录只是一次本地查找。
+ *   装载因子超过0.7时容量翻倍，在新文件中重建后原子替换。
+ * - 每次注册先追加写入日志文件，再写入哈希表；日志是持久化的依据，哈希表可随时由日志重建。
+ *   正常关闭时落盘并标记哈希表完整，下次启动直接映射，只回放标记之后追加的日志；
+ *   未正常关闭(进程崩溃)或文件损坏时由日志完整重建，日志尾部不完整的记录被截断。
+ * - is_sync为true时每次注册后fdatasync日志，否则只保证进程崩溃不丢失，掉电可能丢失最近的注册。
+ * - 读写锁保护：登录共享，注册与扩容独占。
+ * - 用户名按字节精确匹配(MySQL按列的排序规则比较，可能不区分大小写)，长度不超过MAX_NAME_LEN。
+ * - 同一目录只能由一个进程打开。
+ */
+class MmapUserStore : public UserStore {
+public:
+    explicit MmapUserStore(const std::string& dir, size_t init_capacity = 1024, bool is_sync = false);
+    ~MmapUserStore() override;
+
+    MmapUserStore(const MmapUserStore&) = delete;
+    MmapUserStore& operator=(const MmapUserStore&) = delete;
+
+    bool Login(const std::string& name, const std::string& hashed_pwd) override;
+    bool Register(const std::string& name, const std::string& hashed_pwd) override;
+    const char* GetName() const override { return "mmap"; }
+
+    size_t GetUserNums() const;                     // 已注册用户数
+    size_t GetCapacity() const;                     // 哈希表槽位数
+
+    static const size_t MAX_NAME_LEN = 80;          // 用户名最大字节数
+    static const size_t HASH_LEN = 32;              // SHA-256字节数
+
+private:
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t is_clean;                          // 是否正常关闭，为0时启动需由日志重建
+        uint64_t capacity;                          // 槽位数，2的幂
+        uint64_t size;                              // 已使用的槽位数
+        uint64_t journal_off;                       // 已写入哈希表的日志长度
+        uint64_t seed;                              // 哈希种子，建表时随机生成
+        char reserved[80];
+    };
+
+    struct Slot {
+        uint64_t hash;                              // 用户名的哈希值
+        uint32_t name_len;                          // 为0表示空槽
+        uint32_t reserved;
+        char name[MAX_NAME_LEN];
+        uint8_t pwd[HASH_LEN];
+    };
+
+    static_assert(sizeof(Header) == 128 && sizeof(Slot) == 128, "unexpected table layout");
+
+    bool OpenTable(uint64_t journal_len);           // 映射已有的完整哈希表
+    bool Replay(uint64_t offset);                   // 回放offset之后的日志
+    bool Grow();                                    // 容量翻倍
+    bool AppendJournal(const char* name, size_t len, const uint8_t* pwd);
+    Header* CreateTable(size_t capacity, uint64_t seed, int* fd);   // 在临时文件中新建空哈希表
+    bool ReplaceTable(Header* header, int fd);      // 以新哈希表原子替换当前哈希表
+    void Sync(bool is_clean);                       // 落盘并更新完整标记
+    void Unmap();
+    void Close();
+
+    uint64_t Hash(const char* name, size_t len) const;
+    // 查找用户名所在的槽位，不存在时返回应插入的空槽
+    static Slot* Probe(Header* header, const char* name, size_t len, uint64_t hash);
+    static size_t GetTableLen(size_t capacity);
+    static bool ParseHash(const std::string& hashed_pwd, uint8_t* pwd);     // 十六进制串转为32字节
+    static uint32_t Checksum(const uint8_t* data, size_t len);
+
+    std::filesystem::path table_path_;
+    std::filesystem::path tmp_path_;
+    std::filesystem::path journal_path_;
+    size_t init_capacity_;
+    bool is_sync_;
+
+    int table_fd_ = -1;
+    int journal_fd_ = -1;
+    Header* header_ = nullptr;                      // 映射起始地址，其后紧跟槽位数组
+    size_t map_len_ = 0;
+
+    mutable std::shared_mutex mtx_;
+};
+
+#endif
@@ -0,0 +1,115 @@
+/**
+ * @file mysql_user_store.cpp
+ * @author chenyinjie
+ * @date 2024-11-08
+ * @copyright Apache 2.0
+ */
+
+#include "mysql_user_store.h"
+
+static const std::string LOGIN_SQL = "SELECT password FROM user WHERE username=? LIMIT 1";
+static const std::string REGISTER_SQL = "INSERT INTO user(username, password) SELECT ?, ? FROM DUAL "
+                                        "WHERE NOT EXISTS (SELECT 1 FROM user WHERE username=?)";
+
+// 执行连接上缓存的预处理语句；语句失效(服务端已释放或连接已断开)时关闭，下次使用时重新预处理
+MYSQL_STMT* MySQLUserStore::ExecuteStatement(MYSQL* sql, const std::string& query, MYSQL_BIND* bind) {
+    SQLConnectPool* pool = SQLConnectPool::GetSQLConnectPoolInstance();
+    MYSQL_STMT* stmt = pool->GetStatement(sql, query);
+    if (stmt == nullptr) {
+        return nullptr;
+    }
+    if (mysql_stmt_bind_param(stmt, bind)) {
+        LOG_ERROR("mysql_stmt_bind_param failed: %s", mysql_stmt_error(stmt));
+        pool->DiscardStatement(sql, query);
+        return nullptr;
+    }
+    if (mysql_stmt_execute(stmt)) {
+        LOG_ERROR("mysql_stmt_execute failed: %s", mysql_stmt_error(stmt));
+        pool->DiscardStatement(sql, query);
+        return nullptr;
+    }
+    return stmt;
+}
+
+bool MySQLUserStore::Login(const std::string& name, const std::string& hashed_pwd) {
+    MYSQL* sql = nullptr;
+    SQLConnectPoolRAII sql_raii(&sql, SQLConnectPool::GetSQLConnectPoolInstance());
+    if (sql == nullptr) {
+        LOG_ERROR("Get SQL connection failed.");
+        return false;
+    }
+
+    MYSQL_BIND bind[1];
+    memset(bind, 0, sizeof(bind));
+    bind[0].buffer_type = MYSQL_TYPE_STRING;
+    bind[0].buffer = const_cast<char*>(name.c_str());
+    bind[0].buffer_length = name.length();
+
+    MYSQL_STMT* stmt = ExecuteStatement(sql, LOGIN_SQL, bind);
+    if (stmt == nullptr) {
+        return false;
+    }
+
+    // 绑定查询结果
+    MYSQL_BIND result_bind[1];
+    memset(result_bind, 0, sizeof(result_bind));
+    char db_pwd[256] = {0};
+    unsigned long length = 0;
+    result_bind[0].buffer_type = MYSQL_TYPE_STRING;
+    result_bind[0].buffer = db_pwd;
+    result_bind[0].buffer_length = sizeof(db_pwd);
+    result_bind[0].length = &length;
+
+    if (mysql_stmt_bind_result(stmt, result_bind) || mysql_stmt_store_result(stmt)) {
+        LOG_ERROR("mysql_stmt_bind_result failed: %s", mysql_stmt_error(stmt));
+        SQLConnectPool::GetSQLConnectPoolInstance()->DiscardStatement(sql, LOGIN_SQL);
+        return false;
+    }
+
+    bool flag = false;
+    if (mysql_stmt_fetch(stmt) == 0) {
+        if (hashed_pwd == db_pwd) {
+            flag = true;
+            LOG_INFO("User Login sucessful.");
+        } else {
+            LOG_WARN("User password incorrect.");
+        }
+    } else {
+        LOG_WARN("User not found.");
+    }
+    // 释放结果集，语句留在缓存中供下次使用
+    mysql_stmt_free_result(stmt);
+    return flag;
+}
+
+bool MySQLUserStore::Register(const std::string& name, const std::string& hashed_pwd) {
+    MYSQL* sql = nullptr;
+    SQLConnectPoolRAII sql_raii(&sql, SQLConnectPool::GetSQLConnectPoolInstance());
+    if (sql == nullptr) {
+        LOG_ERROR("Get SQL connection failed.");
+        return false;
+    }
+
+    // 依次绑定用户名、密码、用户名
+    MYSQL_BIND bind[3];
+    memset(bind, 0, sizeof(bind));
+    bind[0].buffer_type = MYSQL_TYPE_STRING;
+    bind[0].buffer = const_cast<char*>(name.c_str());
+    bind[0].buffer_length = name.length();
+    bind[1].buffer_type = MYSQL_TYPE_STRING;
+    bind[1].buffer = const_cast<char*>(hashed_pwd.c_str());
+    bind[1].buffer_length = hashed_pwd.length();
+    bind[2] = bind[0];
+
+    MYSQL_STMT* stmt = ExecuteStatement(sql, REGISTER_SQL, bind);
+    if (stmt == nullptr) {
+        return false;
+    }
+
+    if (mysql_stmt_affected_rows(stmt) == 1) {
+        LOG_DEBUG("User registered successfully!");
+        return true;
+    }
+    LOG_DEBUG("Username: %s already exists!", name.c_str());
+    return false;
+}
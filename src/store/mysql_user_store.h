@@ -0,0 +1,38 @@
+/**
+ * @file mysql_user_store.h
+ * @author chenyinjie
+ * @date 2024-11-08
+ * @copyright Apache 2.0
+ */
+
+#ifndef MYSQL_USER_STORE_H
+#define MYSQL_USER_STORE_H
+
+#include "user_store.h"
+#include "../log/log.h"
+#include "../pool/db_connect_pool.h"
+#include "../pool/db_connect_pool_RAII.h"
+
+#include <cstring>
+
+/**
+ * @brief
+ * 基于user表的用户存储，使用全局SQL连接池(需先初始化)
+ * - 登录：按用户名查询密码后比较
+ * - 注册：查重与插入合并为一条语句，用户名已存在时影响行数为0
+ * 语句由连接池按连接缓存，每个连接只预处理一次，之后只重新绑定参数
+ */
+class MySQLUserStore : public UserStore {
+public:
+    MySQLUserStore() = default;
+    ~MySQLUserStore() override = default;
+
+    bool Login(const std::string& name, const std::string& hashed_pwd) override;
+    bool Register(const std::string& name, const std::string& hashed_pwd) override;
+    const char* GetName() const override { return "mysql"; }
+
+private:
+    static MYSQL_STMT* ExecuteStatement(MYSQL* sql, const std::string& query, MYSQL_BIND* bind);
+};
+
+#endif
@@ -0,0 +1,112 @@
+/**
+ * @file session_store.cpp
+ * @author chenyinjie
+ * @date 2024-11-09
+ * @copyright Apache 2.0
+ */
+
+#include "session_store.h"
+
+SessionStore::SessionStore(int ttl_ms, size_t shard_nums, size_t max_sessions)
+    : ttl_(ttl_ms), shard_nums_(shard_nums) {
+    if (ttl_ms <= 0 || shard_nums == 0 || max_sessions == 0) {
+        LOG_ERROR("Session Store: Invalid ttl: %d ms, shard nums: %zu, max sessions: %zu.", ttl_ms, shard_nums, max_sessions);
+        throw std::invalid_argument("Invalid session store arguments.");
+    }
+    max_shard_sessions_ = std::max<size_t>(1, max_sessions / shard_nums);
+    shards_ = std::make_unique<Shard[]>(shard_nums_);
+}
+
+std::string SessionStore::Create(const std::string& name) {
+    SessionId id;
+    if (RAND_bytes(id.data(), static_cast<int>(id.size())) != 1) {
+        LOG_ERROR("Session Store: Failed to generate session id.");
+        return "";
+    }
+    TimePoint expire = std::chrono::steady_clock::now() + ttl_;
+
+    Shard& shard = GetShard(id);
+    {
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        // 分片已满时淘汰最早到期的会话
+        while (shard.sessions.size() >= max_shard_sessions_ && !shard.expires.empty()) {
+            shard.sessions.erase(shard.expires.front().second);
+            shard.expires.pop_front();
+            size_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        shard.sessions.emplace(id, Session{name, expire});
+        shard.expires.emplace_back(expire, id);
+    }
+    size_.fetch_add(1, std::memory_order_relaxed);
+
+    static const char HEX[] = "0123456789abcdef";
+    std::string sid(id.size() * 2, '0');
+    for (size_t i = 0; i < id.size(); ++i) {
+        sid[i * 2] = HEX[id[i] >> 4];
+        sid[i * 2 + 1] = HEX[id[i] & 0xf];
+    }
+    return sid;
+}
+
+bool SessionStore::Check(const std::string& sid, std::string* name) {
+    SessionId id;
+    if (!ParseId(sid, &id)) return false;
+
+    Shard& shard = GetShard(id);
+    std::lock_guard<std::mutex> locker(shard.mtx);
+    auto it = shard.sessions.find(id);
+    if (it == shard.sessions.end() || it->second.expire <= std::chrono::steady_clock::now()) {
+        return false;
+    }
+    *name = it->second.name;
+    return true;
+}
+
+size_t SessionStore::Expire() {
+    TimePoint now = std::chrono::steady_clock::now();
+    size_t cnt = 0;
+    for (size_t i = 0; i < shard_nums_; ++i) {
+        Shard& shard = shards_[i];
+        std::lock_guard<std::mutex> locker(shard.mtx);
+        while (!shard.expires.empty() && shard.expires.front().first <= now) {
+            shard.sessions.erase(shard.expires.front().second);
+            shard.expires.pop_front();
+            ++cnt;
+        }
+    }
+    size_.fetch_sub(cnt, std::memory_order_relaxed);
+    return cnt;
+}
+
+std::string SessionStore::GetCookie(const std::string& sid) const {
+    return std::string(COOKIE_NAME) + "=" + sid + "; Max-Age=" + std::to_string(ttl_.count() / 1000) +
+           "; Path=/; HttpOnly; SameSite=Lax";
+}
+
+size_t SessionStore::Size() const {
+    return size_.load(std::memory_order_relaxed);
+}
+
+int SessionStore::GetTTL() const {
+    return static_cast<int>(ttl_.count());
+}
+
+SessionStore::Shard& SessionStore::GetShard(const SessionId& id) {
+    return shards_[id[8] % shard_nums_];
+}
+
+bool SessionStore::ParseId(const std::string& sid, SessionId* id) {
+    if (sid.size() != id->size() * 2) return false;
+    auto hex = [](char ch) {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        return -1;
+    };
+    for (size_t i = 0; i < id->size(); ++i) {
+        int high = hex(sid[i * 2]);
+        int low = hex(sid[i * 2 + 1]);
+        if (high < 0 || low < 0) return false;
+        (*id)[i] = static_cast<uint8_t>((high << 4) | low);
+    }
+    return true;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file session_store.h
+ * @author chenyinjie
+ * @date 2024-11-09
+ * @copyright Apache 2.0
+ */
+
+#ifndef SESSION_STORE_H
+#define SESSION_STORE_H
+
+#include "../log/log.h"
+
+#include <openssl/rand.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief
+ * 内存会话表，登录成功后签发会话，之后携带会话Cookie的登录请求不再访问用户存储
+ * - 会话ID为OpenSSL生成的128位随机数，Cookie中为32位十六进制串。
+ * - 按会话ID分片(锁分段)，每个分片独立加锁，查找为一次哈希表访问。
+ * - 会话从创建起ttl_ms后过期：查找时比较到期时间，过期会话由服务器定时器周期调用Expire清理。
+ *   TTL固定，创建顺序即到期顺序，每个分片以队列记录到期顺序，清理只访问已过期的会话。
+ * - 分片中的会话数达到上限时淘汰最早到期的会话。
+ */
+class SessionStore {
+public:
+    explicit SessionStore(int ttl_ms = DEFAULT_TTL_MS, size_t shard_nums = 16, size_t max_sessions = 1 << 20);
+    ~SessionStore() = default;
+
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    std::string Create(const std::string& name);                // 签发会话，返回会话ID，失败时返回空串
+    bool Check(const std::string& sid, std::string* name);      // 会话存在且未过期时取回用户名
+    size_t Expire();                                            // 清理已过期的会话，返回清理数
+    std::string GetCookie(const std::string& sid) const;        // Set-Cookie首部的值
+
+    size_t Size() const;                                        // 当前会话数(含未清理的过期会话)
+    int GetTTL() const;
+
+    static constexpr const char* COOKIE_NAME = "sid";
+    static const int DEFAULT_TTL_MS = 30 * 60 * 1000;           // 默认会话有效期
+    static const int SWEEP_INTERVAL_MS = 1000;                  // 定时清理间隔
+
+private:
+    using SessionId = std::array<uint8_t, 16>;
+    using TimePoint = std::chrono::steady_clock::time_point;
+
+    // 会话ID本身是随机数，直接取其中8字节作为哈希值，另取1字节选择分片
+    struct IdHash {
+        size_t operator()(const SessionId& id) const {
+            uint64_t hash;
+            memcpy(&hash, id.data(), sizeof(hash));
+            return static_cast<size_t>(hash);
+        }
+    };
+
+    struct Session {
+        std::string name;                                       // 用户名
+        TimePoint expire;                                       // 到期时间
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mtx;
+        std::unordered_map<SessionId, Session, IdHash> sessions;
+        std::deque<std::pair<TimePoint, SessionId>> expires;    // 按到期时间排列
+    };
+
+    Shard& GetShard(const SessionId& id);
+    static bool ParseId(const std::string& sid, SessionId* id); // 32位十六进制串转为会话ID
+
+    std::chrono::milliseconds ttl_;
+    size_t shard_nums_;
+    size_t max_shard_sessions_;                                 // 每个分片的最大会话数
+    std::unique_ptr<Shard[]> shards_;
+    std::atomic<size_t> size_{0};
+};
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * @file user_store.cpp
+ * @author chenyinjie
+ * @date 2024-11-08
+ * @copyright Apache 2.0
+ */
+
+#include "user_store.h"
+#include "mysql_user_store.h"
+#include "mmap_user_store.h"
+
+std::unique_ptr<UserStore> CreateUserStore(USER_STORE type, const std::string& path) {
+    switch (type) {
+        case USER_STORE::MMAP:
+            return std::make_unique<MmapUserStore>(path);
+        case USER_STORE::MYSQL:
+        default:
+            return std::make_unique<MySQLUserStore>();
+    }
+}
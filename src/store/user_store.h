@@ -0,0 +1,42 @@
+/**
+ * @file user_store.h
+ * @author chenyinjie
+ * @date 2024-11-08
+ * @copyright Apache 2.0
+ */
+
+#ifndef USER_STORE_H
+#define USER_STORE_H
+
+#include <memory>
+#include <string>
+
+/**
+ * @brief
+ * 用户存储类型
+ * MYSQL: user表，经连接池执行预处理语句
+ * MMAP: 本地内存映射哈希表与追加日志，登录为本地查找，不依赖数据库
+ */
+enum class USER_STORE {
+    MYSQL = 0,
+    MMAP = 1
+};
+
+/**
+ * @brief
+ * 用户存储公共接口，同步执行登录验证与注册
+ * 密码均为SHA-256十六进制串，由调用方计算；实现需保证多线程并发调用安全。
+ */
+class UserStore {
+public:
+    virtual ~UserStore() = default;
+
+    virtual bool Login(const std::string& name, const std::string& hashed_pwd) = 0;     // 用户存在且密码一致
+    virtual bool Register(const std::string& name, const std::string& hashed_pwd) = 0;  // 用户名已存在时返回false
+    virtual const char* GetName() const = 0;                        // 存储名称
+};
+
+// 创建指定类型的用户存储，path为本地存储目录(MYSQL不使用)，失败时抛出异常
+std::unique_ptr<UserStore> CreateUserStore(USER_STORE type, const std::string& path = "");
+
+#endif
@@ -43,6 +43,28 @@ void TimerHeap::UpdateTimer(int id, int new_expire) {
     }
 }
 
+void TimerHeap::AddTimer(TimerNode* node, int timeout) {
+    // 连接复用同一id时先移除残留的旧定时器
+    DeleteTimer(node->id);
+    AddTimer(node->id, timeout, node->callback);
+}
+
+void TimerHeap::UpdateTimer(TimerNode* node, int timeout) {
+    UpdateTimer(node->id, timeout);
+}
+
+void TimerHeap::DeleteTimer(TimerNode* node) {
+    DeleteTimer(node->id);
+}
+
+size_t TimerHeap::Size() const {
+    return timer_heap_.size();
+}
+
+const char* TimerHeap::GetName() const {
+    return "heap";
+}
+
 void TimerHeap::CBWorker(int id) {
     if (timer_heap_.empty() || !id_maps_.contains(id)) {
         LOG_WARN("Timer CallBack Worker Failed: CallBack Worker Called Invalid.");
@@ -54,6 +76,12 @@ void TimerHeap::CBWorker(int id) {
     RemoveTimer(idx);
 }
 
+void TimerHeap::DeleteTimer(int id) {
+    auto it = id_maps_.find(id);
+    if (it == id_maps_.end()) return;
+    RemoveTimer(it->second);
+}
+
 void TimerHeap::ClearAllTimers() {
     timer_heap_.clear();
     id_maps_.clear();
@@ -64,8 +92,9 @@ void TimerHeap::CleanExpiredTimer() {
     while (!timer_heap_.empty()) {
         Timer timer = timer_heap_.front();
         if (std::chrono::duration_cast<MS>(timer._expire - Clock::now()).count() > 0) break;
-        timer._callback_func();
+        // 先出堆再执行回调，回调中删除或重新添加同一id的定时器不会影响堆结构
         RemoveTopTimer();
+        timer._callback_func();
     }
 }
 
@@ -9,6 +9,7 @@
 #define TIMER_H
 
 #include "../log/log.h"
+#include "timer_queue.h"
 
 #include <vector>
 #include <unordered_map>
@@ -16,11 +17,6 @@
 #include <functional>
 #include <chrono>
 
-using TimeoutCallBackFunc = std::function<void()>;
-using Clock = std::chrono::steady_clock;
-using MS = std::chrono::milliseconds;
-using TimeStamp = std::chrono::steady_clock::time_point;
-
 // 定时器结构
 struct Timer {
     int _id;
@@ -30,18 +26,25 @@ struct Timer {
         : _id(id), _expire(expire), _callback_func(cb_f) {};
 };
 
-class TimerHeap {
+class TimerHeap : public TimerQueue {
 public:
     TimerHeap();
     ~TimerHeap();
 
+    void AddTimer(TimerNode* node, int timeout) override;               // 以node->id为键添加定时器
+    void UpdateTimer(TimerNode* node, int timeout) override;
+    void DeleteTimer(TimerNode* node) override;
+    size_t Size() const override;
+    const char* GetName() const override;
+
     void AddTimer(int id, int timeout, const TimeoutCallBackFunc& cb_f);// 添加定时器
     void UpdateTimer(int id, int new_expire);                           // 重新设置定时器
     void CBWorker(int id);                                              // 执行定时器绑定的回调函数
-    void CleanExpiredTimer();                                           // 清理到期计时器
+    void DeleteTimer(int id);                                           // 删除指定定时器(不执行回调)
+    void CleanExpiredTimer() override;                                  // 清理到期计时器
     void RemoveTopTimer();                                              // 移除最早到期定时器
     void ClearAllTimers();                                              // 清空所以定时器
-    int GetNextExpireTime();                                            // 获取当前未到期的最早定时器时间点
+    int GetNextExpireTime() override;                                   // 获取当前未到期的最早定时器时间点
 
 private:
     void RemoveTimer(size_t idx);                                       // 移除堆中指定索引的定时器
@@ -0,0 +1,20 @@
+/**
+ * @file timer_queue.cpp
+ * @author chenyinjie
+ * @date 2024-10-31
+ * @copyright Apache 2.0
+ */
+
+#include "timer_queue.h"
+#include "timer.h"
+#include "timer_wheel.h"
+
+std::unique_ptr<TimerQueue> CreateTimerQueue(TIMER_TYPE type) {
+    switch (type) {
+        case TIMER_TYPE::WHEEL:
+            return std::make_unique<TimerWheel>();
+        case TIMER_TYPE::HEAP:
+        default:
+            return std::make_unique<TimerHeap>();
+    }
+}
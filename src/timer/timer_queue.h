@@ -0,0 +1,78 @@
+/**
+ * @file timer_queue.h
+ * @author chenyinjie
+ * @date 2024-10-31
+ * @copyright Apache 2.0
+ */
+
+#ifndef TIMER_QUEUE_H
+#define TIMER_QUEUE_H
+
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+using TimeoutCallBackFunc = std::function<void()>;
+using Clock = std::chrono::steady_clock;
+using MS = std::chrono::milliseconds;
+using TimeStamp = std::chrono::steady_clock::time_point;
+
+/**
+ * @brief
+ * 定时器类型
+ * HEAP: 小顶堆，增删改O(log n)
+ * WHEEL: 分层时间轮，增删改O(1)
+ */
+enum class TIMER_TYPE {
+    HEAP = 0,
+    WHEEL = 1
+};
+
+// 侵入式链表节点
+struct TimerLink {
+    TimerLink* prev = nullptr;
+    TimerLink* next = nullptr;
+};
+
+/**
+ * @brief
+ * 侵入式定时器节点
+ * 由定时对象(如连接)持有，id与回调由持有者在添加前设置；时间轮直接将节点挂入槽位链表，增删改不需要查表。
+ * 节点挂入定时器期间地址不能改变。
+ */
+struct TimerNode : TimerLink {
+    TimerNode() = default;
+    TimerNode(const TimerNode&) = delete;
+    TimerNode& operator=(const TimerNode&) = delete;
+
+    int id = -1;                                                // 定时器id
+    TimeoutCallBackFunc callback;                               // 到期回调
+    uint64_t expire = 0;                                        // 到期tick(时间轮使用)
+    int slot = -1;                                              // 所在槽位(时间轮使用)，-1为未添加
+};
+
+/**
+ * @brief
+ * 定时器公共接口
+ * 服务器与从Reactor只依赖该接口，可在小顶堆与时间轮之间切换。
+ * 重复添加同一节点视为重新设置；回调执行前定时器已被移除，回调中可删除或重新添加任意节点。
+ */
+class TimerQueue {
+public:
+    virtual ~TimerQueue() = default;
+
+    virtual void AddTimer(TimerNode* node, int timeout) = 0;    // 添加定时器
+    virtual void UpdateTimer(TimerNode* node, int timeout) = 0; // 重新设置定时器
+    virtual void DeleteTimer(TimerNode* node) = 0;              // 删除定时器(不执行回调)
+    virtual void CleanExpiredTimer() = 0;                       // 执行并移除到期定时器
+    virtual int GetNextExpireTime() = 0;                        // 距下一次需要处理的时间(ms)，无定时器时返回-1
+    virtual size_t Size() const = 0;                            // 定时器数量
+    virtual const char* GetName() const = 0;                    // 定时器名称
+};
+
+// 创建指定类型的定时器
+std::unique_ptr<TimerQueue> CreateTimerQueue(TIMER_TYPE type);
+
+#endif
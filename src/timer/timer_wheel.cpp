@@ -0,0 +1,222 @@
+/**
+ * @file timer_wheel.cpp
+ * @author chenyinjie
+ * @date 2024-10-31
+ * @copyright Apache 2.0
+ */
+
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(int tick_ms): tick_ms_(tick_ms > 0 ? tick_ms : 1), start_(Clock::now()), cur_tick_(0), size_(0) {
+    for (int level = 0; level < LEVELS; ++level) {
+        bitmap_[level] = 0;
+    }
+    for (TimerLink& head : slots_) {
+        head.prev = head.next = &head;
+    }
+    LOG_INFO("Timer Wheel: Init Timer Wheel Success, tick: %d ms.", tick_ms_);
+}
+
+// 节点由持有者管理，可能先于时间轮析构，析构时不访问节点
+TimerWheel::~TimerWheel() = default;
+
+void TimerWheel::AddTimer(TimerNode* node, int timeout) {
+    if (node->slot != -1) {
+        DeleteTimer(node);
+    }
+    node->expire = ToTick(Clock::now() + MS(std::max(timeout, 0)), true);
+    Insert(node);
+    ++size_;
+}
+
+void TimerWheel::UpdateTimer(TimerNode* node, int timeout) {
+    if (node->slot == -1) {
+        LOG_ERROR("Update Timer Failed: Timer With id: %d Not Exists.", node->id);
+        return;
+    }
+    uint64_t expire = ToTick(Clock::now() + MS(std::max(timeout, 0)), true);
+    // 同一tick内的多次更新不需要移动节点
+    if (expire == node->expire && node->slot != DISPATCHING) {
+        return;
+    }
+    Unlink(node);
+    node->expire = expire;
+    Insert(node);
+}
+
+void TimerWheel::DeleteTimer(TimerNode* node) {
+    if (node->slot == -1) return;
+    Unlink(node);
+    node->slot = -1;
+    --size_;
+}
+
+void TimerWheel::CleanExpiredTimer() {
+    Expire(Clock::now());
+}
+
+int TimerWheel::GetNextExpireTime() {
+    CleanExpiredTimer();
+    uint64_t next = GetNextTick();
+    if (size_ == 0 || next == UINT64_MAX) return -1;
+    // 向上取整，避免提前醒来后空转
+    auto wait = start_ + MS(next * tick_ms_) - Clock::now();
+    int64_t ms = std::chrono::ceil<MS>(wait).count();
+    return static_cast<int>(std::clamp<int64_t>(ms, 0, INT32_MAX));
+}
+
+size_t TimerWheel::Size() const {
+    return size_;
+}
+
+const char* TimerWheel::GetName() const {
+    return "wheel";
+}
+
+/**
+ * @brief
+ * 依次处理截至now的各个tick，直接跳过中间既无到期也无级联的tick
+ */
+void TimerWheel::Expire(TimeStamp now) {
+    uint64_t target = ToTick(now, false);
+    while (cur_tick_ <= target) {
+        uint64_t next = size_ > 0 ? GetNextTick() : UINT64_MAX;
+        if (next > target) {
+            cur_tick_ = target + 1;
+            break;
+        }
+        cur_tick_ = next;
+        RunTick();
+    }
+}
+
+void TimerWheel::ClearAllTimers() {
+    for (TimerLink& head : slots_) {
+        for (TimerLink* link = head.next; link != &head; link = link->next) {
+            static_cast<TimerNode*>(link)->slot = -1;
+        }
+        head.prev = head.next = &head;
+    }
+    for (int level = 0; level < LEVELS; ++level) {
+        bitmap_[level] = 0;
+    }
+    size_ = 0;
+}
+
+uint64_t TimerWheel::ToTick(TimeStamp time, bool is_ceil) const {
+    if (time <= start_) return 0;
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(time - start_).count();
+    uint64_t unit = static_cast<uint64_t>(tick_ms_) * 1000000;
+    return is_ceil ? (ns + unit - 1) / unit : ns / unit;
+}
+
+/**
+ * @brief
+ * 到期tick与当前tick相差不足SLOTS时挂入第0层(已到期的挂入当前槽位)，
+ * 否则挂入差值所在的层，槽位由到期tick在该层的位决定
+ */
+void TimerWheel::Insert(TimerNode* node) {
+    uint64_t expire = node->expire;
+    uint64_t delta = expire > cur_tick_ ? expire - cur_tick_ : 0;
+    int level = 0;
+    if (delta == 0) {
+        expire = cur_tick_;
+    } else if (delta >= static_cast<uint64_t>(SLOTS)) {
+        if (delta > MAX_DELTA) {
+            delta = MAX_DELTA;
+            expire = cur_tick_ + MAX_DELTA;
+        }
+        level = (std::bit_width(delta) - 1) / LEVEL_BITS;
+    }
+    uint64_t idx = (expire >> (LEVEL_BITS * level)) & SLOT_MASK;
+    TimerLink* head = &slots_[level * SLOTS + idx];
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+    node->slot = level * SLOTS + static_cast<int>(idx);
+    bitmap_[level] |= 1ULL << idx;
+}
+
+void TimerWheel::Unlink(TimerNode* node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = node->next = nullptr;
+    if (node->slot >= 0) {
+        TimerLink* head = &slots_[node->slot];
+        if (head->next == head) {
+            bitmap_[node->slot / SLOTS] &= ~(1ULL << (node->slot % SLOTS));
+        }
+    }
+}
+
+void TimerWheel::Cascade(int level, uint64_t idx) {
+    TimerLink* head = &slots_[level * SLOTS + idx];
+    while (head->next != head) {
+        TimerNode* node = static_cast<TimerNode*>(head->next);
+        Unlink(node);
+        Insert(node);
+    }
+}
+
+/**
+ * @brief
+ * 第0层转完一圈时级联第1层的当前槽位，第1层也转完一圈时继续级联第2层，以此类推；
+ * 随后取出第0层当前槽位中的全部定时器，逐个移除后执行回调
+ */
+void TimerWheel::RunTick() {
+    uint64_t idx = cur_tick_ & SLOT_MASK;
+    for (int level = 1; idx == 0 && level < LEVELS; ++level) {
+        idx = (cur_tick_ >> (LEVEL_BITS * level)) & SLOT_MASK;
+        Cascade(level, idx);
+    }
+
+    TimerLink* head = &slots_[cur_tick_ & SLOT_MASK];
+    ++cur_tick_;
+    if (head->next == head) return;
+
+    // 转移到局部链表，回调中删除或重新添加节点不影响遍历
+    TimerLink expired;
+    expired.next = head->next;
+    expired.prev = head->prev;
+    expired.next->prev = &expired;
+    expired.prev->next = &expired;
+    head->prev = head->next = head;
+    bitmap_[0] &= ~(1ULL << ((cur_tick_ - 1) & SLOT_MASK));
+    for (TimerLink* link = expired.next; link != &expired; link = link->next) {
+        static_cast<TimerNode*>(link)->slot = DISPATCHING;
+    }
+
+    while (expired.next != &expired) {
+        TimerNode* node = static_cast<TimerNode*>(expired.next);
+        Unlink(node);
+        node->slot = -1;
+        --size_;
+        node->callback();
+    }
+}
+
+/**
+ * @brief
+ * 第0层槽位idx在第一个满足(tick & SLOT_MASK) == idx的tick到期；
+ * 第k层槽位idx在第一个低位全为0且第k层位等于idx的tick级联，当前槽位只有恰好位于边界时才属于本轮。
+ * 各层分别由位图循环右移后取最低位得到最近的非空槽位。
+ */
+uint64_t TimerWheel::GetNextTick() const {
+    uint64_t next = UINT64_MAX;
+    for (int level = 0; level < LEVELS; ++level) {
+        if (bitmap_[level] == 0) continue;
+        int shift = LEVEL_BITS * level;
+        uint64_t base = cur_tick_ >> shift;
+        uint64_t rot = std::rotr(bitmap_[level], static_cast<int>(base & SLOT_MASK));
+        uint64_t dist;
+        if ((cur_tick_ & ((1ULL << shift) - 1)) == 0) {
+            dist = std::countr_zero(rot);
+        } else {
+            rot &= ~1ULL;
+            dist = rot != 0 ? std::countr_zero(rot) : SLOTS;
+        }
+        next = std::min(next, level == 0 ? cur_tick_ + dist : (base + dist) << shift);
+    }
+    return next;
+}
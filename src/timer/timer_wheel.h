@@ -0,0 +1,71 @@
+/**
+ * @file timer_wheel.h
+ * @author chenyinjie
+ * @date 2024-10-31
+ * @copyright Apache 2.0
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include "../log/log.h"
+#include "timer_queue.h"
+
+#include <algorithm>
+#include <bit>
+
+/**
+ * @brief
+ * 分层时间轮
+ * - 共LEVELS层，每层SLOTS个槽位，第0层每个槽位对应一个tick，第k层每个槽位对应SLOTS^k个tick。
+ * - 定时器按到期tick与当前tick之差挂入对应层的槽位，低层转完一圈时将高层对应槽位中的定时器重新分配到低层(级联)。
+ *   每个定时器最多级联LEVELS-1次，增删改与到期处理均摊O(1)。
+ * - 节点侵入式挂在槽位双向链表上，删除与更新直接摘链，不需要查表；到期tick不变时更新不做任何操作。
+ * - 每层维护非空槽位位图，可直接求出下一个需要处理的tick：空闲时跳过空槽位，等待时间精确到tick。
+ * - 超出时间轮范围的定时器暂存于最高层，级联时按真实到期时间重新分配，不会提前触发。
+ */
+
+class TimerWheel : public TimerQueue {
+public:
+    explicit TimerWheel(int tick_ms = 1);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    void AddTimer(TimerNode* node, int timeout) override;
+    void UpdateTimer(TimerNode* node, int timeout) override;
+    void DeleteTimer(TimerNode* node) override;
+    void CleanExpiredTimer() override;
+    int GetNextExpireTime() override;
+    size_t Size() const override;
+    const char* GetName() const override;
+
+    void Expire(TimeStamp now);                                 // 执行now之前到期的定时器
+    void ClearAllTimers();                                      // 清空所有定时器(不执行回调)
+
+    static const int LEVEL_BITS = 6;
+    static const int SLOTS = 1 << LEVEL_BITS;                   // 每层槽位数
+    static const int LEVELS = 4;                                // 层数，tick为1ms时范围约4.6小时
+
+private:
+    static const int DISPATCHING = -2;                          // 节点已取出、等待执行回调
+    static const uint64_t SLOT_MASK = SLOTS - 1;
+    static const uint64_t MAX_DELTA = (1ULL << (LEVEL_BITS * LEVELS)) - 1;
+
+    uint64_t ToTick(TimeStamp time, bool is_ceil) const;        // 时间点换算为tick
+    void Insert(TimerNode* node);                               // 按到期tick挂入槽位
+    void Unlink(TimerNode* node);                               // 从所在链表摘下
+    void Cascade(int level, uint64_t idx);                      // 将高层槽位重新分配到低层
+    void RunTick();                                             // 处理当前tick
+    uint64_t GetNextTick() const;                               // 下一个需要处理(到期或级联)的tick
+
+    int tick_ms_;                                               // 每个tick的毫秒数
+    TimeStamp start_;                                           // tick 0对应的时间点
+    uint64_t cur_tick_;                                         // 下一个待处理的tick
+    size_t size_;                                               // 定时器数量
+    uint64_t bitmap_[LEVELS];                                   // 各层非空槽位位图
+    TimerLink slots_[LEVELS * SLOTS];                           // 槽位链表表头
+};
+
+#endif
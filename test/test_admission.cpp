@@ -0,0 +1,168 @@
+/**
+ * @file test_admission.cpp
+ * @author chenyinjie
+ * @date 2024-11-03
+ */
+
+#include "../src/server/admission.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+
+TEST(AdmissionTest, NonBlockingAddTask) {
+    ThreadPool pool(1, 2);
+    std::atomic<bool> release{false};
+    auto block = [&release]() { while (!release) std::this_thread::sleep_for(MS(1)); };
+
+    ASSERT_TRUE(pool.AddTask(block));
+    std::this_thread::sleep_for(MS(20));
+    ASSERT_TRUE(pool.AddTask(block, MS(0)));
+    ASSERT_TRUE(pool.AddTask(block, MS(0)));
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(pool.AddTask(block, MS(0)));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, MS(5));
+    EXPECT_EQ(pool.QueueSize(), 2u);
+    release = true;
+}
+
+TEST(AdmissionTest, QueueDelay) {
+    ThreadPool pool(1, 16);
+    EXPECT_EQ(pool.TakeMinQueueDelay(), std::chrono::nanoseconds::max());
+
+    std::atomic<int> done{0};
+    ASSERT_TRUE(pool.AddTask([&done]() { std::this_thread::sleep_for(MS(30)); ++done; }));
+    ASSERT_TRUE(pool.AddTask([&done]() { ++done; }));
+    while (done < 2) std::this_thread::sleep_for(MS(1));
+
+    // 第一个任务几乎不排队，最小时延取其值
+    EXPECT_LT(pool.TakeMinQueueDelay(), std::chrono::nanoseconds(MS(20)));
+    EXPECT_EQ(pool.TakeMinQueueDelay(), std::chrono::nanoseconds::max());
+}
+
+TEST(AdmissionTest, ShedUnderOverload) {
+    ThreadPool pool(1, 64);
+    AdmissionController admission(&pool, MS(5), MS(20));
+    EXPECT_TRUE(admission.AdmitConnect());
+
+    // 单线程持续执行慢任务，排队时延持续超过target
+    std::atomic<bool> stop{false};
+    std::thread producer([&]() {
+        while (!stop) {
+            pool.AddTask([]() { std::this_thread::sleep_for(MS(2)); }, MS(0));
+            std::this_thread::sleep_for(MS(1));
+        }
+    });
+    std::this_thread::sleep_for(MS(60));
+    bool is_shed = false;
+    for (int i = 0; i < 50 && !is_shed; ++i) {
+        is_shed = !admission.AdmitConnect();
+        std::this_thread::sleep_for(MS(5));
+    }
+    EXPECT_TRUE(is_shed);
+    EXPECT_TRUE(admission.IsOverload());
+    EXPECT_GE(admission.GetShedConnects(), 1u);
+    stop = true;
+    producer.join();
+
+    // 队列排空后恢复接受连接
+    bool is_admit = false;
+    for (int i = 0; i < 100 && !is_admit; ++i) {
+        std::this_thread::sleep_for(MS(10));
+        is_admit = admission.AdmitConnect();
+    }
+    EXPECT_TRUE(is_admit);
+    EXPECT_FALSE(admission.IsOverload());
+}
+
+TEST(AdmissionTest, RejectSends503) {
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ThreadPool pool(1, 4);
+    AdmissionController admission(&pool);
+
+    admission.Reject(sv[0], false);
+    EXPECT_EQ(admission.GetShedRequests(), 1u);
+    close(sv[0]);
+
+    char buf[256];
+    std::string resp;
+    ssize_t len;
+    while ((len = read(sv[1], buf, sizeof(buf))) > 0) resp.append(buf, len);
+    close(sv[1]);
+
+    EXPECT_EQ(resp, SERVICE_UNAVAILABLE);
+    EXPECT_EQ(resp.find("HTTP/1.1 503 Service Unavailable\r\n"), 0u);
+    EXPECT_NE(resp.find("Retry-After: 1\r\n"), std::string::npos);
+    size_t body = resp.find("\r\n\r\n") + 4;
+    EXPECT_EQ(resp.size() - body, 20u);
+}
+
+// 测试请求未读时拒绝并关闭连接，客户端完整收到503而不是RST
+TEST(AdmissionTest, RejectBeforeReadRequest) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listen_fd, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    ASSERT_EQ(bind(listen_fd, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 4), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd, (sockaddr*)&addr, &len);
+
+    int client_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(connect(client_fd, (sockaddr*)&addr, sizeof(addr)), 0);
+    std::string request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    ASSERT_EQ(send(client_fd, request.data(), request.size(), 0), static_cast<ssize_t>(request.size()));
+
+    int fd = accept(listen_fd, nullptr, nullptr);
+    ASSERT_GE(fd, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    ThreadPool pool(1, 4);
+    AdmissionController admission(&pool);
+    admission.Reject(fd, false);
+    close(fd);
+
+    char buf[256];
+    std::string resp;
+    ssize_t cnt;
+    while ((cnt = read(client_fd, buf, sizeof(buf))) > 0) resp.append(buf, cnt);
+    EXPECT_EQ(cnt, 0) << strerror(errno);
+    EXPECT_EQ(resp, SERVICE_UNAVAILABLE);
+    close(client_fd);
+    close(listen_fd);
+}
+
+// 测试不绑定线程池时只拒绝并计数，不拒绝新连接(多Reactor模式)
+TEST(AdmissionTest, WithoutPool) {
+    AdmissionController admission(nullptr, MS(1), MS(1));
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_TRUE(admission.AdmitConnect());
+    EXPECT_FALSE(admission.IsOverload());
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    admission.Reject(sv[0], false);
+    close(sv[0]);
+    char buf[256];
+    std::string resp;
+    ssize_t len;
+    while ((len = read(sv[1], buf, sizeof(buf))) > 0) resp.append(buf, len);
+    close(sv[1]);
+    EXPECT_EQ(resp, SERVICE_UNAVAILABLE);
+    EXPECT_EQ(admission.GetShedRequests(), 1u);
+    EXPECT_EQ(admission.GetShedConnects(), 0u);
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 128, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,156 @@
+/**
+ * @file test_async_sql_pool.cpp
+ * @author chenyinjie
+ * @date 2024-11-05
+ */
+
+#include "../src/pool/async_sql_pool.h"
+
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <condition_variable>
+
+// 等待回调执行的辅助类
+class Waiter {
+public:
+    void Done(bool is_ok) {
+        std::lock_guard<std::mutex> locker(mtx_);
+        results_.push_back(is_ok);
+        cond_.notify_all();
+    }
+
+    bool Wait(size_t cnt, int timeout_ms = 3000) {
+        std::unique_lock<std::mutex> locker(mtx_);
+        return cond_.wait_for(locker, MS(timeout_ms), [&]() { return results_.size() >= cnt; });
+    }
+
+    std::vector<bool> Results() {
+        std::lock_guard<std::mutex> locker(mtx_);
+        return results_;
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::vector<bool> results_;
+};
+
+static bool WaitReady(AsyncSQLPool& pool, int cnt) {
+    for (int i = 0; i < 300 && pool.GetReadyConnectNums() < cnt; ++i) {
+        std::this_thread::sleep_for(MS(10));
+    }
+    return pool.GetReadyConnectNums() == cnt;
+}
+
+// 测试连接建立：连接平均分配到各事件循环
+TEST(AsyncSQLPoolTest, Connect) {
+    AsyncSQLPool pool("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 4, 2);
+    EXPECT_TRUE(WaitReady(pool, 4));
+}
+
+// 测试查询与结果集回调
+TEST(AsyncSQLPoolTest, Query) {
+    AsyncSQLPool pool("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 2);
+    ASSERT_TRUE(WaitReady(pool, 2));
+
+    Waiter waiter;
+    std::string value;
+    ASSERT_TRUE(pool.Submit("SELECT 'chenyinjie'", [&](MYSQL*, MYSQL_RES* res, bool is_ok) {
+        MYSQL_ROW row = (res != nullptr) ? mysql_fetch_row(res) : nullptr;
+        if (row != nullptr && row[0] != nullptr) value = row[0];
+        waiter.Done(is_ok);
+    }));
+    ASSERT_TRUE(waiter.Wait(1));
+    EXPECT_TRUE(waiter.Results()[0]);
+    EXPECT_EQ(value, "chenyinjie");
+}
+
+// 测试大量查询共享少量连接，且出错的查询不影响后续查询
+TEST(AsyncSQLPoolTest, ManyQueries) {
+    AsyncSQLPool pool("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 2);
+    ASSERT_TRUE(WaitReady(pool, 2));
+
+    Waiter waiter;
+    const int N = 100;
+    for (int i = 0; i < N; ++i) {
+        std::string query = (i % 10 == 0) ? "SELECT FROM WHERE" : "SELECT 1";
+        ASSERT_TRUE(pool.Submit(query, [&](MYSQL*, MYSQL_RES*, bool is_ok) { waiter.Done(is_ok); }));
+    }
+    ASSERT_TRUE(waiter.Wait(N));
+    std::vector<bool> results = waiter.Results();
+    EXPECT_EQ(std::count(results.begin(), results.end(), false), N / 10);
+}
+
+// 测试排队查询数达到上限时拒绝提交，析构时未执行的查询以失败回调
+TEST(AsyncSQLPoolTest, QueueFull) {
+    Waiter waiter;
+    int accepted = 0;
+    {
+        AsyncSQLPool pool("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 1, 1, 4);
+        ASSERT_TRUE(WaitReady(pool, 1));
+        bool is_full = false;
+        for (int i = 0; i < 100 && !is_full; ++i) {
+            if (pool.Submit("SELECT SLEEP(0.1)", [&](MYSQL*, MYSQL_RES*, bool is_ok) { waiter.Done(is_ok); })) {
+                ++accepted;
+            } else {
+                is_full = true;
+            }
+        }
+        EXPECT_TRUE(is_full);
+    }
+    EXPECT_EQ(waiter.Results().size(), static_cast<size_t>(accepted));
+}
+
+// 测试执行中的查询超过期限时以失败回调，连接关闭后重连，后续查询不受影响
+TEST(AsyncSQLPoolTest, QueryTimeout) {
+    AsyncSQLPool pool("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 1, 1, 16, 200);
+    ASSERT_TRUE(WaitReady(pool, 1));
+
+    Waiter waiter;
+    auto start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(pool.Submit("SELECT SLEEP(10)", [&](MYSQL*, MYSQL_RES*, bool is_ok) { waiter.Done(is_ok); }));
+    ASSERT_TRUE(waiter.Wait(1, 2000));
+    EXPECT_FALSE(waiter.Results()[0]);
+    EXPECT_GE(std::chrono::steady_clock::now() - start, MS(150));
+    EXPECT_EQ(pool.GetReadyConnectNums(), 0);
+
+    ASSERT_TRUE(WaitReady(pool, 1));
+    ASSERT_TRUE(pool.Submit("SELECT 1", [&](MYSQL*, MYSQL_RES*, bool is_ok) { waiter.Done(is_ok); }));
+    ASSERT_TRUE(waiter.Wait(2));
+    EXPECT_TRUE(waiter.Results()[1]);
+}
+
+// 测试服务器接受TCP连接但从不应答：连接无法建立，排队的查询到期后以失败回调
+TEST(AsyncSQLPoolTest, SilentServer) {
+    int listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listen_fd, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ASSERT_EQ(bind(listen_fd, (sockaddr*)&addr, sizeof(addr)), 0);
+    ASSERT_EQ(listen(listen_fd, 16), 0);
+    socklen_t len = sizeof(addr);
+    getsockname(listen_fd, (sockaddr*)&addr, &len);
+
+    Waiter waiter;
+    {
+        AsyncSQLPool pool("127.0.0.1", "chenyinjie", "MySQL123456.", "WebServer", ntohs(addr.sin_port), 1, 1, 16, 200);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 3; ++i) {
+            ASSERT_TRUE(pool.Submit("SELECT 1", [&](MYSQL*, MYSQL_RES*, bool is_ok) { waiter.Done(is_ok); }));
+        }
+        ASSERT_TRUE(waiter.Wait(3, 2000));
+        EXPECT_GE(std::chrono::steady_clock::now() - start, MS(150));
+        EXPECT_EQ(pool.GetReadyConnectNums(), 0);
+    }
+    std::vector<bool> results = waiter.Results();
+    EXPECT_EQ(std::count(results.begin(), results.end(), false), 3);
+    close(listen_fd);
+}
+
+int main(int argc, char** argv) {
+    Log::GetLogInstance().Init(10, true, 128, 30);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -15,6 +15,12 @@ TEST(TestConfiguration, DefaultConstructor) {
     EXPECT_EQ(config.DB_CONNECT_NUMS, 8);
     EXPECT_EQ(config.THREAD_NUMS, 8);
     EXPECT_EQ(config.ASYNC_MODE, 1);
+    EXPECT_EQ(config.REACTOR_NUMS, 0);
+    EXPECT_EQ(config.TIMER_MODE, 1);
+    EXPECT_EQ(config.DB_THREAD_NUMS, 4);
+    EXPECT_EQ(config.DB_ASYNC, 1);
+    EXPECT_EQ(config.USER_STORE, 0);
+    EXPECT_EQ(config.LOG_LEVEL, 0);
 }
 
 // Test argument parsing
@@ -37,6 +43,92 @@ TEST(TestConfiguration, ParseArgsValid) {
     EXPECT_EQ(config.ASYNC_MODE, 0);
 }
 
+// Test sub reactor argument parsing
+TEST(TestConfiguration, ParseArgsReactor) {
+    char* argv[] = {
+        (char*)"server", 
+        (char*)"-r:4"
+    };
+    int argc = 2;
+    
+    Configuration config;
+    config.ParseArgs(argc, argv);
+
+    EXPECT_EQ(config.REACTOR_NUMS, 4);
+}
+
+// Test timer argument parsing
+TEST(TestConfiguration, ParseArgsTimer) {
+    char* argv[] = {
+        (char*)"server", 
+        (char*)"-w0"
+    };
+    int argc = 2;
+    
+    Configuration config;
+    config.ParseArgs(argc, argv);
+
+    EXPECT_EQ(config.TIMER_MODE, 0);
+}
+
+// Test database executor argument parsing
+TEST(TestConfiguration, ParseArgsDBThreads) {
+    char* argv[] = {
+        (char*)"server", 
+        (char*)"-d", (char*)"2",
+        (char*)"-a0"
+    };
+    int argc = 4;
+    
+    Configuration config;
+    config.ParseArgs(argc, argv);
+
+    EXPECT_EQ(config.DB_THREAD_NUMS, 2);
+    EXPECT_EQ(config.DB_ASYNC, 0);
+}
+
+// Test user store argument parsing
+TEST(TestConfiguration, ParseArgsUserStore) {
+    char* argv[] = {
+        (char*)"server", 
+        (char*)"-s:1"
+    };
+    int argc = 2;
+    
+    Configuration config;
+    config.ParseArgs(argc, argv);
+
+    EXPECT_EQ(config.USER_STORE, 1);
+}
+
+// Test async log overflow mode parsing
+TEST(TestConfiguration, ParseArgsLogOverflow) {
+    char* argv[] = {
+        (char*)"server", 
+        (char*)"-l2"
+    };
+    int argc = 2;
+    
+    Configuration config;
+    config.ParseArgs(argc, argv);
+
+    EXPECT_EQ(config.ASYNC_MODE, 2);
+}
+
+// Test log level parsing
+TEST(TestConfiguration, ParseArgsLogLevel) {
+    char* argv[] = {
+        (char*)"server", 
+        (char*)"-v", (char*)"2"
+    };
+    int argc = 3;
+    
+    Configuration config;
+    config.ParseArgs(argc, argv);
+
+    EXPECT_EQ(config.LOG_LEVEL, 2);
+}
+
 // // Test unknown argument
 // TEST(ConfigurationTest, ParseArgsUnknownOption) {
 //     char* argv[] = {
@@ -8,6 +8,9 @@
 #include "../src/pool/db_connect_pool.h"
 
 #include <gtest/gtest.h>
+#include <cstring>
+#include <thread>
+#include <vector>
 
 // 测试数据库连接池的初始化
 TEST(SQLConnectPoolTest, InitTest) {
@@ -60,9 +63,10 @@ TEST(SQLConnectPoolTest, ExhaustConnectionTest) {
     // 此时空闲连接数应为0
     EXPECT_EQ(pool->GetFreeConnectNums(), 0);
     
-    // 尝试获取第6个连接，应该返回nullptr
-    MYSQL* sql = pool->GetConnection();
+    // 尝试获取第6个连接，等待至截止时间后返回nullptr
+    MYSQL* sql = pool->GetConnection(SQLConnectPool::MS(50));
     EXPECT_EQ(sql, nullptr);
+    EXPECT_EQ(pool->GetCheckoutStats().timeouts, 1u);
 
     pool->CloseConnectPool();
 }
@@ -82,6 +86,107 @@ TEST(SQLConnectPoolTest, ClosePoolTest) {
     EXPECT_EQ(pool->GetFreeConnectNums(), 0);
 }
 
+// 测试等待其他线程归还连接
+TEST(SQLConnectPoolTest, WaitForFreeTest) {
+    SQLConnectPool* pool = SQLConnectPool::GetSQLConnectPoolInstance();
+    pool->Init("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 1);
+
+    MYSQL* sql = pool->GetConnection();
+    ASSERT_NE(sql, nullptr);
+    std::thread releaser([&]() {
+        std::this_thread::sleep_for(SQLConnectPool::MS(50));
+        pool->FreeConnection(sql);
+    });
+
+    // 连接已用尽时等待归还，而不是立即失败
+    MYSQL* other = pool->GetConnection(SQLConnectPool::MS(2000));
+    releaser.join();
+    ASSERT_EQ(other, sql);
+
+    SQLConnectPool::CheckoutStats stats = pool->GetCheckoutStats();
+    EXPECT_EQ(stats.checkouts, 2u);
+    EXPECT_EQ(stats.waits, 1u);
+    EXPECT_EQ(stats.timeouts, 0u);
+    EXPECT_GE(stats.max_wait_us, 40000u);
+
+    pool->FreeConnection(other);
+    pool->CloseConnectPool();
+}
+
+// 测试连接数在下限与上限之间按需增长
+TEST(SQLConnectPoolTest, ElasticGrowTest) {
+    SQLConnectPool* pool = SQLConnectPool::GetSQLConnectPoolInstance();
+    ASSERT_TRUE(pool->Init("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 3, 1));
+    EXPECT_EQ(pool->GetConnectNums(), 1);
+
+    std::vector<MYSQL*> sqls;
+    for (int i = 0; i < 3; ++i) {
+        MYSQL* sql = pool->GetConnection(SQLConnectPool::MS(50));
+        ASSERT_NE(sql, nullptr);
+        sqls.push_back(sql);
+    }
+    EXPECT_EQ(pool->GetConnectNums(), 3);
+    EXPECT_EQ(pool->GetConnection(SQLConnectPool::MS(10)), nullptr);
+
+    for (MYSQL* sql : sqls) {
+        pool->FreeConnection(sql);
+    }
+    EXPECT_EQ(pool->GetFreeConnectNums(), 3);
+
+    // 同一线程归还后再次获取，拿回最近归还的连接
+    MYSQL* sql = pool->GetConnection();
+    EXPECT_EQ(sql, sqls.back());
+    pool->FreeConnection(sql);
+    pool->CloseConnectPool();
+}
+
+// 测试预处理语句缓存：同一连接上相同SQL只预处理一次，不同连接各自缓存
+TEST(SQLConnectPoolTest, StatementCacheTest) {
+    SQLConnectPool* pool = SQLConnectPool::GetSQLConnectPoolInstance();
+    pool->Init("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 2);
+
+    const std::string query = "SELECT password FROM user WHERE username=? LIMIT 1";
+    MYSQL* sql1 = pool->GetConnection();
+    MYSQL* sql2 = pool->GetConnection();
+    ASSERT_NE(sql1, nullptr);
+    ASSERT_NE(sql2, nullptr);
+
+    MYSQL_STMT* stmt = pool->GetStatement(sql1, query);
+    ASSERT_NE(stmt, nullptr);
+    EXPECT_EQ(pool->GetStatement(sql1, query), stmt);
+    EXPECT_EQ(pool->GetStatementNums(sql1), 1u);
+
+    // 重新绑定参数后可重复执行
+    for (const char* name : {"chenyinjie", "nobody"}) {
+        MYSQL_BIND bind[1];
+        memset(bind, 0, sizeof(bind));
+        bind[0].buffer_type = MYSQL_TYPE_STRING;
+        bind[0].buffer = const_cast<char*>(name);
+        bind[0].buffer_length = strlen(name);
+        EXPECT_FALSE(mysql_stmt_bind_param(stmt, bind));
+        EXPECT_EQ(mysql_stmt_execute(stmt), 0);
+        mysql_stmt_free_result(stmt);
+    }
+
+    MYSQL_STMT* other = pool->GetStatement(sql2, query);
+    ASSERT_NE(other, nullptr);
+    EXPECT_NE(other, stmt);
+
+    // 丢弃后重新预处理
+    pool->DiscardStatement(sql1, query);
+    EXPECT_EQ(pool->GetStatementNums(sql1), 0u);
+    EXPECT_NE(pool->GetStatement(sql1, query), nullptr);
+    EXPECT_EQ(pool->GetStatementNums(sql1), 1u);
+
+    // 语法错误的语句不进入缓存
+    EXPECT_EQ(pool->GetStatement(sql1, "SELECT FROM WHERE ?"), nullptr);
+    EXPECT_EQ(pool->GetStatementNums(sql1), 1u);
+
+    pool->FreeConnection(sql1);
+    pool->FreeConnection(sql2);
+    pool->CloseConnectPool();
+}
+
 int main(int argc, char **argv) {
     Log::GetLogInstance().Init(4, true, 16, 30);
 
@@ -0,0 +1,88 @@
+/**
+ * @file test_connect_table.cpp
+ * @author chenyinjie
+ * @date 2024-10-24
+ */
+
+#include "../src/server/connect_table.h"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+
+class ConnectTableTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        addr = {0};
+    }
+
+    void TearDown() override {
+        close(sv[1]);
+    }
+
+    int sv[2];
+    struct sockaddr_in addr;
+    ConnectTable table{65536};
+};
+
+TEST_F(ConnectTableTest, AcquireAndResolve) {
+    EXPECT_EQ(table.Get(sv[0]), nullptr);
+
+    HTTPConnect* client = table.Acquire(sv[0]);
+    ASSERT_NE(client, nullptr);
+    client->Init(sv[0], addr);
+    EXPECT_EQ(table.Get(sv[0]), client);
+
+    uint64_t tag = table.GetTag(client);
+    EXPECT_GE(tag, 65536u);
+    EXPECT_EQ(table.Resolve(tag), client);
+
+    table.Release(client);
+    client->Close();
+}
+
+// 连接关闭后，此前取得的事件数据失效
+TEST_F(ConnectTableTest, StaleAfterRelease) {
+    HTTPConnect* client = table.Acquire(sv[0]);
+    client->Init(sv[0], addr);
+    uint64_t tag = table.GetTag(client);
+
+    table.Release(client);
+    client->Close();
+    EXPECT_EQ(table.Resolve(tag), nullptr);
+}
+
+// fd被新连接复用时，旧连接的事件数据失效，新连接的事件数据有效
+TEST_F(ConnectTableTest, StaleAfterReuse) {
+    int fd = sv[0];
+    HTTPConnect* client = table.Acquire(fd);
+    client->Init(fd, addr);
+    uint64_t old_tag = table.GetTag(client);
+    table.Release(client);
+    client->Close();
+
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    ASSERT_EQ(sv[0], fd);
+    HTTPConnect* reused = table.Acquire(sv[0]);
+    reused->Init(sv[0], addr);
+    EXPECT_EQ(reused, client);
+    EXPECT_EQ(table.Resolve(old_tag), nullptr);
+    EXPECT_EQ(table.Resolve(table.GetTag(reused)), reused);
+
+    table.Release(reused);
+    reused->Close();
+}
+
+TEST_F(ConnectTableTest, OutOfRange) {
+    EXPECT_EQ(table.Acquire(-1), nullptr);
+    EXPECT_EQ(table.Acquire(65536), nullptr);
+    EXPECT_EQ(table.Get(65536), nullptr);
+    close(sv[0]);
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 10, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
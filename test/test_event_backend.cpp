@@ -0,0 +1,189 @@
+/**
+ * @file test_event_backend.cpp
+ * @author chenyinjie
+ * @date 2024-10-22
+ */
+
+#include "../src/epoll/event_backend.h"
+#include "../src/epoll/epoll.h"
+#include "../src/epoll/uring.h"
+
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <chrono>
+
+class EventBackendTest : public ::testing::TestWithParam<EVENT_BACKEND> {
+protected:
+    void SetUp() override {
+        backend = CreateEventBackend(GetParam());
+        event_fd = eventfd(0, EFD_NONBLOCK);
+        ASSERT_GT(event_fd, 0) << "Failed to create eventfd.";
+    }
+
+    void TearDown() override {
+        if (event_fd > 0) {
+            close(event_fd);
+        }
+    }
+
+    void Notify() {
+        uint64_t u = 1;
+        ASSERT_EQ(write(event_fd, &u, sizeof(uint64_t)), sizeof(uint64_t));
+    }
+
+    void Drain() {
+        uint64_t u = 0;
+        while (read(event_fd, &u, sizeof(uint64_t)) > 0) {}
+    }
+
+    std::unique_ptr<EventBackend> backend;
+    int event_fd;
+};
+
+TEST_P(EventBackendTest, WaitReadable) {
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN));
+    Notify();
+
+    int nfds = backend->EpollWait(1000);
+    ASSERT_EQ(nfds, 1);
+    EXPECT_EQ(backend->GetEventFd(0), event_fd);
+    EXPECT_EQ(backend->GetEvents(0) & EPOLLIN, EPOLLIN);
+}
+
+// 注册时绑定的用户数据随事件返回，修改注册时同步更新
+TEST_P(EventBackendTest, EventData) {
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN, 0x1234567890ULL));
+    Notify();
+    ASSERT_EQ(backend->EpollWait(1000), 1);
+    EXPECT_EQ(backend->GetEventData(0), 0x1234567890ULL);
+
+    ASSERT_TRUE(backend->ModifyFd(event_fd, EPOLLIN, 42));
+    ASSERT_EQ(backend->EpollWait(1000), 1);
+    EXPECT_EQ(backend->GetEventData(0), 42u);
+}
+
+TEST_P(EventBackendTest, WaitTimeout) {
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN));
+    EXPECT_LE(backend->EpollWait(50), 0);
+}
+
+// 单次触发的注册在重新修改前不会再次产生事件
+TEST_P(EventBackendTest, OneShotRearm) {
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN | EPOLLONESHOT));
+    Notify();
+    ASSERT_EQ(backend->EpollWait(1000), 1);
+    Drain();
+
+    Notify();
+    EXPECT_LE(backend->EpollWait(50), 0);
+
+    ASSERT_TRUE(backend->ModifyFd(event_fd, EPOLLIN | EPOLLONESHOT));
+    ASSERT_EQ(backend->EpollWait(1000), 1);
+    EXPECT_EQ(backend->GetEventFd(0), event_fd);
+}
+
+// 水平触发模式下未读取的数据会持续产生事件
+TEST_P(EventBackendTest, LevelTriggered) {
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN));
+    Notify();
+    ASSERT_EQ(backend->EpollWait(1000), 1);
+    ASSERT_EQ(backend->EpollWait(1000), 1);
+    Drain();
+    EXPECT_LE(backend->EpollWait(50), 0);
+}
+
+// 删除后不会再收到该描述符的事件
+TEST_P(EventBackendTest, DeleteFd) {
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN | EPOLLET));
+    ASSERT_TRUE(backend->DeleteFd(event_fd));
+    Notify();
+    EXPECT_LE(backend->EpollWait(50), 0);
+}
+
+TEST_P(EventBackendTest, ModifyInvalidFd) {
+    ASSERT_FALSE(backend->DeleteFd(event_fd));
+    ASSERT_FALSE(backend->ModifyFd(event_fd, EPOLLOUT));
+    ASSERT_TRUE(backend->AddFd(event_fd, EPOLLIN));
+    ASSERT_TRUE(backend->DeleteFd(event_fd));
+}
+
+INSTANTIATE_TEST_SUITE_P(Backends, EventBackendTest,
+                         ::testing::Values(EVENT_BACKEND::EPOLL, EVENT_BACKEND::IO_URING));
+
+/**
+ * @brief
+ * 模拟服务器线程池模式下的事件流程：EPOLLONESHOT注册，每次事件读取请求、写回响应后重新注册。
+ * 对比两种后端每个请求的系统调用次数与吞吐量：backend为事件后端自身的调用(epoll_wait/epoll_ctl或io_uring_enter)，
+ * total另计服务端读写数据的read/write调用。io_uring后端只负责就绪通知，数据仍由read/write收发。
+ */
+static void RunPingPong(EVENT_BACKEND type, int conn_nums, int rounds) {
+    std::unique_ptr<EventBackend> backend = CreateEventBackend(type, 1024);
+    std::vector<int> server_fds(conn_nums), client_fds(conn_nums);
+    for (int i = 0; i < conn_nums; ++i) {
+        int sv[2];
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sv), 0);
+        server_fds[i] = sv[0];
+        client_fds[i] = sv[1];
+        ASSERT_TRUE(backend->AddFd(server_fds[i], EPOLLIN | EPOLLRDHUP | EPOLLONESHOT | EPOLLET));
+    }
+
+    char buf[64];
+    uint64_t start_syscalls = backend->GetSyscallCount();
+    uint64_t io_syscalls = 0;
+    auto start = std::chrono::steady_clock::now();
+    long handled = 0;
+    for (int r = 0; r < rounds; ++r) {
+        for (int fd : client_fds) {
+            ASSERT_EQ(write(fd, "ping", 4), 4);
+        }
+        int remain = conn_nums;
+        while (remain > 0) {
+            int n = backend->EpollWait(1000);
+            ASSERT_GT(n, 0);
+            for (int i = 0; i < n; ++i) {
+                int fd = backend->GetEventFd(i);
+                do {
+                    ++io_syscalls;
+                } while (read(fd, buf, sizeof(buf)) > 0);
+                ++io_syscalls;
+                ASSERT_EQ(write(fd, "pong", 4), 4);
+                backend->ModifyFd(fd, EPOLLIN | EPOLLRDHUP | EPOLLONESHOT | EPOLLET);
+                ++handled;
+                --remain;
+            }
+        }
+        for (int fd : client_fds) {
+            while (read(fd, buf, sizeof(buf)) > 0) {}
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    uint64_t syscalls = backend->GetSyscallCount() - start_syscalls;
+
+    std::cout << "[ BENCH    ] " << backend->GetName()
+              << ": connections " << conn_nums
+              << ", requests " << handled
+              << ", syscalls/request backend " << static_cast<double>(syscalls) / handled
+              << " total " << static_cast<double>(syscalls + io_syscalls) / handled
+              << ", throughput " << static_cast<long>(handled / secs) << " req/s" << std::endl;
+
+    for (int i = 0; i < conn_nums; ++i) {
+        backend->DeleteFd(server_fds[i]);
+        close(server_fds[i]);
+        close(client_fds[i]);
+    }
+}
+
+TEST(EventBackendBench, PingPong) {
+    for (int conn_nums : {16, 256}) {
+        RunPingPong(EVENT_BACKEND::EPOLL, conn_nums, 2000);
+        RunPingPong(EVENT_BACKEND::IO_URING, conn_nums, 2000);
+    }
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 10, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
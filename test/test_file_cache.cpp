@@ -0,0 +1,174 @@
+/**
+ * @file test_file_cache.cpp
+ * @author chenyinjie
+ * @date 2024-10-28
+ */
+
+#include "../src/http/file_cache.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <chrono>
+#include <functional>
+
+class FileCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        src_dir_ = std::filesystem::absolute("./test_cache_resources").string();
+        std::filesystem::create_directories(src_dir_ + "/sub");
+        WriteFile("/index.html", "<html>index</html>");
+        WriteFile("/sub/page.css", "body {}");
+        ASSERT_TRUE(cache.Init(src_dir_, 64, 1 << 20, 4));
+    }
+
+    void TearDown() override {
+        cache.Close();
+        std::filesystem::remove_all(src_dir_);
+    }
+
+    void WriteFile(const std::string& path, const std::string& content) {
+        std::ofstream out(src_dir_ + path, std::ios::trunc);
+        out << content;
+    }
+
+    static std::string ReadEntry(const std::shared_ptr<const FileEntry>& entry) {
+        std::string content(entry->st.st_size, '\0');
+        EXPECT_EQ(pread(entry->fd, content.data(), content.size(), 0), entry->st.st_size);
+        return content;
+    }
+
+    // 等待inotify事件被监听线程处理
+    bool WaitUntil(const std::function<bool()>& pred) {
+        for (int i = 0; i < 200; ++i) {
+            if (pred()) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        return false;
+    }
+
+    std::string src_dir_;
+    FileCache& cache = FileCache::GetFileCacheInstance();
+};
+
+TEST_F(FileCacheTest, HitAndMiss) {
+    size_t miss = cache.GetMissCount();
+    size_t hit = cache.GetHitCount();
+
+    auto entry = cache.Get(src_dir_ + "/index.html");
+    ASSERT_TRUE(entry->is_exist);
+    ASSERT_GE(entry->fd, 0);
+    EXPECT_EQ(ReadEntry(entry), "<html>index</html>");
+    EXPECT_EQ(entry->mime, "text/html");
+    EXPECT_EQ(entry->header, "Content-Type: text/html\r\nContent-Length: 18\r\n");
+
+    EXPECT_EQ(cache.Get(src_dir_ + "/index.html"), entry);
+    EXPECT_EQ(cache.GetMissCount(), miss + 1);
+    EXPECT_EQ(cache.GetHitCount(), hit + 1);
+}
+
+TEST_F(FileCacheTest, NegativeEntry) {
+    std::string path = src_dir_ + "/missing.html";
+    auto entry = cache.Get(path);
+    EXPECT_FALSE(entry->is_exist);
+    EXPECT_EQ(cache.Get(path), entry);
+
+    // 新建文件后否定缓存项失效
+    WriteFile("/missing.html", "found");
+    ASSERT_TRUE(WaitUntil([&] { return cache.Get(path)->is_exist; }));
+}
+
+TEST_F(FileCacheTest, InvalidateOnModify) {
+    std::string path = src_dir_ + "/sub/page.css";
+    auto old_entry = cache.Get(path);
+    ASSERT_EQ(old_entry->st.st_size, 7);
+
+    // 以重命名方式原子替换文件
+    WriteFile("/sub/page.css.tmp", "body { color: red; }");
+    std::filesystem::rename(path + ".tmp", path);
+    ASSERT_TRUE(WaitUntil([&] { return cache.Get(path)->st.st_size == 20; }));
+
+    // 失效后仍被持有的旧缓存项保持可用
+    EXPECT_EQ(ReadEntry(old_entry), "body {}");
+}
+
+TEST_F(FileCacheTest, DotSegmentPath) {
+    std::string path = src_dir_ + "/index.html";
+    std::string dot_path = src_dir_ + "/sub/../index.html";
+    std::string slash_path = src_dir_ + "//index.html";
+    auto entry = cache.Get(dot_path);
+    ASSERT_EQ(entry->st.st_size, 18);
+    // 不同写法命中同一缓存项
+    EXPECT_EQ(cache.Get(path), entry);
+    EXPECT_EQ(cache.Get(slash_path), entry);
+
+    WriteFile("/index.html.tmp", "<html>new index</html>");
+    std::filesystem::rename(path + ".tmp", path);
+    ASSERT_TRUE(WaitUntil([&] { return cache.Get(dot_path)->st.st_size == 22; }));
+    EXPECT_EQ(cache.Get(slash_path)->st.st_size, 22);
+}
+
+TEST_F(FileCacheTest, InvalidateOnDelete) {
+    std::string path = src_dir_ + "/index.html";
+    ASSERT_TRUE(cache.Get(path)->is_exist);
+    std::filesystem::remove(path);
+    ASSERT_TRUE(WaitUntil([&] { return !cache.Get(path)->is_exist; }));
+}
+
+TEST_F(FileCacheTest, WatchNewDirectory) {
+    std::string path = src_dir_ + "/new/a.txt";
+    EXPECT_FALSE(cache.Get(path)->is_exist);
+
+    std::filesystem::create_directories(src_dir_ + "/new");
+    WriteFile("/new/a.txt", "a");
+    ASSERT_TRUE(WaitUntil([&] { return cache.Get(path)->is_exist; }));
+
+    // 新目录已加入监听
+    auto entry = cache.Get(path);
+    WriteFile("/new/a.txt", "abc");
+    ASSERT_TRUE(WaitUntil([&] { return cache.Get(path)->st.st_size == 3; }));
+}
+
+TEST_F(FileCacheTest, EvictBound) {
+    for (int i = 0; i < 100; ++i) {
+        WriteFile("/f" + std::to_string(i) + ".txt", "x");
+    }
+    size_t miss = cache.GetMissCount();
+    for (int i = 0; i < 100; ++i) {
+        cache.Get(src_dir_ + "/f" + std::to_string(i) + ".txt");
+    }
+    EXPECT_EQ(cache.GetMissCount(), miss + 100);
+
+    // 每个分片最多16项，最早访问的文件已被淘汰
+    miss = cache.GetMissCount();
+    for (int i = 0; i < 100; ++i) {
+        cache.Get(src_dir_ + "/f" + std::to_string(i) + ".txt");
+    }
+    EXPECT_GT(cache.GetMissCount(), miss);
+}
+
+TEST_F(FileCacheTest, Benchmark) {
+    const int rounds = 200000;
+    std::string path = src_dir_ + "/index.html";
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        ASSERT_TRUE(FileCache::Load(path)->is_exist);
+    }
+    double uncached = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        ASSERT_TRUE(cache.Get(path)->is_exist);
+    }
+    double cached = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("stat+open: %.0f ops/s, cache: %.0f ops/s\n", rounds / uncached, rounds / cached);
+    EXPECT_LT(cached, uncached);
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 10, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,400 @@
+/**
+ * @file test_http_connect.cpp
+ * @author chenyinjie
+ * @date 2024-10-29
+ */
+
+#include "../src/http/http_connect.h"
+#include "../src/server/admission.h"
+
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+
+class HTTPConnectTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        src_dir_ = std::filesystem::absolute("./test_connect_resources");
+        std::filesystem::create_directories(src_dir_);
+        content_.resize(1 << 20);
+        for (size_t i = 0; i < content_.size(); ++i) {
+            content_[i] = static_cast<char>('a' + i % 26);
+        }
+        std::ofstream out(src_dir_ / "big.txt", std::ios::binary);
+        out << content_;
+        out.close();
+
+        HTTPConnect::src_dir = src_dir_;
+        HTTPConnect::is_ET = false;
+        ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+        // 缩小发送缓冲区，使实体需要多次写入
+        int sndbuf = 4096;
+        setsockopt(sv[0], SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf));
+        fcntl(sv[0], F_SETFL, fcntl(sv[0], F_GETFL) | O_NONBLOCK);
+        fcntl(sv[1], F_SETFL, fcntl(sv[1], F_GETFL) | O_NONBLOCK);
+        addr = {0};
+    }
+
+    void TearDown() override {
+        client.Close();
+        close(sv[1]);
+        std::filesystem::remove_all(src_dir_);
+    }
+
+    // 读出对端当前可读的全部数据
+    void Drain(std::string& recv) {
+        char buf[65536];
+        ssize_t len;
+        while ((len = read(sv[1], buf, sizeof(buf))) > 0) {
+            recv.append(buf, len);
+        }
+    }
+
+    std::filesystem::path src_dir_;
+    std::string content_;
+    int sv[2];
+    struct sockaddr_in addr;
+    HTTPConnect client;
+};
+
+TEST_F(HTTPConnectTest, SendfileResume) {
+    client.Init(sv[0], addr);
+    std::string request = "GET /big.txt HTTP/1.1\r\nConnection: keep-alive\r\n\r\n";
+    ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    int save_errno = 0;
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+    // 缓冲区中只有首部，实体不拷贝到用户态
+    EXPECT_LT(client.GetWriteBuffer().ReadableLen(), 512u);
+    EXPECT_EQ(client.ToWriteBytes(), client.GetWriteBuffer().ReadableLen() + content_.size());
+
+    std::string recv;
+    int writes = 0;
+    while (client.ToWriteBytes() > 0) {
+        save_errno = 0;
+        ssize_t len = client.Write(&save_errno);
+        ASSERT_TRUE(len > 0 || save_errno == EAGAIN) << "errno: " << save_errno;
+        Drain(recv);
+        ++writes;
+    }
+    Drain(recv);
+    EXPECT_GT(writes, 1);
+
+    size_t header_end = recv.find("\r\n\r\n");
+    ASSERT_NE(header_end, std::string::npos);
+    std::string header = recv.substr(0, header_end);
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: " + std::to_string(content_.size())), std::string::npos);
+    EXPECT_TRUE(recv.compare(header_end + 4, std::string::npos, content_) == 0);
+    EXPECT_EQ(recv.size(), header_end + 4 + content_.size());
+}
+
+TEST_F(HTTPConnectTest, MultiRange) {
+    client.Init(sv[0], addr);
+    std::string request = "GET /big.txt HTTP/1.1\r\nConnection: keep-alive\r\nRange: bytes=100-199, 500000-\r\n\r\n";
+    ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    int save_errno = 0;
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+
+    std::string recv;
+    while (client.ToWriteBytes() > 0) {
+        save_errno = 0;
+        ssize_t len = client.Write(&save_errno);
+        ASSERT_TRUE(len > 0 || save_errno == EAGAIN) << "errno: " << save_errno;
+        Drain(recv);
+    }
+    Drain(recv);
+
+    size_t header_end = recv.find("\r\n\r\n");
+    ASSERT_NE(header_end, std::string::npos);
+    std::string header = recv.substr(0, header_end);
+    EXPECT_NE(header.find("HTTP/1.1 206 Partial Content"), std::string::npos);
+    size_t pos = header.find("boundary=");
+    ASSERT_NE(pos, std::string::npos);
+    std::string boundary = header.substr(pos + 9, 16);
+
+    std::string body = recv.substr(header_end + 4);
+    size_t len_pos = header.find("Content-Length: ");
+    ASSERT_NE(len_pos, std::string::npos);
+    EXPECT_EQ(std::stoul(header.substr(len_pos + 16)), body.size());
+
+    std::string expect = "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 100-199/1048576\r\n\r\n"
+                       + content_.substr(100, 100)
+                       + "\r\n--" + boundary + "\r\nContent-Type: text/plain\r\nContent-Range: bytes 500000-1048575/1048576\r\n\r\n"
+                       + content_.substr(500000)
+                       + "\r\n--" + boundary + "--\r\n";
+    EXPECT_TRUE(body == expect);
+}
+
+TEST_F(HTTPConnectTest, ErrorResponseSingleCopy) {
+    client.Init(sv[0], addr);
+    std::string request = "GET /missing.html HTTP/1.1\r\n\r\n";
+    ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    int save_errno = 0;
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+    size_t len = client.GetWriteBuffer().ReadableLen();
+    EXPECT_EQ(client.ToWriteBytes(), len);
+    client.Write(&save_errno);
+    EXPECT_EQ(client.ToWriteBytes(), 0u);
+
+    std::string recv;
+    Drain(recv);
+    EXPECT_EQ(recv.size(), len);
+    EXPECT_EQ(recv.find("HTTP/1.1 404 Not Found"), 0u);
+}
+
+TEST_F(HTTPConnectTest, Pipeline) {
+    std::ofstream(src_dir_ / "small.txt") << "hello";
+    client.Init(sv[0], addr);
+    // 一次写入三个请求与一个不完整的请求
+    std::string request = "GET /big.txt HTTP/1.1\r\n\r\n"
+                          "GET /small.txt HTTP/1.1\r\n\r\n"
+                          "GET /missing.html HTTP/1.1\r\n\r\n"
+                          "GET /small.txt HTTP/1.1\r\nHost: ";
+    ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    int save_errno = 0;
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+    EXPECT_TRUE(client.IsKeepAlive());
+
+    std::string recv;
+    while (client.ToWriteBytes() > 0) {
+        save_errno = 0;
+        ssize_t len = client.Write(&save_errno);
+        ASSERT_TRUE(len > 0 || save_errno == EAGAIN) << "errno: " << save_errno;
+        Drain(recv);
+    }
+    Drain(recv);
+
+    // 响应按请求顺序到达
+    size_t pos = recv.find("\r\n\r\n");
+    ASSERT_NE(pos, std::string::npos);
+    EXPECT_EQ(recv.find("HTTP/1.1 200 OK"), 0u);
+    EXPECT_TRUE(recv.compare(pos + 4, content_.size(), content_) == 0);
+    pos += 4 + content_.size();
+    ASSERT_EQ(recv.find("HTTP/1.1 200 OK", pos), pos);
+    size_t body = recv.find("\r\n\r\n", pos);
+    ASSERT_NE(body, std::string::npos);
+    EXPECT_NE(recv.substr(pos, body - pos).find("Content-Length: 5"), std::string::npos);
+    EXPECT_EQ(recv.substr(body + 4, 5), "hello");
+    pos = body + 9;
+    EXPECT_EQ(recv.find("HTTP/1.1 404 Not Found", pos), pos);
+
+    // 不完整的请求保留解析状态，新数据到达后继续处理
+    EXPECT_FALSE(client.Process());
+    std::string rest = "localhost\r\n\r\n";
+    ASSERT_EQ(write(sv[1], rest.data(), rest.size()), static_cast<ssize_t>(rest.size()));
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+    client.Write(&save_errno);
+    EXPECT_EQ(client.ToWriteBytes(), 0u);
+    recv.clear();
+    Drain(recv);
+    EXPECT_EQ(recv.find("HTTP/1.1 200 OK"), 0u);
+    EXPECT_EQ(recv.substr(recv.size() - 5), "hello");
+}
+
+TEST_F(HTTPConnectTest, PipelineClose) {
+    std::ofstream(src_dir_ / "small.txt") << "hello";
+    client.Init(sv[0], addr);
+    // Connection: close之后的请求不再处理
+    std::string request = "GET /small.txt HTTP/1.1\r\n\r\n"
+                          "GET /small.txt HTTP/1.1\r\nConnection: close\r\n\r\n"
+                          "GET /small.txt HTTP/1.1\r\n\r\n";
+    ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    int save_errno = 0;
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+    EXPECT_FALSE(client.IsKeepAlive());
+    client.Write(&save_errno);
+    EXPECT_EQ(client.ToWriteBytes(), 0u);
+
+    std::string recv;
+    Drain(recv);
+    size_t cnt = 0;
+    for (size_t pos = recv.find("HTTP/1.1 200 OK"); pos != std::string::npos; pos = recv.find("HTTP/1.1 200 OK", pos + 1)) {
+        ++cnt;
+    }
+    EXPECT_EQ(cnt, 2u);
+    EXPECT_NE(recv.find("Connection: close"), std::string::npos);
+}
+
+TEST_F(HTTPConnectTest, DBRequestPending) {
+    std::ofstream(src_dir_ / "small.txt") << "hello";
+    std::ofstream(src_dir_ / "error.html") << "error";
+    client.Init(sv[0], addr);
+    // 登录请求之后的流水线请求等待其响应排队后再处理
+    std::string body = "username=&password=";
+    std::string request = "GET /small.txt HTTP/1.1\r\n\r\n"
+                          "POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                          "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body +
+                          "GET /small.txt HTTP/1.1\r\n\r\n";
+    ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+
+    int save_errno = 0;
+    ASSERT_GT(client.Read(&save_errno), 0);
+    ASSERT_TRUE(client.Process());
+    EXPECT_TRUE(client.IsDBPending());
+    // 数据库请求完成前再次调用不会越过它
+    ASSERT_TRUE(client.Process());
+    EXPECT_TRUE(client.IsDBPending());
+
+    client.ProcessDB();
+    EXPECT_FALSE(client.IsDBPending());
+    ASSERT_TRUE(client.Process());
+    EXPECT_FALSE(client.IsDBPending());
+    while (client.ToWriteBytes() > 0) {
+        ASSERT_TRUE(client.Write(&save_errno) > 0 || save_errno == EAGAIN);
+    }
+
+    std::string recv;
+    Drain(recv);
+    size_t first = recv.find("hello");
+    size_t second = recv.find("error");
+    size_t third = recv.find("hello", first + 1);
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(second, std::string::npos);
+    ASSERT_NE(third, std::string::npos);
+    EXPECT_LT(first, second);
+    EXPECT_LT(second, third);
+}
+
+// 测试登录成功后签发会话，携带会话的登录请求不再访问数据库
+TEST_F(HTTPConnectTest, SessionCookie) {
+    std::ofstream(src_dir_ / "welcome.html") << "welcome";
+    SessionStore sessions;
+    HTTPConnect::session_store = &sessions;
+    client.Init(sv[0], addr);
+
+    auto send_request = [&](const std::string& request) {
+        ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+        int save_errno = 0;
+        ASSERT_GT(client.Read(&save_errno), 0);
+    };
+    auto flush = [&]() {
+        int save_errno = 0;
+        while (client.ToWriteBytes() > 0) {
+            if (client.Write(&save_errno) <= 0 && save_errno != EAGAIN) break;
+        }
+        std::string recv;
+        Drain(recv);
+        return recv;
+    };
+    auto login = [](const std::string& body, const std::string& cookie) {
+        return "POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n" + cookie +
+               "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    };
+
+    // 登录成功，响应中签发会话
+    send_request(login("username=amy&password=123", ""));
+    EXPECT_FALSE(client.Process());
+    ASSERT_TRUE(client.IsDBPending());
+    client.FinishDB(true);
+    std::string recv = flush();
+    size_t pos = recv.find("Set-Cookie: sid=");
+    ASSERT_NE(pos, std::string::npos);
+    std::string sid = recv.substr(pos + 16, 32);
+    EXPECT_EQ(sessions.Size(), 1u);
+    std::string cookie = "Cookie: theme=dark; sid=" + sid + "\r\n";
+
+    // 携带会话访问登录页与提交登录，直接返回欢迎页
+    send_request("GET /login HTTP/1.1\r\n" + cookie + "\r\n");
+    ASSERT_TRUE(client.Process());
+    EXPECT_FALSE(client.IsDBPending());
+    recv = flush();
+    EXPECT_NE(recv.find("welcome"), std::string::npos);
+    EXPECT_EQ(recv.find("Set-Cookie"), std::string::npos);
+
+    send_request(login("username=amy&password=123", cookie));
+    ASSERT_TRUE(client.Process());
+    EXPECT_FALSE(client.IsDBPending());
+    EXPECT_NE(flush().find("welcome"), std::string::npos);
+
+    // 以其他用户登录、会话无效或验证失败时仍需访问数据库，且不签发会话
+    send_request(login("username=bob&password=123", cookie));
+    client.Process();
+    EXPECT_TRUE(client.IsDBPending());
+    client.FinishDB(false);
+    EXPECT_EQ(flush().find("Set-Cookie"), std::string::npos);
+
+    send_request(login("username=amy&password=123", "Cookie: sid=" + std::string(32, '0') + "\r\n"));
+    client.Process();
+    EXPECT_TRUE(client.IsDBPending());
+    client.FinishDB(true);
+    flush();
+    EXPECT_EQ(sessions.Size(), 2u);
+    HTTPConnect::session_store = nullptr;
+}
+
+// 测试异步验证完成时I/O线程池已满：只记录了结果、响应尚未生成，客户端收到503；线程池有空位时由I/O线程生成欢迎页
+TEST_F(HTTPConnectTest, DBDoneWhenPoolFull) {
+    std::ofstream(src_dir_ / "welcome.html") << "welcome";
+    std::string body = "username=amy&password=123";
+    std::string request = "POST /login HTTP/1.1\r\nContent-Type: application/x-www-form-urlencoded\r\n"
+                          "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+    auto verify = [&]() {
+        ASSERT_EQ(write(sv[1], request.data(), request.size()), static_cast<ssize_t>(request.size()));
+        int save_errno = 0;
+        ASSERT_GT(client.Read(&save_errno), 0);
+        EXPECT_FALSE(client.Process());
+        ASSERT_TRUE(client.IsDBPending());
+        // 数据库事件循环中的回调
+        client.SetDBResult(true);
+        EXPECT_FALSE(client.IsDBPending());
+        EXPECT_EQ(client.ToWriteBytes(), 0u);
+    };
+
+    // 唯一的工作线程被占用且队列已满
+    ThreadPool pool(1, 1);
+    AdmissionController admission(&pool);
+    std::atomic<bool> release{false};
+    auto block = [&release]() { while (!release) std::this_thread::sleep_for(MS(1)); };
+    ASSERT_TRUE(pool.AddTask(block));
+    std::this_thread::sleep_for(MS(20));
+    ASSERT_TRUE(pool.AddTask(block, MS(0)));
+
+    client.Init(sv[0], addr);
+    verify();
+    auto finish = [this]() {
+        client.FinishDB();
+        int save_errno = 0;
+        while (client.ToWriteBytes() > 0) {
+            if (client.Write(&save_errno) <= 0 && save_errno != EAGAIN) break;
+        }
+    };
+    ASSERT_FALSE(pool.AddTask(finish, MS(0)));
+    admission.Reject(client.GetFd(), false);
+    std::string recv;
+    Drain(recv);
+    EXPECT_EQ(recv, SERVICE_UNAVAILABLE);
+    client.Close();
+
+    // 重新建立连接，线程池空闲后完成响应
+    release = true;
+    close(sv[1]);
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+    fcntl(sv[1], F_SETFL, fcntl(sv[1], F_GETFL) | O_NONBLOCK);
+    client.Init(sv[0], addr);
+    verify();
+    std::atomic<bool> is_done{false};
+    ASSERT_TRUE(pool.AddTask([&]() { finish(); is_done = true; }));
+    while (!is_done) std::this_thread::sleep_for(MS(1));
+    recv.clear();
+    Drain(recv);
+    EXPECT_EQ(recv.find("HTTP/1.1 200 OK\r\n"), 0u);
+    EXPECT_NE(recv.find("welcome"), std::string::npos);
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 10, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
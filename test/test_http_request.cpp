@@ -10,8 +10,11 @@
 #include "../src/buffer/buffer.h"
 #include "../src/http/http_request.h"
 #include "../src/pool/db_connect_pool_RAII.h"
+#include "../src/store/mysql_user_store.h"
 
 #include <gtest/gtest.h>
+#include <chrono>
+#include <regex>
 
 
 // 测试HTTPRequest类的构造函数和初始化函数
@@ -36,7 +39,7 @@ TEST(HTTPRequestTest, ParseRequestLine) {
     request.Init();
     Log::GetLogInstance().Init();
 
-    std::string request_line = "GET /index.html HTTP/1.1";
+    std::string request_line = "GET /index.html HTTP/1.1\r\n";
     Buffer buffer;
     buffer.Append(request_line);
     request.Parse(buffer);
@@ -125,6 +128,11 @@ TEST(HTTPRequestTest, PostRequestParsing) {
 
     buffer.Append(http_request);
     EXPECT_TRUE(request.Parse(buffer));
+    EXPECT_TRUE(request.IsDBRequest());
+    EXPECT_EQ(request.GetPath(), "/login.html");
+    MySQLUserStore store;
+    request.VerifyUser(&store);
+    EXPECT_FALSE(request.IsDBRequest());
     EXPECT_EQ(request.GetMethod(), "POST");
     EXPECT_EQ(request.GetPath(), "/welcome.html");
     EXPECT_EQ(request.GetVersion(), "1.1");
@@ -132,6 +140,239 @@ TEST(HTTPRequestTest, PostRequestParsing) {
     EXPECT_EQ(request.GetPost("password"), "123456");
 }
 
+// 测试Cookie首部的解析
+TEST(HTTPRequestTest, Cookie) {
+    HTTPRequest request;
+    Buffer buffer;
+    buffer.Append("GET /login HTTP/1.1\r\nCookie: theme=dark;  sid=0123abcd ; empty=\r\n\r\n");
+    ASSERT_TRUE(request.Parse(buffer));
+    EXPECT_EQ(request.GetCookie("sid"), "0123abcd");
+    EXPECT_EQ(request.GetCookie("theme"), "dark");
+    EXPECT_EQ(request.GetCookie("empty"), "");
+    EXPECT_EQ(request.GetCookie("si"), "");
+    EXPECT_EQ(request.GetCookie("none"), "");
+}
+
+// 测试异步验证取出的用户：用户名原样返回，密码为SHA-256十六进制串，用户名或密码为空时不需要访问数据库
+TEST(HTTPRequestTest, VerifyUser) {
+    Log::GetLogInstance().Init();
+    HTTPRequest request;
+    Buffer buffer;
+    std::string http_request =
+        "POST /login HTTP/1.1\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 25\r\n"
+        "\r\n"
+        "username=a'b&password=123";
+
+    buffer.Append(http_request);
+    EXPECT_TRUE(request.Parse(buffer));
+    EXPECT_TRUE(request.IsDBRequest());
+    std::string name, hashed_pwd;
+    bool is_login = false;
+    EXPECT_TRUE(request.GetVerifyUser(&name, &hashed_pwd, &is_login));
+    EXPECT_EQ(name, "a'b");
+    EXPECT_EQ(hashed_pwd, "a665a45920422f9d417e4867efdc4fb8a04a1f3fff1fa07e998e86f7f7a27ae3");
+    EXPECT_TRUE(is_login);
+
+    // 验证失败时返回错误页面
+    request.SetVerifyResult(false);
+    EXPECT_FALSE(request.IsDBRequest());
+    EXPECT_EQ(request.GetPath(), "/error.html");
+
+    request.Init();
+    http_request =
+        "POST /register HTTP/1.1\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 19\r\n"
+        "\r\n"
+        "username=&password=";
+    buffer.Append(http_request);
+    EXPECT_TRUE(request.Parse(buffer));
+    EXPECT_TRUE(request.IsDBRequest());
+    EXPECT_FALSE(request.GetVerifyUser(&name, &hashed_pwd, &is_login));
+
+    request.Init();
+    http_request =
+        "POST /register HTTP/1.1\r\n"
+        "Content-Type: application/x-www-form-urlencoded\r\n"
+        "Content-Length: 22\r\n"
+        "\r\n"
+        "username=ab&password=1";
+    buffer.Append(http_request);
+    EXPECT_TRUE(request.Parse(buffer));
+    EXPECT_TRUE(request.GetVerifyUser(&name, &hashed_pwd, &is_login));
+    EXPECT_EQ(name, "ab");
+    EXPECT_FALSE(is_login);
+    request.SetVerifyResult(true);
+    EXPECT_EQ(request.GetPath(), "/welcome.html");
+}
+
+// 测试请求被拆分为多次读取时的增量解析
+TEST(HTTPRequestTest, IncrementalParsing) {
+    Log::GetLogInstance().Init();
+    std::string http_request =
+        "GET /picture HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+
+    // 逐字节追加，覆盖"\r\n"被拆开等所有切分位置
+    HTTPRequest request;
+    Buffer buffer;
+    for (size_t i = 0; i < http_request.size(); ++i) {
+        EXPECT_FALSE(request.IsFinish());
+        buffer.Append(http_request.data() + i, 1);
+        ASSERT_TRUE(request.Parse(buffer));
+    }
+    EXPECT_TRUE(request.IsFinish());
+    EXPECT_EQ(request.GetMethod(), "GET");
+    EXPECT_EQ(request.GetPath(), "/picture.html");
+    EXPECT_EQ(request.GetHeader("host"), "www.example.com");
+    EXPECT_TRUE(request.IsKeepAlive());
+    EXPECT_EQ(buffer.ReadableLen(), 0u);
+}
+
+// 请求体在Content-Length指定的数据全部到达后才解析，后续请求的数据保留在缓冲区中
+TEST(HTTPRequestTest, BodyWaitsForContentLength) {
+    Log::GetLogInstance().Init();
+    HTTPRequest request;
+    Buffer buffer;
+    buffer.Append("POST /echo HTTP/1.1\r\n"
+                  "Content-Type: text/plain\r\n"
+                  "Content-Length: 10\r\n"
+                  "\r\n"
+                  "hello");
+    ASSERT_TRUE(request.Parse(buffer));
+    EXPECT_FALSE(request.IsFinish());
+
+    buffer.Append("worldGET / HTTP/1.1\r\n");
+    ASSERT_TRUE(request.Parse(buffer));
+    EXPECT_TRUE(request.IsFinish());
+    EXPECT_EQ(buffer.ReadableLen(), strlen("GET / HTTP/1.1\r\n"));
+}
+
+// 格式错误的报文在一次扫描中被拒绝
+TEST(HTTPRequestTest, RejectMalformed) {
+    Log::GetLogInstance().Init();
+    const char* cases[] = {
+        "GET /index.html\r\n\r\n",                             // 缺少协议版本
+        "GET  /index.html HTTP/1.1\r\n\r\n",                   // 多余空格
+        "GET /index.html HTTP/1.1\n\r\n",                       // 缺少'\r'
+        "GET /index.html HTTP/1.x\r\n\r\n",                    // 非法版本号
+        "GET /index.html HTTP/1.1\r\nHost www\r\n\r\n",        // 首部缺少':'
+        "GET /index.html HTTP/1.1\r\nBad Name: x\r\n\r\n",     // 字段名含空格
+        "POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n",       // 非法Content-Length
+    };
+    for (const char* req : cases) {
+        HTTPRequest request;
+        Buffer buffer;
+        buffer.Append(req, strlen(req));
+        EXPECT_FALSE(request.Parse(buffer)) << req;
+        EXPECT_FALSE(request.IsFinish()) << req;
+        EXPECT_FALSE(request.IsKeepAlive()) << req;
+    }
+
+    // 过长的行在数据尚不完整时即被拒绝
+    HTTPRequest request;
+    Buffer buffer;
+    buffer.Append("GET /" + std::string(HTTPRequest::MAX_LINE_LEN, 'a'));
+    EXPECT_FALSE(request.Parse(buffer));
+}
+
+// 表单解码: '+'转为空格，百分号编码解码后不残留十六进制字符
+TEST(HTTPRequestTest, UrlEncodedForm) {
+    Log::GetLogInstance().Init();
+    HTTPRequest request;
+    Buffer buffer;
+    std::string body = "name=chen+yin%41jie&msg=a%3Db%26c&empty=";
+    buffer.Append("POST /echo HTTP/1.1\r\n"
+                  "Content-Type: application/x-www-form-urlencoded\r\n"
+                  "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                  "\r\n" + body);
+    ASSERT_TRUE(request.Parse(buffer));
+    ASSERT_TRUE(request.IsFinish());
+    EXPECT_EQ(request.GetPost("name"), "chen yinAjie");
+    EXPECT_EQ(request.GetPost("msg"), "a=b&c");
+    EXPECT_EQ(request.GetPost("empty"), "");
+    EXPECT_TRUE(request.HasPost("empty"));
+    EXPECT_FALSE(request.HasPost("username"));
+}
+
+/**
+ * @brief 
+ * 原基于std::regex的解析实现，仅用于基准对比
+ */
+static bool RegexParse(Buffer& buffer, std::string& method, std::string& path, std::string& version,
+                       std::unordered_map<std::string, std::string>& headers) {
+    const char CRLF[] = "\r\n";
+    int state = 0;
+    while (buffer.ReadableLen() > 0 && state != 2) {
+        const char* end_of_line = std::search(buffer.ReadPtr(), buffer.WritePtr(), CRLF, CRLF + 2);
+        std::string line(static_cast<const char*>(buffer.ReadPtr()), end_of_line);
+        if (state == 0) {
+            std::regex pattern("^([^ ]*) ([^ ]*) HTTP/([^ ]*)$");
+            std::smatch parse_result;
+            if (!std::regex_match(line, parse_result, pattern)) return false;
+            method = parse_result[1];
+            path = parse_result[2];
+            version = parse_result[3];
+            state = 1;
+        } else {
+            std::regex pattern("^([^:]*): ?(.*)$");
+            std::smatch parse_result;
+            if (std::regex_match(line, parse_result, pattern)) {
+                headers[parse_result[1]] = parse_result[2];
+            }
+            if (buffer.ReadableLen() <= 2) state = 2;
+        }
+        if (end_of_line == buffer.WritePtr()) break;
+        buffer.ReadUntil(end_of_line + 2);
+    }
+    return true;
+}
+
+TEST(HTTPRequestBench, ParserThroughput) {
+    Log::GetLogInstance().Init();
+    const std::string http_request =
+        "GET /images/logo.png HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko)\r\n"
+        "Accept: image/webp,*/*\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "If-Modified-Since: Wed, 21 Oct 2023 07:28:00 GMT\r\n"
+        "\r\n";
+    const int rounds = 2000;
+
+    Buffer buffer;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        std::string method, path, version;
+        std::unordered_map<std::string, std::string> headers;
+        buffer.Append(http_request);
+        ASSERT_TRUE(RegexParse(buffer, method, path, version, headers));
+        buffer.ReadAll();
+    }
+    double regex_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    HTTPRequest request;
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < rounds; ++i) {
+        request.Init();
+        buffer.Append(http_request);
+        ASSERT_TRUE(request.Parse(buffer));
+        ASSERT_TRUE(request.IsFinish());
+    }
+    double sm_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "[ BENCH    ] regex parser: " << static_cast<long>(rounds / regex_secs) << " req/s, "
+              << "state machine parser: " << static_cast<long>(rounds / sm_secs) << " req/s, "
+              << "speedup: " << regex_secs / sm_secs << "x" << std::endl;
+    EXPECT_LT(sm_secs, regex_secs);
+}
+
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
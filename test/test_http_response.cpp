@@ -52,8 +52,11 @@ TEST_F(HTTPResponseTest, Generate200Response) {
     EXPECT_NE(response_str.find("Content-Length: 44"), std::string::npos);
     // 检查Connection
     EXPECT_NE(response_str.find("Connection: keep-alive"), std::string::npos);
-    // 检查实体内容
-    EXPECT_NE(response_str.find("<html><body><h1>Test File</h1></body></html>"), std::string::npos);
+    // 实体不拷贝到缓冲区，由文件描述符发送
+    EXPECT_EQ(response_str.find("<html><body><h1>Test File</h1></body></html>"), std::string::npos);
+    EXPECT_EQ(response_str.substr(response_str.size() - 4), "\r\n\r\n");
+    EXPECT_GE(response.GetFileFd(), 0);
+    EXPECT_EQ(response.GetFileLen(), 44u);
 }
 
 // 测试404 Not Found的响应
@@ -74,6 +77,159 @@ TEST_F(HTTPResponseTest, Generate404Response) {
     EXPECT_NE(response_str.find("Connection: close"), std::string::npos);
     // 检查实体内容中是否包含404信息
     EXPECT_NE(response_str.find("404: Not Found"), std::string::npos);
+    // 只有一个状态行
+    EXPECT_EQ(response_str.find("HTTP/1.1", 1), std::string::npos);
+    EXPECT_EQ(response.GetFileLen(), 0u);
+}
+
+// 规范化后越出资源目录的路径返回400
+TEST_F(HTTPResponseTest, PathOutsideSourceDir) {
+    std::ofstream(src_dir_ + "/400.html") << "400: Bad Request";
+    HTTPResponse response;
+    Buffer buffer;
+    response.Init(src_dir_, "/../test.html", false);
+    response.GenerateResponse(buffer);
+    std::string response_str = buffer.ReadAllToStr();
+    EXPECT_NE(response_str.find("HTTP/1.1 400 Bad Request"), std::string::npos);
+
+    // 目录内的点段路径正常返回
+    HTTPResponse inside;
+    Buffer inside_buffer;
+    inside.Init(src_dir_, "/./sub/../test.html", false);
+    inside.GenerateResponse(inside_buffer);
+    EXPECT_NE(inside_buffer.ReadAllToStr().find("HTTP/1.1 200 OK"), std::string::npos);
+    EXPECT_EQ(inside.GetFileLen(), 44u);
+    remove((src_dir_ + "/400.html").c_str());
+}
+
+// 按Range首部生成响应，返回缓冲区中的首部
+static std::string RangeResponse(HTTPResponse& response, const std::string& src_dir,
+                                 const std::string& range, const std::string& if_range = "") {
+    Buffer buffer;
+    response.Init(src_dir, "/test.html", true, 200);
+    response.SetRange(range, if_range);
+    response.GenerateResponse(buffer);
+    return buffer.ReadAllToStr();
+}
+
+// 测试单个区间
+TEST_F(HTTPResponseTest, SingleRange) {
+    HTTPResponse response;
+    std::string header = RangeResponse(response, src_dir_, "bytes=6-11");
+    EXPECT_NE(header.find("HTTP/1.1 206 Partial Content"), std::string::npos);
+    EXPECT_NE(header.find("Content-Range: bytes 6-11/44"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: 6\r\n"), std::string::npos);
+    ASSERT_EQ(response.GetFileParts().size(), 1u);
+    EXPECT_EQ(response.GetFileParts()[0].offset, 6);
+    EXPECT_EQ(response.GetFileParts()[0].len, 6u);
+
+    // 后缀区间与开放区间
+    header = RangeResponse(response, src_dir_, "bytes=-5");
+    EXPECT_NE(header.find("Content-Range: bytes 39-43/44"), std::string::npos);
+    header = RangeResponse(response, src_dir_, "bytes=40-");
+    EXPECT_NE(header.find("Content-Range: bytes 40-43/44"), std::string::npos);
+    header = RangeResponse(response, src_dir_, "bytes=40-1000");
+    EXPECT_NE(header.find("Content-Range: bytes 40-43/44"), std::string::npos);
+
+    // 重叠区间合并
+    header = RangeResponse(response, src_dir_, "bytes=0-10, 5-20");
+    EXPECT_NE(header.find("Content-Range: bytes 0-20/44"), std::string::npos);
+}
+
+// 测试多个区间
+TEST_F(HTTPResponseTest, MultiRange) {
+    HTTPResponse response;
+    std::string header = RangeResponse(response, src_dir_, "bytes=0-4,10-14");
+    EXPECT_NE(header.find("HTTP/1.1 206 Partial Content"), std::string::npos);
+    size_t pos = header.find("Content-Type: multipart/byteranges; boundary=");
+    ASSERT_NE(pos, std::string::npos);
+    std::string boundary = header.substr(pos + 45, 16);
+
+    const auto& parts = response.GetFileParts();
+    ASSERT_EQ(parts.size(), 3u);
+    size_t body_len = 0;
+    for (const auto& part : parts) {
+        body_len += part.head.size() + part.len;
+    }
+    EXPECT_NE(header.find("Content-Length: " + std::to_string(body_len) + "\r\n"), std::string::npos);
+    EXPECT_NE(parts[0].head.find("--" + boundary + "\r\n"), std::string::npos);
+    EXPECT_NE(parts[0].head.find("Content-Range: bytes 0-4/44"), std::string::npos);
+    EXPECT_NE(parts[1].head.find("Content-Range: bytes 10-14/44"), std::string::npos);
+    EXPECT_EQ(parts[2].head, "\r\n--" + boundary + "--\r\n");
+}
+
+// 测试无法满足的区间与应忽略的Range
+TEST_F(HTTPResponseTest, RangeNotSatisfiable) {
+    HTTPResponse response;
+    std::string header = RangeResponse(response, src_dir_, "bytes=100-200");
+    EXPECT_NE(header.find("HTTP/1.1 416 Range Not Satisfiable"), std::string::npos);
+    EXPECT_NE(header.find("Content-Range: bytes */44"), std::string::npos);
+    EXPECT_TRUE(response.GetFileParts().empty());
+
+    // 格式错误：忽略Range
+    header = RangeResponse(response, src_dir_, "bytes=5-1");
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+    header = RangeResponse(response, src_dir_, "items=0-1");
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+
+    // If-Range与文件修改时间不一致：返回完整文件
+    header = RangeResponse(response, src_dir_, "bytes=0-1", "Mon, 01 Jan 2001 00:00:00 GMT");
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: 44"), std::string::npos);
+
+    struct stat st;
+    stat((src_dir_ + "/test.html").c_str(), &st);
+    header = RangeResponse(response, src_dir_, "bytes=0-1", HTTPResponse::FormatHttpDate(st.st_mtime));
+    EXPECT_NE(header.find("HTTP/1.1 206 Partial Content"), std::string::npos);
+}
+
+// 按条件请求首部生成响应
+static std::string ConditionResponse(HTTPResponse& response, const std::string& src_dir,
+                                     const std::string& if_none_match, const std::string& if_modified_since) {
+    Buffer buffer;
+    response.Init(src_dir, "/test.html", true, 200);
+    response.SetCondition(if_none_match, if_modified_since);
+    response.GenerateResponse(buffer);
+    return buffer.ReadAllToStr();
+}
+
+// 测试ETag、Last-Modified与304
+TEST_F(HTTPResponseTest, ConditionalRequest) {
+    HTTPResponse response;
+    std::string header = ConditionResponse(response, src_dir_, "", "");
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+    size_t pos = header.find("ETag: ");
+    ASSERT_NE(pos, std::string::npos);
+    std::string etag = header.substr(pos + 6, header.find("\r\n", pos) - pos - 6);
+    pos = header.find("Last-Modified: ");
+    ASSERT_NE(pos, std::string::npos);
+    std::string last_modified = header.substr(pos + 15, header.find("\r\n", pos) - pos - 15);
+
+    header = ConditionResponse(response, src_dir_, etag, "");
+    EXPECT_NE(header.find("HTTP/1.1 304 Not Modified"), std::string::npos);
+    EXPECT_NE(header.find("ETag: " + etag), std::string::npos);
+    EXPECT_EQ(header.find("Content-Length"), std::string::npos);
+    EXPECT_TRUE(response.GetFileParts().empty());
+
+    header = ConditionResponse(response, src_dir_, "\"other\", W/" + etag, "");
+    EXPECT_NE(header.find("HTTP/1.1 304 Not Modified"), std::string::npos);
+    header = ConditionResponse(response, src_dir_, "*", "");
+    EXPECT_NE(header.find("HTTP/1.1 304 Not Modified"), std::string::npos);
+
+    // If-None-Match不匹配时忽略If-Modified-Since
+    header = ConditionResponse(response, src_dir_, "\"other\"", last_modified);
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+
+    header = ConditionResponse(response, src_dir_, "", last_modified);
+    EXPECT_NE(header.find("HTTP/1.1 304 Not Modified"), std::string::npos);
+    header = ConditionResponse(response, src_dir_, "", "Mon, 01 Jan 2001 00:00:00 GMT");
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+    header = ConditionResponse(response, src_dir_, "", "invalid date");
+    EXPECT_NE(header.find("HTTP/1.1 200 OK"), std::string::npos);
+
+    // If-Range使用ETag
+    header = RangeResponse(response, src_dir_, "bytes=0-1", etag);
+    EXPECT_NE(header.find("HTTP/1.1 206 Partial Content"), std::string::npos);
 }
 
 int main(int argc, char **argv) {
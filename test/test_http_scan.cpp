@@ -0,0 +1,153 @@
+/**
+ * @file test_http_scan.cpp
+ * @author chenyinjie
+ * @date 2024-10-26
+ */
+
+#include "../src/http/http_scan.h"
+#include "../src/http/http_request.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+using ScanFunc = const char* (*)(const char*, const char*);
+
+static const HTTPScan::KERNEL ALL_KERNELS[] = {HTTPScan::SCALAR, HTTPScan::SSE42, HTTPScan::AVX2};
+
+class HTTPScanTest : public ::testing::TestWithParam<HTTPScan::KERNEL> {
+protected:
+    void SetUp() override {
+        default_kernel = HTTPScan::GetKernel();
+        if (!HTTPScan::SetKernel(GetParam())) {
+            GTEST_SKIP() << "Kernel not supported on this CPU.";
+        }
+    }
+
+    void TearDown() override {
+        HTTPScan::SetKernel(default_kernel);
+    }
+
+    HTTPScan::KERNEL default_kernel;
+};
+
+// 随机输入下与逐字节的参考实现结果一致，覆盖所有起始偏移与尾部长度
+TEST_P(HTTPScanTest, MatchesReference) {
+    struct Case {
+        ScanFunc func;
+        bool (*match)(unsigned char);
+    };
+    const Case cases[] = {
+        {HTTPScan::FindLineEnd, [](unsigned char c) { return c == '\n'; }},
+        {HTTPScan::FindColon, [](unsigned char c) { return c == ':'; }},
+        {HTTPScan::FindFormSpecial, [](unsigned char c) { return c == '%' || c == '+' || c == '&' || c == '='; }},
+        {HTTPScan::FindInvalidValue, [](unsigned char c) { return (c < 0x20 && c != '\t') || c == 0x7f; }},
+    };
+
+    std::mt19937 rng(42);
+    std::vector<char> data(256);
+    for (int round = 0; round < 200; ++round) {
+        for (char& ch : data) {
+            // 以可打印字符为主，偶尔出现目标字符、控制字符与高位字节
+            unsigned r = rng() % 64;
+            ch = static_cast<char>(r < 60 ? 'a' + rng() % 26 : rng() % 256);
+        }
+        for (size_t begin = 0; begin < 40; ++begin) {
+            for (size_t end : {begin, begin + 1, begin + 15, begin + 16, begin + 17, begin + 33, data.size()}) {
+                if (end > data.size()) continue;
+                for (const Case& c : cases) {
+                    const char* expect = data.data() + begin;
+                    while (expect < data.data() + end && !c.match(static_cast<unsigned char>(*expect))) ++expect;
+                    ASSERT_EQ(c.func(data.data() + begin, data.data() + end), expect)
+                        << "kernel " << HTTPScan::GetKernelName() << ", begin " << begin << ", end " << end;
+                }
+            }
+        }
+    }
+}
+
+// 含大Cookie的首部块在各实现下解析结果一致
+TEST_P(HTTPScanTest, ParseLargeHeader) {
+    std::string cookie(3000, 'x');
+    Buffer buffer;
+    buffer.Append("GET /index.html HTTP/1.1\r\nHost: localhost\r\nCookie: " + cookie + "\r\n\r\n");
+    HTTPRequest request;
+    ASSERT_TRUE(request.Parse(buffer));
+    ASSERT_TRUE(request.IsFinish());
+    EXPECT_EQ(request.GetHeader("Cookie"), cookie);
+
+    Buffer bad;
+    bad.Append("GET /index.html HTTP/1.1\r\nCookie: " + cookie + '\x01' + "\r\n\r\n");
+    HTTPRequest bad_request;
+    EXPECT_FALSE(bad_request.Parse(bad));
+}
+
+INSTANTIATE_TEST_SUITE_P(Kernels, HTTPScanTest, ::testing::ValuesIn(ALL_KERNELS));
+
+/**
+ * @brief 
+ * 浏览器常见的2-4KB首部块(含大Cookie)，比较各实现的解析吞吐量
+ */
+TEST(HTTPScanBench, HeaderBlock) {
+    std::string header =
+        "GET /images/logo.png HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/129.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: zh-CN,zh;q=0.9,en;q=0.8\r\n"
+        "Cookie: ";
+    std::mt19937 rng(7);
+    for (int i = 0; i < 48; ++i) {
+        header += "session_" + std::to_string(i) + "=";
+        for (int j = 0; j < 48; ++j) header += static_cast<char>('a' + rng() % 26);
+        header += "; ";
+    }
+    header += "\r\n\r\n";
+    // Cookie值与表单体中特殊字符只出现在末尾
+    std::string cookie = header.substr(header.find("Cookie: ") + 8);
+    cookie.resize(cookie.size() - 4);
+    std::string form = std::string(4000, 'c') + "=1";
+
+    HTTPScan::KERNEL default_kernel = HTTPScan::GetKernel();
+    const int rounds = 20000;
+    for (HTTPScan::KERNEL kernel : ALL_KERNELS) {
+        if (!HTTPScan::SetKernel(kernel)) continue;
+        HTTPRequest request;
+        Buffer buffer;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; ++i) {
+            request.Init();
+            buffer.Append(header);
+            ASSERT_TRUE(request.Parse(buffer));
+            ASSERT_TRUE(request.IsFinish());
+        }
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        // 首部值合法性检查与表单解码的扫描吞吐量
+        const char* begin = cookie.data();
+        const char* end = cookie.data() + cookie.size();
+        size_t hits = 0;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds * 10; ++i) {
+            hits += HTTPScan::FindInvalidValue(begin, end) != end;
+            hits += HTTPScan::FindFormSpecial(form.data(), form.data() + form.size()) != form.data() + form.size();
+        }
+        double scan_secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "[ BENCH    ] " << HTTPScan::GetKernelName() << ": header " << header.size() << " bytes, "
+                  << "parse " << static_cast<long>(rounds / secs) << " req/s, "
+                  << "set scan " << static_cast<long>((cookie.size() + form.size()) * rounds * 10 / scan_secs / (1 << 20))
+                  << " MiB/s (" << hits << " hits)" << std::endl;
+    }
+    HTTPScan::SetKernel(default_kernel);
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 10, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -144,6 +144,70 @@
 
 // TODO : CleanLogs函数待测试
 
+// 测试由源文件路径取得日志模块
+TEST(LogTest, LogModule) {
+    static_assert(GetLogModule("/root/WebServer/src/http/http_connect.cpp") == LOG_MODULE::HTTP);
+    static_assert(GetLogModule("src/server/server.cpp") == LOG_MODULE::SERVER);
+    static_assert(GetLogModule("../src/timer/timer.h") == LOG_MODULE::TIMER);
+    static_assert(GetLogModule("/root/WebServer/src/main.cpp") == LOG_MODULE::OTHER);
+    static_assert(GetLogModule("main.cpp") == LOG_MODULE::OTHER);
+    static_assert(GetLogModule("/main.cpp") == LOG_MODULE::OTHER);
+    EXPECT_EQ(GetLogModule(__FILE__), LOG_MODULE::OTHER);
+}
+
+// 测试全局与模块日志级别，模块单独设置的级别不受全局级别影响
+TEST(LogTest, LogLevel) {
+    Log& logger = Log::GetLogInstance();
+    EXPECT_TRUE(logger.IsEnabled(0, LOG_MODULE::HTTP));
+
+    logger.SetLevel(LOG_LEVEL::WARN);
+    EXPECT_FALSE(logger.IsEnabled(1, LOG_MODULE::HTTP));
+    EXPECT_TRUE(logger.IsEnabled(2, LOG_MODULE::HTTP));
+    EXPECT_TRUE(logger.IsEnabled(3, LOG_MODULE::OTHER));
+
+    logger.SetModuleLevel(LOG_MODULE::HTTP, LOG_LEVEL::DEBUG);
+    EXPECT_TRUE(logger.IsEnabled(0, LOG_MODULE::HTTP));
+    EXPECT_FALSE(logger.IsEnabled(0, LOG_MODULE::SERVER));
+
+    logger.SetLevel(LOG_LEVEL::ERROR);
+    EXPECT_EQ(logger.GetLevel(LOG_MODULE::HTTP), LOG_LEVEL::DEBUG);
+    EXPECT_EQ(logger.GetLevel(LOG_MODULE::SERVER), LOG_LEVEL::ERROR);
+
+    logger.ResetModuleLevel(LOG_MODULE::HTTP);
+    EXPECT_EQ(logger.GetLevel(LOG_MODULE::HTTP), LOG_LEVEL::ERROR);
+    logger.SetLevel(LOG_LEVEL::DEBUG);
+}
+
+// 测试被过滤的日志不求值参数，也不写入文件
+TEST(LogTest, LogLevelFilter) {
+    Log& logger = Log::GetLogInstance();
+    ASSERT_TRUE(logger.Init(1000, false, 128, 30));
+    int cnt = 0;
+    auto count = [&cnt]() { return ++cnt; };
+
+    logger.SetLevel(LOG_LEVEL::WARN);
+    LOG_INFO("Filtered info %d", count());
+    LOG_DEBUG("Filtered debug %d", count());
+    EXPECT_EQ(cnt, 0);
+    LOG_WARN("Level filter warn %d", count());
+    EXPECT_EQ(cnt, 1);
+    logger.SetLevel(LOG_LEVEL::DEBUG);
+    logger.Close();
+
+    bool found_info = false;
+    bool found_warn = false;
+    for (const auto& file : std::filesystem::directory_iterator(std::filesystem::path(PROJECT_ROOT) / "logfiles")) {
+        std::ifstream log_file(file.path());
+        std::string line;
+        while (std::getline(log_file, line)) {
+            found_info = found_info || line.find("Filtered info") != std::string::npos;
+            found_warn = found_warn || line.find("[WARN]: Level filter warn 1") != std::string::npos;
+        }
+    }
+    EXPECT_FALSE(found_info);
+    EXPECT_TRUE(found_warn);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
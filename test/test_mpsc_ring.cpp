@@ -0,0 +1,155 @@
+/**
+ * @file test_mpsc_ring.cpp
+ * @author chenyinjie
+ * @date 2024-11-10
+ */
+
+#include "../src/log/mpsc_ring.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 测试基本的入队出队，容量向上取整为2的幂，队列满时入队失败
+TEST(MPSCRingTest, PushPop) {
+    MPSCRing<int> ring(3);
+    EXPECT_EQ(ring.GetCapacity(), 4u);
+
+    int element = 0;
+    EXPECT_FALSE(ring.TryPop(element));
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(ring.TryPush(i));
+    }
+    EXPECT_FALSE(ring.TryPush(4));
+
+    // 多轮绕环，按入队顺序出队
+    for (int i = 0; i < 100; ++i) {
+        ASSERT_TRUE(ring.TryPop(element));
+        EXPECT_EQ(element, i);
+        EXPECT_TRUE(ring.TryPush(i + 4));
+    }
+    EXPECT_THROW(MPSCRing<int>(0), std::invalid_argument);
+}
+
+// 测试字符串槽位预分配内存，出队交换后槽位保留消费者的缓冲区
+TEST(MPSCRingTest, SlotReserve) {
+    MPSCRing<std::string> ring(2, 256);
+    std::string out;
+    out.reserve(256);
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(ring.TryPush("message " + std::to_string(i)));
+        ASSERT_TRUE(ring.TryPop(out));
+        EXPECT_EQ(out, "message " + std::to_string(i));
+        EXPECT_GE(out.capacity(), 256u);
+    }
+}
+
+// 测试多生产者并发入队，消费者收到全部元素且每个生产者内部有序
+TEST(MPSCRingTest, MultiProducer) {
+    const int PRODUCER_NUMS = 4;
+    const int ITEM_NUMS = 100000;
+    MPSCRing<int> ring(64);
+
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCER_NUMS; ++p) {
+        producers.emplace_back([&, p]() {
+            for (int i = 0; i < ITEM_NUMS; ++i) {
+                ring.PushWait(p * ITEM_NUMS + i);
+            }
+        });
+    }
+
+    std::vector<int> last(PRODUCER_NUMS, -1);
+    int received = 0;
+    bool ordered = true;
+    int element = 0;
+    while (received < PRODUCER_NUMS * ITEM_NUMS) {
+        if (!ring.TryPop(element)) {
+            ring.Wait(std::chrono::milliseconds(10));
+            continue;
+        }
+        int p = element / ITEM_NUMS;
+        if (element % ITEM_NUMS != last[p] + 1) ordered = false;
+        last[p] = element % ITEM_NUMS;
+        ++received;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    EXPECT_TRUE(ordered);
+    EXPECT_FALSE(ring.TryPop(element));
+}
+
+// 测试入队与关闭都能唤醒休眠的消费者，关闭后入队失败
+TEST(MPSCRingTest, WaitAndClose) {
+    MPSCRing<int> ring(4);
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.TryPush(1);
+    });
+    int element = 0;
+    while (!ring.TryPop(element)) {
+        ring.Wait(std::chrono::seconds(5));
+    }
+    producer.join();
+    EXPECT_EQ(element, 1);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+
+    start = std::chrono::steady_clock::now();
+    std::thread closer([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.Close();
+    });
+    ring.Wait(std::chrono::seconds(5));
+    closer.join();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    EXPECT_TRUE(ring.IsClosed());
+    EXPECT_FALSE(ring.TryPush(2));
+    EXPECT_FALSE(ring.PushWait(2));
+}
+
+// 测试消费者攒批等待：可读元素达到min_items前不被唤醒，Wake立即唤醒且只生效一次
+TEST(MPSCRingTest, WaitBatchAndWake) {
+    MPSCRing<int> ring(16);
+    auto start = std::chrono::steady_clock::now();
+    std::thread producer([&]() {
+        for (int i = 0; i < 4; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            ring.TryPush(i);
+        }
+    });
+    // 第4个元素约在80ms后入队，此前的入队不唤醒消费者
+    EXPECT_FALSE(ring.Wait(std::chrono::seconds(5), 4));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(60));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(2));
+    producer.join();
+
+    int element = 0;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(ring.TryPop(element));
+        EXPECT_EQ(element, i);
+    }
+
+    // 未休眠时调用Wake，下一次Wait立即返回true，之后恢复超时等待
+    ring.Wake();
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(ring.Wait(std::chrono::seconds(5), 8));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    EXPECT_FALSE(ring.Wait(std::chrono::milliseconds(20), 8));
+
+    std::thread waker([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        ring.Wake();
+    });
+    start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(ring.Wait(std::chrono::seconds(5), 8));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    waker.join();
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,135 @@
+/**
+ * @file test_precompress.cpp
+ * @author chenyinjie
+ * @date 2024-10-30
+ */
+
+#include "../src/http/precompress.h"
+#include "../src/http/http_response.h"
+
+#include <gtest/gtest.h>
+
+class PrecompressTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        src_dir_ = std::filesystem::absolute("./test_precompress_resources").string();
+        std::filesystem::create_directories(src_dir_);
+        for (int i = 0; i < 200; ++i) {
+            content_ += ".item-" + std::to_string(i) + " { color: red; margin: 0 auto; }\n";
+        }
+        std::ofstream(src_dir_ + "/style.css") << content_;
+        std::ofstream(src_dir_ + "/small.css") << "body {}";
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(src_dir_);
+    }
+
+    std::string Generate(const std::string& path, const std::string& accept_encoding) {
+        Buffer buffer;
+        response_.Init(src_dir_, path, true, 200);
+        response_.SetAcceptEncoding(accept_encoding);
+        response_.GenerateResponse(buffer);
+        return buffer.ReadAllToStr();
+    }
+
+    static std::string ReadFile(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    }
+
+    std::string src_dir_;
+    std::string content_;
+    HTTPResponse response_;
+};
+
+TEST_F(PrecompressTest, Compress) {
+    ASSERT_TRUE(Precompressor::Compress(src_dir_ + "/style.css", Precompressor::GZIP));
+    ASSERT_TRUE(Precompressor::Compress(src_dir_ + "/style.css", Precompressor::ZSTD));
+    // 副本已是最新，不重复生成
+    EXPECT_FALSE(Precompressor::Compress(src_dir_ + "/style.css", Precompressor::GZIP));
+    // 过小的文件与不可压缩类型不生成副本
+    EXPECT_FALSE(Precompressor::Compress(src_dir_ + "/small.css", Precompressor::GZIP));
+    EXPECT_FALSE(Precompressor::Compress(src_dir_ + "/style.css.gz", Precompressor::ZSTD));
+
+    std::string gz = ReadFile(src_dir_ + "/style.css.gz");
+    EXPECT_LT(gz.size(), content_.size() / 2);
+    std::string out(content_.size(), '\0');
+    z_stream stream = {};
+    ASSERT_EQ(inflateInit2(&stream, 15 + 16), Z_OK);
+    stream.next_in = reinterpret_cast<Bytef*>(gz.data());
+    stream.avail_in = gz.size();
+    stream.next_out = reinterpret_cast<Bytef*>(out.data());
+    stream.avail_out = out.size();
+    EXPECT_EQ(inflate(&stream, Z_FINISH), Z_STREAM_END);
+    inflateEnd(&stream);
+    EXPECT_TRUE(out == content_);
+
+    std::string zst = ReadFile(src_dir_ + "/style.css.zst");
+    std::string zout(content_.size(), '\0');
+    EXPECT_EQ(ZSTD_decompress(zout.data(), zout.size(), zst.data(), zst.size()), content_.size());
+    EXPECT_TRUE(zout == content_);
+}
+
+TEST_F(PrecompressTest, Negotiate) {
+    ASSERT_TRUE(Precompressor::Compress(src_dir_ + "/style.css", Precompressor::GZIP));
+    ASSERT_TRUE(Precompressor::Compress(src_dir_ + "/style.css", Precompressor::ZSTD));
+    size_t gz_size = std::filesystem::file_size(src_dir_ + "/style.css.gz");
+    size_t zst_size = std::filesystem::file_size(src_dir_ + "/style.css.zst");
+
+    std::string header = Generate("/style.css", "gzip, deflate, br, zstd");
+    EXPECT_NE(header.find("Content-Encoding: zstd"), std::string::npos);
+    EXPECT_NE(header.find("Content-Type: text/css"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: " + std::to_string(zst_size) + "\r\n"), std::string::npos);
+    EXPECT_NE(header.find("Vary: Accept-Encoding"), std::string::npos);
+    EXPECT_EQ(response_.GetFileLen(), zst_size);
+
+    header = Generate("/style.css", "gzip, zstd;q=0.5");
+    EXPECT_NE(header.find("Content-Encoding: gzip"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: " + std::to_string(gz_size) + "\r\n"), std::string::npos);
+
+    header = Generate("/style.css", "X-GZIP");
+    EXPECT_NE(header.find("Content-Encoding: gzip"), std::string::npos);
+    header = Generate("/style.css", "*;q=0.1, zstd;q=0");
+    EXPECT_NE(header.find("Content-Encoding: gzip"), std::string::npos);
+
+    // 不接受压缩时发送原文件，仍输出Vary
+    header = Generate("/style.css", "");
+    EXPECT_EQ(header.find("Content-Encoding"), std::string::npos);
+    EXPECT_NE(header.find("Vary: Accept-Encoding"), std::string::npos);
+    EXPECT_NE(header.find("Content-Length: " + std::to_string(content_.size()) + "\r\n"), std::string::npos);
+    header = Generate("/style.css", "br, identity");
+    EXPECT_EQ(header.find("Content-Encoding"), std::string::npos);
+
+    // 没有副本的文件
+    header = Generate("/small.css", "gzip");
+    EXPECT_EQ(header.find("Content-Encoding"), std::string::npos);
+    EXPECT_NE(header.find("Vary: Accept-Encoding"), std::string::npos);
+}
+
+TEST_F(PrecompressTest, QValue) {
+    EXPECT_EQ(HTTPResponse::GetQValue("gzip, deflate", "gzip"), 1.0);
+    EXPECT_EQ(HTTPResponse::GetQValue("gzip;q=0.3, deflate", "gzip"), 0.3);
+    EXPECT_EQ(HTTPResponse::GetQValue("deflate", "gzip"), 0.0);
+    EXPECT_EQ(HTTPResponse::GetQValue("*;q=0.2", "zstd"), 0.2);
+    EXPECT_EQ(HTTPResponse::GetQValue("zstd;q=0, *", "zstd"), 0.0);
+}
+
+TEST_F(PrecompressTest, Background) {
+    Precompressor precompressor;
+    precompressor.Start(src_dir_);
+    for (int i = 0; i < 200 && !std::filesystem::exists(src_dir_ + "/style.css.gz"); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    precompressor.Stop();
+    EXPECT_TRUE(std::filesystem::exists(src_dir_ + "/style.css.gz"));
+    EXPECT_TRUE(std::filesystem::exists(src_dir_ + "/style.css.zst"));
+    EXPECT_FALSE(std::filesystem::exists(src_dir_ + "/small.css.gz"));
+}
+
+int main(int argc, char **argv) {
+    Log::GetLogInstance().Init(10, true, 10, 30);
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file test_session_store.cpp
+ * @author chenyinjie
+ * @date 2024-11-09
+ */
+
+#include "../src/store/session_store.h"
+
+#include <gtest/gtest.h>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+// 测试签发与查找会话，非法或不存在的会话ID查找失败
+TEST(SessionStoreTest, CreateAndCheck) {
+    SessionStore store;
+    std::string sid = store.Create("alice");
+    ASSERT_EQ(sid.size(), 32u);
+    EXPECT_EQ(store.Size(), 1u);
+
+    std::string name;
+    EXPECT_TRUE(store.Check(sid, &name));
+    EXPECT_EQ(name, "alice");
+
+    std::string other = sid;
+    other[0] = (other[0] == '0') ? '1' : '0';
+    EXPECT_FALSE(store.Check(other, &name));
+    EXPECT_FALSE(store.Check("", &name));
+    EXPECT_FALSE(store.Check(sid.substr(1), &name));
+    EXPECT_FALSE(store.Check(std::string(32, 'g'), &name));
+    EXPECT_NE(store.Create("alice"), sid);
+
+    EXPECT_EQ(store.GetCookie(sid), "sid=" + sid + "; Max-Age=1800; Path=/; HttpOnly; SameSite=Lax");
+}
+
+// 测试会话到期后查找失败，Expire只清理已到期的会话
+TEST(SessionStoreTest, Expire) {
+    SessionStore store(100, 4);
+    std::string old_sid = store.Create("old");
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    std::string new_sid = store.Create("new");
+    EXPECT_EQ(store.Expire(), 0u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    std::string name;
+    EXPECT_FALSE(store.Check(old_sid, &name));
+    EXPECT_TRUE(store.Check(new_sid, &name));
+    EXPECT_EQ(store.Expire(), 1u);
+    EXPECT_EQ(store.Size(), 1u);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    EXPECT_FALSE(store.Check(new_sid, &name));
+    EXPECT_EQ(store.Expire(), 1u);
+    EXPECT_EQ(store.Size(), 0u);
+}
+
+// 测试分片已满时淘汰最早签发的会话
+TEST(SessionStoreTest, Evict) {
+    SessionStore store(60000, 1, 4);
+    std::vector<std::string> sids;
+    for (int i = 0; i < 6; ++i) {
+        sids.push_back(store.Create("user" + std::to_string(i)));
+    }
+    EXPECT_EQ(store.Size(), 4u);
+    std::string name;
+    EXPECT_FALSE(store.Check(sids[0], &name));
+    EXPECT_FALSE(store.Check(sids[1], &name));
+    for (int i = 2; i < 6; ++i) {
+        EXPECT_TRUE(store.Check(sids[i], &name));
+        EXPECT_EQ(name, "user" + std::to_string(i));
+    }
+}
+
+// 测试多线程并发签发与查找
+TEST(SessionStoreTest, Concurrent) {
+    SessionStore store;
+    const int THREAD_NUMS = 8;
+    const int SESSION_NUMS = 2000;
+    std::vector<std::vector<std::string>> sids(THREAD_NUMS);
+    std::vector<std::thread> threads;
+    std::atomic<int> failed{0};
+    for (int t = 0; t < THREAD_NUMS; ++t) {
+        threads.emplace_back([&, t]() {
+            std::string name;
+            for (int i = 0; i < SESSION_NUMS; ++i) {
+                std::string user = "user" + std::to_string(t);
+                sids[t].push_back(store.Create(user));
+                if (!store.Check(sids[t].back(), &name) || name != user) {
+                    ++failed;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failed.load(), 0);
+    EXPECT_EQ(store.Size(), static_cast<size_t>(THREAD_NUMS * SESSION_NUMS));
+
+    std::unordered_set<std::string> unique;
+    for (auto& list : sids) {
+        unique.insert(list.begin(), list.end());
+    }
+    EXPECT_EQ(unique.size(), static_cast<size_t>(THREAD_NUMS * SESSION_NUMS));
+}
+
+int main(int argc, char** argv) {
+    Log::GetLogInstance().Init(10, true, 128, 30);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
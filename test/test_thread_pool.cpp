@@ -9,6 +9,27 @@
 #include <gtest/gtest.h>
 #include <chrono>
 #include <atomic>
+#include <queue>
+#include <memory>
+#include <cstdlib>
+#include <iostream>
+
+// 统计当前线程的堆分配次数
+static thread_local size_t alloc_cnt = 0;
+
+void* operator new(size_t size) {
+    ++alloc_cnt;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
 
 // Test case for adding a task to the thread pool
 TEST(ThreadPoolTest, AddTask) {
@@ -51,6 +72,177 @@ TEST(ThreadPoolTest, AddTaskTimeout) {
     EXPECT_EQ(counter.load(), 2);
 }
 
+// 工作线程内提交的子任务进入本地队列，由空闲线程窃取执行
+TEST(ThreadPoolTest, NestedTasks) {
+    ThreadPool pool(4, 1024);
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(pool.AddTask([&pool, &counter]() {
+            for (int j = 0; j < 100; ++j) {
+                while (!pool.AddTask([&counter]() { ++counter; })) {}
+            }
+        }));
+    }
+    for (int i = 0; i < 500 && counter.load() < 800; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(counter.load(), 800);
+}
+
+// 多个线程同时提交
+TEST(ThreadPoolTest, MultiProducer) {
+    std::atomic<int> counter{0};
+    {
+        ThreadPool pool(4, 64);
+        std::vector<std::thread> producers;
+        for (int i = 0; i < 4; ++i) {
+            producers.emplace_back([&pool, &counter]() {
+                for (int j = 0; j < 10000; ++j) {
+                    while (!pool.AddTask([&counter]() { ++counter; }, MS(1000))) {}
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+    }
+    // 析构时执行完所有已提交的任务
+    EXPECT_EQ(counter.load(), 40000);
+}
+
+TEST(InplaceTaskTest, MoveAndReset) {
+    auto res = std::make_shared<int>(1);
+    int value = 0;
+    InplaceTask<48> task([res, &value]() { value += *res; });
+    EXPECT_EQ(res.use_count(), 2);
+
+    InplaceTask<48> moved(std::move(task));
+    EXPECT_FALSE(task);
+    EXPECT_TRUE(moved);
+    EXPECT_EQ(res.use_count(), 2);
+    moved();
+    EXPECT_EQ(value, 1);
+
+    task = std::move(moved);
+    task();
+    EXPECT_EQ(value, 2);
+    task.Reset();
+    EXPECT_FALSE(task);
+    EXPECT_EQ(res.use_count(), 1);
+}
+
+struct Handler {
+    std::atomic<int> sum{0};
+    void OnEvent(int* value) { sum += *value; }
+};
+
+// 成员函数快速路径与任务提交均不分配内存
+TEST(ThreadPoolTest, MemberTaskNoAllocation) {
+    ThreadPool pool(2, 1024);
+    Handler handler;
+    int value = 3;
+    std::atomic<int> counter{0};
+
+    alloc_cnt = 0;
+    for (int i = 0; i < 500; ++i) {
+        ASSERT_TRUE(pool.AddTask<&Handler::OnEvent>(&handler, &value));
+        ASSERT_TRUE(pool.AddTask([&counter, &value, &handler]() { counter += value + (&handler != nullptr); }));
+    }
+    EXPECT_EQ(alloc_cnt, 0u);
+
+    for (int i = 0; i < 500 && (handler.sum.load() < 1500 || counter.load() < 2000); ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(handler.sum.load(), 1500);
+    EXPECT_EQ(counter.load(), 2000);
+}
+
+// 原有的单锁线程池，作为性能对比基准
+class MutexThreadPool {
+public:
+    MutexThreadPool(size_t max_thread_nums, size_t max_task_nums): is_stop_(false), max_task_nums_(max_task_nums) {
+        for (size_t i = 0; i < max_thread_nums; ++i) {
+            threads_.emplace_back([this]() {
+                while (true) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> locker(mtx_);
+                        con_var_.wait(locker, [this]() { return !task_queue_.empty() || is_stop_; });
+                        if (is_stop_ && task_queue_.empty()) return;
+                        task = std::move(task_queue_.front());
+                        task_queue_.pop();
+                    }
+                    con_var_.notify_all();
+                    task();
+                }
+            });
+        }
+    }
+
+    ~MutexThreadPool() {
+        {
+            std::lock_guard<std::mutex> locker(mtx_);
+            is_stop_ = true;
+        }
+        con_var_.notify_all();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    template <typename F>
+    bool AddTask(F&& task, MS timeout = MS(100)) {
+        {
+            std::unique_lock<std::mutex> locker(mtx_);
+            if (!con_var_.wait_for(locker, timeout, [this]() { return task_queue_.size() < max_task_nums_; })) {
+                return false;
+            }
+            task_queue_.emplace(std::forward<F>(task));
+        }
+        con_var_.notify_one();
+        return true;
+    }
+
+private:
+    bool is_stop_;
+    size_t max_task_nums_;
+    std::mutex mtx_;
+    std::condition_variable con_var_;
+    std::vector<std::thread> threads_;
+    std::queue<std::function<void()>> task_queue_;
+};
+
+template <typename Pool>
+static double RunTasks(size_t thread_nums, int producer_nums, int task_nums) {
+    std::atomic<int> counter{0};
+    auto start = std::chrono::steady_clock::now();
+    {
+        Pool pool(thread_nums, 1024);
+        std::vector<std::thread> producers;
+        for (int i = 0; i < producer_nums; ++i) {
+            producers.emplace_back([&pool, &counter, producer_nums, task_nums]() {
+                for (int j = 0; j < task_nums / producer_nums; ++j) {
+                    while (!pool.AddTask([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); })) {}
+                }
+            });
+        }
+        for (auto& producer : producers) producer.join();
+        while (counter.load() < task_nums / producer_nums * producer_nums) {
+            std::this_thread::yield();
+        }
+    }
+    return task_nums / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+TEST(ThreadPoolBench, Throughput) {
+    const int task_nums = 200000;
+    for (size_t thread_nums : {4, 16}) {
+        for (int producer_nums : {1, 4}) {
+            double mutex_rate = RunTasks<MutexThreadPool>(thread_nums, producer_nums, task_nums);
+            double steal_rate = RunTasks<ThreadPool>(thread_nums, producer_nums, task_nums);
+            std::cout << "[ BENCH    ] threads " << thread_nums << ", producers " << producer_nums
+                      << ": mutex " << static_cast<long>(mutex_rate) << " tasks/s"
+                      << ", work-stealing " << static_cast<long>(steal_rate) << " tasks/s" << std::endl;
+        }
+    }
+}
+
 int main(int argc, char **argv) {
     Log::GetLogInstance().Init(10, true, 128, 30);
 
@@ -5,10 +5,13 @@
  */
 
 #include "../src/timer/timer.h"
+#include "../src/timer/timer_wheel.h"
 
 #include <gtest/gtest.h>
 #include <thread>
 #include <atomic>
+#include <random>
+#include <iostream>
 
 std::atomic<int> callback_counter(0);
 
@@ -130,6 +133,24 @@ TEST(TimerHeapTest, CallbackExecutionTest) {
     EXPECT_EQ(callback_counter.load(), 2);
 }
 
+TEST(TimerHeapTest, DeleteTimerTest) {
+    TimerHeap timer_heap;
+
+    callback_counter = 0;
+
+    timer_heap.AddTimer(1, 50, TestCallback);
+    timer_heap.AddTimer(2, 100, TestCallback);
+    timer_heap.DeleteTimer(1);
+
+    // 删除后的定时器不会执行回调，id可以被重新使用
+    timer_heap.AddTimer(1, 150, TestCallback);
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    timer_heap.CleanExpiredTimer();
+
+    EXPECT_EQ(callback_counter.load(), 1);
+    EXPECT_GE(timer_heap.GetNextExpireTime(), 0);
+}
+
 TEST(TimerHeapTest, ClearAllTimersTest) {
     TimerHeap timer_heap;
 
@@ -154,6 +175,165 @@ TEST(TimerHeapTest, GetNextExpireTimeTest) {
     EXPECT_GE(next_expire, 0);
 }
 
+TEST(TimerQueueTest, NodeInterface) {
+    for (TIMER_TYPE type : {TIMER_TYPE::HEAP, TIMER_TYPE::WHEEL}) {
+        std::unique_ptr<TimerQueue> timer = CreateTimerQueue(type);
+        TimerNode nodes[3];
+        callback_counter = 0;
+        for (int i = 0; i < 3; ++i) {
+            nodes[i].id = i;
+            nodes[i].callback = TestCallback;
+        }
+        timer->AddTimer(&nodes[0], 50);
+        timer->AddTimer(&nodes[1], 100);
+        timer->AddTimer(&nodes[2], 150);
+        // 重复添加视为重新设置
+        timer->AddTimer(&nodes[2], 300);
+        EXPECT_EQ(timer->Size(), 3u) << timer->GetName();
+        // 时间轮按tick向上取整，最多晚1ms
+        int next_expire = timer->GetNextExpireTime();
+        EXPECT_LE(next_expire, 51) << timer->GetName();
+        EXPECT_GE(next_expire, 45) << timer->GetName();
+
+        timer->DeleteTimer(&nodes[0]);
+        timer->UpdateTimer(&nodes[1], 200);
+        std::this_thread::sleep_for(std::chrono::milliseconds(160));
+        timer->CleanExpiredTimer();
+        EXPECT_EQ(callback_counter.load(), 0) << timer->GetName();
+        EXPECT_EQ(timer->Size(), 2u) << timer->GetName();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(60));
+        timer->CleanExpiredTimer();
+        EXPECT_EQ(callback_counter.load(), 1) << timer->GetName();
+        timer->DeleteTimer(&nodes[2]);
+        EXPECT_EQ(timer->GetNextExpireTime(), -1) << timer->GetName();
+    }
+}
+
+// 跨越各层级联以及超出时间轮范围的定时器均按时触发，不提前
+TEST(TimerWheelTest, Cascade) {
+    TimerWheel wheel;
+    TimeStamp base = Clock::now();
+    const int timeouts[] = {0, 70, 5000, 300000, 3600000, 20 * 3600000};
+    TimerNode nodes[6];
+    bool fired[6] = {false};
+    for (int i = 0; i < 6; ++i) {
+        nodes[i].id = i;
+        nodes[i].callback = [&fired, i]() { fired[i] = true; };
+        wheel.AddTimer(&nodes[i], timeouts[i]);
+    }
+    for (int i = 0; i < 6; ++i) {
+        if (timeouts[i] > 0) {
+            wheel.Expire(base + MS(timeouts[i] - 1));
+            EXPECT_FALSE(fired[i]) << timeouts[i];
+        }
+        wheel.Expire(base + MS(timeouts[i] + 20));
+        for (int j = 0; j < 6; ++j) {
+            EXPECT_EQ(fired[j], j <= i) << timeouts[i] << " " << timeouts[j];
+        }
+    }
+    EXPECT_EQ(wheel.Size(), 0u);
+}
+
+// 随机定时器与随机推进步长，检查每个定时器在到期后的第一次推进中触发
+TEST(TimerWheelTest, RandomExpire) {
+    const int n = 20000;
+    TimerWheel wheel;
+    TimeStamp base = Clock::now();
+    std::mt19937 rng(12345);
+    std::vector<int> timeouts(n);
+    std::unique_ptr<TimerNode[]> nodes(new TimerNode[n]);
+    int64_t prev_ms = -1, now_ms = 0;
+    int fired = 0;
+    for (int i = 0; i < n; ++i) {
+        timeouts[i] = rng() % 600000;
+        nodes[i].id = i;
+        nodes[i].callback = [&, i]() {
+            ++fired;
+            EXPECT_GE(now_ms, timeouts[i]) << i;
+            EXPECT_LT(prev_ms, timeouts[i] + 20) << i;
+        };
+        wheel.AddTimer(&nodes[i], timeouts[i]);
+    }
+    // 部分定时器在推进过程中被推迟或删除
+    for (int i = 0; i < n; i += 10) {
+        wheel.DeleteTimer(&nodes[i]);
+    }
+    while (wheel.Size() > 0) {
+        prev_ms = now_ms;
+        now_ms += rng() % 3000 + 1;
+        wheel.Expire(base + MS(now_ms));
+    }
+    EXPECT_EQ(fired, n - n / 10);
+}
+
+TEST(TimerWheelTest, CallbackModifyTimers) {
+    TimerWheel wheel;
+    TimeStamp base = Clock::now();
+    TimerNode a, b, c;
+    int a_cnt = 0, b_cnt = 0, c_cnt = 0;
+    // a在回调中删除同一tick到期的b，并重新添加自身
+    a.callback = [&]() {
+        ++a_cnt;
+        wheel.DeleteTimer(&b);
+        if (a_cnt == 1) wheel.AddTimer(&a, 0);
+    };
+    b.callback = [&]() { ++b_cnt; };
+    c.callback = [&]() { ++c_cnt; };
+    wheel.AddTimer(&a, 10);
+    wheel.AddTimer(&b, 10);
+    wheel.AddTimer(&c, 10);
+    wheel.Expire(base + MS(40));
+    EXPECT_EQ(b_cnt, 0);
+    EXPECT_EQ(c_cnt, 1);
+    wheel.CleanExpiredTimer();
+    EXPECT_EQ(a_cnt, 2);
+    EXPECT_EQ(wheel.Size(), 0u);
+    EXPECT_EQ(wheel.GetNextExpireTime(), -1);
+}
+
+static void BenchTimer(TIMER_TYPE type, int n) {
+    std::unique_ptr<TimerQueue> timer = CreateTimerQueue(type);
+    std::unique_ptr<TimerNode[]> nodes(new TimerNode[n]);
+    std::mt19937 rng(n);
+    std::vector<int> timeouts(n);
+    for (int i = 0; i < n; ++i) {
+        nodes[i].id = i;
+        nodes[i].callback = []() {};
+        timeouts[i] = 30000 + rng() % 60000;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        timer->AddTimer(&nodes[i], timeouts[i]);
+    }
+    auto added = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        int idx = rng() % n;
+        timer->UpdateTimer(&nodes[idx], timeouts[idx] + 1000);
+    }
+    auto updated = std::chrono::steady_clock::now();
+    for (int i = 0; i < n; ++i) {
+        timer->DeleteTimer(&nodes[i]);
+    }
+    auto deleted = std::chrono::steady_clock::now();
+
+    auto ns = [n](auto d) { return std::chrono::duration<double, std::nano>(d).count() / n; };
+    std::cout << "[ BENCH    ] " << timer->GetName()
+              << ": timers " << n
+              << ", add " << ns(added - start) << " ns"
+              << ", update " << ns(updated - added) << " ns"
+              << ", delete " << ns(deleted - updated) << " ns" << std::endl;
+    EXPECT_EQ(timer->Size(), 0u);
+}
+
+TEST(TimerBench, AddUpdateDelete) {
+    for (int n : {10000, 100000, 1000000}) {
+        BenchTimer(TIMER_TYPE::HEAP, n);
+        BenchTimer(TIMER_TYPE::WHEEL, n);
+    }
+}
+
 int main(int argc, char **argv) {
     Log::GetLogInstance().Init(3, true, 10, 30);
     ::testing::InitGoogleTest(&argc, argv);
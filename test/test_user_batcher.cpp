@@ -0,0 +1,121 @@
+/**
+ * @file test_user_batcher.cpp
+ * @author chenyinjie
+ * @date 2024-11-06
+ */
+
+#include "../src/pool/user_batcher.h"
+
+#include <gtest/gtest.h>
+#include <condition_variable>
+
+// 等待回调执行的辅助类
+class Waiter {
+public:
+    void Done(int id, bool is_verified) {
+        std::lock_guard<std::mutex> locker(mtx_);
+        results_[id] = is_verified;
+        cond_.notify_all();
+    }
+
+    bool Wait(size_t cnt, int timeout_ms = 3000) {
+        std::unique_lock<std::mutex> locker(mtx_);
+        return cond_.wait_for(locker, MS(timeout_ms), [&]() { return results_.size() >= cnt; });
+    }
+
+    bool Get(int id) {
+        std::lock_guard<std::mutex> locker(mtx_);
+        return results_[id];
+    }
+
+private:
+    std::mutex mtx_;
+    std::condition_variable cond_;
+    std::unordered_map<int, bool> results_;
+};
+
+static std::string UniqueName(const std::string& prefix) {
+    return prefix + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+}
+
+// 测试批量查询与多行插入语句的生成
+TEST(UserBatcherTest, BuildSQL) {
+    EXPECT_EQ(UserBatcher::BuildLookupSQL({"ab", "c"}),
+              "SELECT k.idx, u.password FROM (SELECT 0 AS idx, CONVERT(X'6162' USING utf8mb4) AS name "
+              "UNION ALL SELECT 1, CONVERT(X'63' USING utf8mb4)) AS k JOIN user AS u ON u.username = k.name");
+    EXPECT_EQ(UserBatcher::BuildInsertSQL({{"ab", "01"}, {"c", "ff"}}),
+              "INSERT INTO user(username, password) VALUES "
+              "(CONVERT(X'6162' USING utf8mb4), CONVERT(X'3031' USING utf8mb4)), "
+              "(CONVERT(X'63' USING utf8mb4), CONVERT(X'6666' USING utf8mb4))");
+}
+
+// 测试并发注册合并为少量批次，每个请求得到各自的结果
+TEST(UserBatcherTest, RegisterAndLogin) {
+    auto pool = std::make_unique<AsyncSQLPool>("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 2);
+    UserBatcher batcher(pool.get(), 16, 2000);
+    const int N = 40;
+    std::string prefix = UniqueName("batch_");
+
+    Waiter registered;
+    for (int i = 0; i < N; ++i) {
+        ASSERT_TRUE(batcher.Register(prefix + "_" + std::to_string(i), "hash" + std::to_string(i),
+                                     [&, i](bool is_verified) { registered.Done(i, is_verified); }));
+    }
+    // 批内重复的用户名只有第一个注册成功
+    ASSERT_TRUE(batcher.Register(prefix + "_0", "hash", [&](bool is_verified) { registered.Done(N, is_verified); }));
+    ASSERT_TRUE(registered.Wait(N + 1));
+    for (int i = 0; i < N; ++i) {
+        EXPECT_TRUE(registered.Get(i)) << i;
+    }
+    EXPECT_FALSE(registered.Get(N));
+
+    // 已存在的用户名注册失败
+    Waiter again;
+    ASSERT_TRUE(batcher.Register(prefix + "_1", "hash1", [&](bool is_verified) { again.Done(0, is_verified); }));
+    ASSERT_TRUE(again.Wait(1));
+    EXPECT_FALSE(again.Get(0));
+
+    // 密码正确、错误与用户不存在的登录混在同一批中
+    Waiter login;
+    for (int i = 0; i < N; ++i) {
+        std::string hash = (i % 2 == 0) ? "hash" + std::to_string(i) : "wrong";
+        ASSERT_TRUE(batcher.Login(prefix + "_" + std::to_string(i), hash,
+                                  [&, i](bool is_verified) { login.Done(i, is_verified); }));
+    }
+    ASSERT_TRUE(batcher.Login(prefix + "_none", "hash0", [&](bool is_verified) { login.Done(N, is_verified); }));
+    ASSERT_TRUE(login.Wait(N + 1));
+    for (int i = 0; i < N; ++i) {
+        EXPECT_EQ(login.Get(i), i % 2 == 0) << i;
+    }
+    EXPECT_FALSE(login.Get(N));
+    EXPECT_LT(batcher.GetBatchNums(), static_cast<uint64_t>(N));
+    EXPECT_EQ(batcher.GetRequestNums(), static_cast<uint64_t>(2 * N + 3));
+
+    // 先停止合并器，再销毁异步查询池
+    batcher.Stop();
+    pool.reset();
+}
+
+// 测试停止后等待中的请求以失败回调，且不再接受新请求
+TEST(UserBatcherTest, Stop) {
+    auto pool = std::make_unique<AsyncSQLPool>("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 1);
+    UserBatcher batcher(pool.get(), 4, 1000, 8);
+    Waiter waiter;
+    int accepted = 0;
+    for (int i = 0; i < 20; ++i) {
+        if (batcher.Login("nobody", "hash", [&, i](bool is_verified) { waiter.Done(i, is_verified); })) {
+            ++accepted;
+        }
+    }
+    EXPECT_LT(accepted, 20);
+    batcher.Stop();
+    EXPECT_FALSE(batcher.Login("nobody", "hash", [](bool) {}));
+    pool.reset();
+    ASSERT_TRUE(waiter.Wait(accepted));
+}
+
+int main(int argc, char** argv) {
+    Log::GetLogInstance().Init(10, true, 128, 30);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,188 @@
+/**
+ * @file test_user_store.cpp
+ * @author chenyinjie
+ * @date 2024-11-08
+ */
+
+#include "../src/store/user_store.h"
+#include "../src/store/mmap_user_store.h"
+#include "../src/store/mysql_user_store.h"
+
+#include <gtest/gtest.h>
+#include <fstream>
+#include <thread>
+
+static const std::string STORE_DIR = "test_user_store_resources";
+
+// 由序号生成64位十六进制的密码哈希
+static std::string HashOf(int i) {
+    char buf[65];
+    for (int k = 0; k < 8; ++k) {
+        snprintf(buf + k * 8, 9, "%08x", i * 2654435761U + k);
+    }
+    return std::string(buf, 64);
+}
+
+class MmapUserStoreTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::filesystem::remove_all(STORE_DIR);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(STORE_DIR);
+    }
+};
+
+// 测试注册、重复注册与登录，非法的用户名与密码哈希被拒绝
+TEST_F(MmapUserStoreTest, RegisterAndLogin) {
+    auto store = CreateUserStore(USER_STORE::MMAP, STORE_DIR);
+    EXPECT_STREQ(store->GetName(), "mmap");
+
+    EXPECT_TRUE(store->Register("alice", HashOf(1)));
+    EXPECT_FALSE(store->Register("alice", HashOf(2)));
+    EXPECT_TRUE(store->Register("Alice", HashOf(2)));
+
+    EXPECT_TRUE(store->Login("alice", HashOf(1)));
+    EXPECT_FALSE(store->Login("alice", HashOf(2)));
+    EXPECT_TRUE(store->Login("Alice", HashOf(2)));
+    EXPECT_FALSE(store->Login("bob", HashOf(1)));
+
+    EXPECT_FALSE(store->Register("", HashOf(3)));
+    EXPECT_FALSE(store->Register(std::string(MmapUserStore::MAX_NAME_LEN + 1, 'x'), HashOf(3)));
+    EXPECT_TRUE(store->Register(std::string(MmapUserStore::MAX_NAME_LEN, 'x'), HashOf(3)));
+    EXPECT_FALSE(store->Register("carol", "123456"));
+    EXPECT_FALSE(store->Register("carol", std::string(64, 'g')));
+    EXPECT_FALSE(store->Login("alice", ""));
+}
+
+// 测试正常关闭后重新打开，数据不丢失
+TEST_F(MmapUserStoreTest, Reopen) {
+    {
+        MmapUserStore store(STORE_DIR);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(store.Register("user" + std::to_string(i), HashOf(i)));
+        }
+    }
+    MmapUserStore store(STORE_DIR);
+    EXPECT_EQ(store.GetUserNums(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(store.Login("user" + std::to_string(i), HashOf(i))) << i;
+    }
+    EXPECT_FALSE(store.Register("user0", HashOf(0)));
+}
+
+// 测试装载因子超过0.7时扩容，扩容后数据完整
+TEST_F(MmapUserStoreTest, Grow) {
+    MmapUserStore store(STORE_DIR, 16);
+    EXPECT_EQ(store.GetCapacity(), 16u);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_TRUE(store.Register("user" + std::to_string(i), HashOf(i)));
+    }
+    EXPECT_EQ(store.GetUserNums(), 1000u);
+    EXPECT_GE(store.GetCapacity() * 7, 1000u * 10);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(store.Login("user" + std::to_string(i), HashOf(i))) << i;
+    }
+    EXPECT_FALSE(std::filesystem::exists(std::filesystem::path(STORE_DIR) / "users.tbl.tmp"));
+}
+
+// 测试哈希表未正常关闭或丢失时由日志重建
+TEST_F(MmapUserStoreTest, RebuildFromJournal) {
+    {
+        MmapUserStore store(STORE_DIR, 16);
+        for (int i = 0; i < 50; ++i) {
+            ASSERT_TRUE(store.Register("user" + std::to_string(i), HashOf(i)));
+        }
+    }
+    // 清除完整标记，模拟进程崩溃
+    {
+        std::fstream file(std::filesystem::path(STORE_DIR) / "users.tbl", std::ios::in | std::ios::out | std::ios::binary);
+        uint32_t is_clean = 0;
+        file.seekp(12);
+        file.write(reinterpret_cast<const char*>(&is_clean), sizeof(is_clean));
+    }
+    {
+        MmapUserStore store(STORE_DIR, 16);
+        EXPECT_EQ(store.GetUserNums(), 50u);
+        EXPECT_TRUE(store.Login("user49", HashOf(49)));
+    }
+
+    std::filesystem::remove(std::filesystem::path(STORE_DIR) / "users.tbl");
+    MmapUserStore store(STORE_DIR, 16);
+    EXPECT_EQ(store.GetUserNums(), 50u);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_TRUE(store.Login("user" + std::to_string(i), HashOf(i))) << i;
+    }
+}
+
+// 测试日志尾部写入不完整时截断，之后的注册正常追加
+TEST_F(MmapUserStoreTest, BrokenJournalTail) {
+    {
+        MmapUserStore store(STORE_DIR);
+        ASSERT_TRUE(store.Register("alice", HashOf(1)));
+        ASSERT_TRUE(store.Register("bob", HashOf(2)));
+    }
+    std::filesystem::path journal = std::filesystem::path(STORE_DIR) / "users.journal";
+    uintmax_t size = std::filesystem::file_size(journal);
+    std::filesystem::resize_file(journal, size - 10);
+    std::filesystem::remove(std::filesystem::path(STORE_DIR) / "users.tbl");
+    {
+        MmapUserStore store(STORE_DIR);
+        EXPECT_EQ(store.GetUserNums(), 1u);
+        EXPECT_TRUE(store.Login("alice", HashOf(1)));
+        EXPECT_FALSE(store.Login("bob", HashOf(2)));
+        EXPECT_TRUE(store.Register("carol", HashOf(3)));
+    }
+    MmapUserStore store(STORE_DIR);
+    EXPECT_EQ(store.GetUserNums(), 2u);
+    EXPECT_TRUE(store.Login("carol", HashOf(3)));
+}
+
+// 测试多线程并发注册与登录
+TEST_F(MmapUserStoreTest, Concurrent) {
+    MmapUserStore store(STORE_DIR, 16);
+    const int THREAD_NUMS = 4;
+    const int USER_NUMS = 500;
+    std::vector<std::thread> threads;
+    std::atomic<int> failed{0};
+    for (int t = 0; t < THREAD_NUMS; ++t) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < USER_NUMS; ++i) {
+                int id = t * USER_NUMS + i;
+                std::string name = "user" + std::to_string(id);
+                if (!store.Register(name, HashOf(id)) || !store.Login(name, HashOf(id))) {
+                    ++failed;
+                }
+                // 所有线程竞争同一个用户名，只有一个成功
+                store.Register("shared" + std::to_string(i), HashOf(t));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failed.load(), 0);
+    EXPECT_EQ(store.GetUserNums(), static_cast<size_t>(THREAD_NUMS * USER_NUMS + USER_NUMS));
+}
+
+// 测试MySQL用户存储
+TEST(MySQLUserStoreTest, RegisterAndLogin) {
+    SQLConnectPool::GetSQLConnectPoolInstance()->Init("localhost", "chenyinjie", "MySQL123456.", "WebServer", 3306, 2);
+    auto store = CreateUserStore(USER_STORE::MYSQL);
+    EXPECT_STREQ(store->GetName(), "mysql");
+
+    std::string name = "store_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    EXPECT_TRUE(store->Register(name, HashOf(1)));
+    EXPECT_FALSE(store->Register(name, HashOf(2)));
+    EXPECT_TRUE(store->Login(name, HashOf(1)));
+    EXPECT_FALSE(store->Login(name, HashOf(2)));
+    EXPECT_FALSE(store->Login(name + "_none", HashOf(1)));
+    SQLConnectPool::GetSQLConnectPoolInstance()->CloseConnectPool();
+}
+
+int main(int argc, char** argv) {
+    Log::GetLogInstance().Init(10, true, 128, 30);
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}